@@ -1,95 +1,203 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "batch_aux.h"
 
 
+/* Klasy znaków rozpoznawane przez parse_span */
+enum char_class {
+    OTHER = 0, SPACE, DIGIT, HASH, COMMAND
+};
+
+
+/* Klasa każdego znaku, białe znaki jak w isspace (bez '\n') */
+static const unsigned char char_class[256] = {
+    [' '] = SPACE, ['\t'] = SPACE, ['\v'] = SPACE,
+    ['\f'] = SPACE, ['\r'] = SPACE,
+    ['0'] = DIGIT, ['1'] = DIGIT, ['2'] = DIGIT, ['3'] = DIGIT,
+    ['4'] = DIGIT, ['5'] = DIGIT, ['6'] = DIGIT, ['7'] = DIGIT,
+    ['8'] = DIGIT, ['9'] = DIGIT,
+    ['#'] = HASH,
+    ['B'] = COMMAND, ['I'] = COMMAND, ['m'] = COMMAND, ['g'] = COMMAND,
+    ['b'] = COMMAND, ['f'] = COMMAND, ['q'] = COMMAND, ['p'] = COMMAND,
+    ['d'] = COMMAND
+};
+
+
+void write_err(output_t *err, uint32_t line) {
+    output_write(err, "ERROR ", 6);
+    output_uint(err, line);
+    output_char(err, '\n');
+}
+
+
 void print_err(uint32_t line) {
-    fprintf(stderr, "ERROR %d\n", line);
+    write_err(&std_err, line);
 }
 
 
-void whitespace(uint32_t line, uint32_t instructions[],
-                bool *ignore, parameter *p, char game_params[],
-                int *g_iter, int *i_iter) {
-    if (*g_iter <= 0) {
-        if (*p != E)
-            *g_iter = 0;
+/* Odrzuca bieżącą linię zgłaszając błąd */
+static inline void reject(line_parser_t *lp) {
+    lp->ignore = true;
+    lp->p = E;
+    lp->errors++;
+}
 
-        return;
-    }
 
-    uint64_t temp = strtoull(game_params, NULL, 0);
-    memset(game_params, ' ', MAX_GAME_PARAM_LEN * sizeof(char));
-
-    if (temp > UINT32_MAX) {
-        *ignore = true;
-        *p = E;
-        print_err(line);
-    } else if (*g_iter > 0) {
-        instructions[*i_iter] = (uint32_t) temp;
-        (*i_iter)++;
-        *g_iter = 0;
-    }
+/* Resetuje stan analizy przed nową linią */
+static inline void new_line(line_parser_t *lp) {
+    lp->number = 0;
+    lp->p = E;
+    lp->i_iter = -1;
+    lp->g_iter = -1;
+    lp->errors = 0;
+    lp->leading_zero = false;
+    lp->ignore = false;
+    lp->empty_line = true;
 }
 
 
-void new_line(uint32_t *line, bool *processed, uint32_t instructions[],
-              bool *ignore, parameter *p, char game_params[],
-              int *g_iter, int *i_iter, bool empty_line) {
-    whitespace(*line, instructions, ignore, p, game_params,
-               g_iter, i_iter);
+void parser_init(line_parser_t *lp) {
+    memset(lp->instructions, 0,
+           (MAX_INSTRUCTIONS_INDEX + 1) * sizeof(uint32_t));
+    new_line(lp);
+}
 
-    if (!(*ignore) && *p != E) {
-        *processed = true;
+
+/* Przepisuje wczytaną liczbę do tablicy instrukcji.
+ * Liczba jest przepisywana również w odrzuconej linii, więc zbyt duża
+ * wartość może spowodować kolejny komunikat o błędzie. */
+static inline void whitespace(line_parser_t *lp) {
+    if (lp->g_iter <= 0) {
+        if (lp->p != E)
+            lp->g_iter = 0;
+    } else if (lp->number > UINT32_MAX) {
+        reject(lp);
+        lp->g_iter = 0;
+        lp->number = 0;
     } else {
-        if (!(*ignore) && !empty_line)
-            print_err(*line);
-        memset(instructions, 0, (MAX_INSTRUCTIONS_INDEX + 1) * sizeof(uint32_t));
-        *p = E;
+        lp->instructions[lp->i_iter] = (uint32_t) lp->number;
+        lp->i_iter++;
+        lp->g_iter = 0;
+        lp->number = 0;
     }
-
-    (*line)++;
-    *ignore = false;
-    *g_iter = -1;
 }
 
 
-void hash(uint32_t line, bool *ignore, int g_iter,
-          int i_iter, parameter *p) {
-    if (i_iter != -1 || g_iter > 0)
-        print_err(line);
+/* Wczytuje ciąg cyfr o długości run, zwraca liczbę przetworzonych znaków */
+static inline size_t digits(line_parser_t *lp, const char *s, size_t run) {
+    size_t take = run;
+    bool fail = false;
 
-    *p = E;
-    *ignore = true;
-}
+    if (lp->g_iter < 0 || lp->i_iter < 0
+        || lp->i_iter > MAX_INSTRUCTIONS_INDEX
+        || (lp->g_iter > 0 && lp->leading_zero)) {
+        reject(lp);
+        return run;
+    }
 
+    if (lp->g_iter == 0) {
+        lp->leading_zero = (s[0] == '0');
+        if (lp->leading_zero && run > 1) {
+            take = 1;
+            fail = true;
+        }
+    }
 
-void digit(uint32_t line, int input, bool *ignore, parameter *p,
-           char game_params[], int *g_iter, int i_iter) {
-    if (0 <= *g_iter && *g_iter < MAX_GAME_PARAM_LEN
-        && 0 <= i_iter && i_iter <= MAX_INSTRUCTIONS_INDEX
-        && !(*g_iter > 0 && game_params[0] == '0')) {
-        game_params[*g_iter] = (char) input;
-        (*g_iter)++;
-    } else {
-        *ignore = true;
-        *p = E;
-        print_err(line);
+    if (lp->g_iter + take > MAX_GAME_PARAM_LEN) {
+        take = MAX_GAME_PARAM_LEN - lp->g_iter;
+        fail = true;
     }
+
+    uint64_t number = lp->number;
+    for (size_t i = 0; i < take; i++)
+        number = number * 10 + (uint64_t) (s[i] - '0');
+
+    lp->number = number;
+    lp->g_iter += (int) take;
+
+    if (fail)
+        reject(lp);
+
+    return run;
 }
 
 
-void non_digit(uint32_t line, int input, bool *ignore,
-               parameter *p, int g_iter, int *i_iter) {
-    if (g_iter == -1 && *i_iter == -1
-        && correct_parameter(input)) {
-        *p = char_to_param(input);
+void parse_span(line_parser_t *lp, const char *s, size_t len) {
+    size_t i = 0;
+
+    while (i < len && !lp->ignore) {
+        unsigned char c = (unsigned char) s[i];
+        size_t run;
+
+        switch (char_class[c]) {
+            case SPACE:
+                if (lp->empty_line)
+                    reject(lp);
+                else
+                    whitespace(lp);
+                i++;
+                break;
+            case DIGIT:
+                run = 1;
+                while (i + run < len
+                       && char_class[(unsigned char) s[i + run]] == DIGIT)
+                    run++;
+                i += digits(lp, s + i, run);
+                break;
+            case HASH:
+                if (lp->i_iter != -1 || lp->g_iter > 0)
+                    lp->errors++;
+                lp->p = E;
+                lp->ignore = true;
+                i++;
+                break;
+            case COMMAND:
+                if (lp->g_iter == -1 && lp->i_iter == -1) {
+                    lp->p = char_to_param(c);
+                    lp->i_iter++;
+                } else {
+                    reject(lp);
+                }
+                i++;
+                break;
+            default:
+                reject(lp);
+                i++;
+                break;
+        }
+
+        lp->empty_line = false;
+    }
 
-        (*i_iter)++;
-    } else {
-        *ignore = true;
-        *p = E;
-        print_err(line);
+    if (len > 0)
+        lp->empty_line = false;
+}
+
+
+bool parse_end(line_parser_t *lp, bool eol, parameter *p, int *count,
+               int *errors) {
+    bool processed = false;
+
+    if (eol) {
+        whitespace(lp);
+        if (!lp->ignore && lp->p != E) {
+            processed = true;
+        } else {
+            if (!lp->ignore && !lp->empty_line)
+                lp->errors++;
+            memset(lp->instructions, 0,
+                   (MAX_INSTRUCTIONS_INDEX + 1) * sizeof(uint32_t));
+            lp->p = E;
+        }
+    } else if (!lp->ignore && !lp->empty_line) {
+        lp->errors++;
+        lp->p = E;
     }
+
+    *p = lp->p;
+    *count = lp->i_iter;
+    *errors = lp->errors;
+    new_line(lp);
+
+    return processed;
 }
@@ -10,9 +10,11 @@
 #ifndef GAMMA_BATCH_AUX_H
 #define GAMMA_BATCH_AUX_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "parameter_gamma.h"
+#include "output_buffer.h"
 
 
 /**
@@ -27,92 +29,69 @@
 #define MAX_INSTRUCTIONS_INDEX 3
 
 
-/** @brief Wypisuje wiadomość o błędzie na stderr.
+/**
+ * Stan analizy bieżącej linii wejścia.
+ * Linia może być podawana w wielu fragmentach, dzięki czemu liczby
+ * i instrukcje mogą być rozdzielone granicą bufora wejścia.
+ */
+typedef struct line_parser {
+    /** tablica instrukcji, zerowana tylko po błędnej linii */
+    uint32_t instructions[MAX_INSTRUCTIONS_INDEX + 1];
+    uint64_t number; /**< wartość wczytywanej liczby */
+    parameter p; /**< parametr wczytywanej instrukcji */
+    int i_iter; /**< liczba wczytanych liczb, @p -1 przed parametrem */
+    int g_iter; /**< liczba cyfr wczytywanej liczby, @p -1 przed spacją */
+    int errors; /**< liczba błędów do zgłoszenia w bieżącej linii */
+    bool leading_zero; /**< czy wczytywana liczba zaczyna się od zera */
+    bool ignore; /**< czy pozostałe znaki linii należy pominąć */
+    bool empty_line; /**< czy nie wczytano jeszcze żadnego znaku linii */
+} line_parser_t;
+
+
+/** @brief Wypisuje wiadomość o błędzie do bufora @ref std_err.
  * @param[in] line – numer linii, w której występił błąd.
  */
 void print_err(uint32_t line);
 
 
-/** @brief Wykonuje reakcje na biały znak różny od końca linii.
- *  Jeżeli jest to pierwszy biały znak po ciągu cyfr to przepisuje liczbę
- *  do tablicy instrukcji sprawdzając jej poprawność.
- *  Po znaku nie będącym cyfrą, a poprawnym parametrem instrukcji jedynie
- *  przesuwa wskaźnik @p g_iter.
- * @param[in] line                 – numer bieżącej linii,
- * @param[in, out]  instructions   – tablica instrukcji,
- * @param[in, out]  ignore         – wskazuje czy należy analizować znak,
- * @param[in, out]  p              – parametr wczytywanej instrukcji,
- * @param[in, out]  game_params    – string trzymający wczytywany parametr,
- * @param[in, out]  g_iter         – iterator po tablicy z parametrem,
- * @param[in, out]  i_iter         – iterator po tablicy instrukcji.
+/** @brief Wypisuje wiadomość o błędzie do bufora.
+ * @param[in, out] err – bufor na komunikaty o błędach,
+ * @param[in] line     – numer linii, w której występił błąd.
  */
-void whitespace(uint32_t line, uint32_t instructions[],
-                bool *ignore, parameter *p, char game_params[],
-                int *g_iter, int *i_iter);
-
-
-/** @brief Wykonuje operacje związane z natrafieniem na znak nowej linii.
- * Sprawdza poprawność wczytanej do tej pory isntrukcji, ustawiając @p processed
- * na @p true jeżeli była poprawna. W przeciwnym przypadku jedynie resetuje
- * wszystkie parametry instruckcji.
- * Zawsze zwiększa @p line.
- * @param[in, out]  line           – numer bieżącej linii,
- * @param[in, out]  processed      – wskazuje czy instrukcja jest poprawna,
- * @param[in, out]  instructions   – tablica instrukcji,
- * @param[in, out]  ignore         – wskazuje czy należy analizować znak,
- * @param[in, out]  p              – parametr wczytywanej instrukcji,
- * @param[in, out]  game_params    – string trzymający wczytywany parametr,
- * @param[in, out]  g_iter         – iterator po tablicy z parametrem,
- * @param[in, out]  i_iter         – iterator po tablicy instrukcji,
- * @param[in] empty_line           - wskazuje czy linie była do tej pory pusta.
- */
-void new_line(uint32_t *line, bool *processed, uint32_t instructions[],
-              bool *ignore, parameter *p, char game_params[],
-              int *g_iter, int *i_iter, bool empty_line);
-
-
-/** @brief Wykonuje operacje związane z natrafieniem na znak komentarza.
- * Jeżeli @p # jest pierwszym znakiem linii, ustawia @p ignore na @p true,
- * w przeciwnym wypadku dodatkowo wypisuje komunikat o błędzie.
- * @param[in] line                 – numer bieżącej linii,
- * @param[in, out]  ignore         – wskazuje czy należy analizować znak,
- * @param[in, out]  g_iter         – iterator po tablicy z parametrem,
- * @param[in, out]  i_iter         – iterator po tablicy instrukcji,
- * @param[in, out]  p              – parametr wczytywanej instrukcji.
+void write_err(output_t *err, uint32_t line);
+
+
+/** @brief Inicjalizuje stan analizy linii.
+ * @param[out] lp – inicjalizowany stan.
  */
-void hash(uint32_t line, bool *ignore, int g_iter,
-          int i_iter, parameter *p);
-
-
-/** @brief Wykonuje operacje związane z natrafieniem na cyfrę.
- * Dopisuje wczytaną cyfrę do wczytywanego parametru. Jeżeli liczba
- * przekroczyłaby @ref MAX_GAME_PARAM_LEN ustawia @p ignore na true
- * i wypisuje komuniakt o błędzie.
- * @param[in] line                 – numer bieżącej linii,
- * @param[in] input                – aktualnie przetważany znak,
- * @param[in, out]  ignore         – wskazuje czy należy analizować znak,
- * @param[in, out]  p              – parametr wczytywanej instrukcji,
- * @param[in, out]  game_params    – string trzymający wczytywany parametr,
- * @param[in, out]  g_iter         – iterator po tablicy z parametrem,
- * @param[in, out]  i_iter         – iterator po tablicy instrukcji.
+void parser_init(line_parser_t *lp);
+
+
+/** @brief Analizuje fragment linii.
+ * Fragment nie może zawierać znaku nowej linii. Cyfry wczytywane są
+ * całymi ciągami, a błędy są jedynie zliczane w polu @p errors.
+ * @param[in, out] lp   – stan analizy bieżącej linii,
+ * @param[in] s         – początek fragmentu,
+ * @param[in] len       – długość fragmentu.
  */
-void digit(uint32_t line, int input, bool *ignore, parameter *p,
-           char game_params[], int *g_iter, int i_iter);
-
-
-/** @brief Wykonuje operacje związane z natrafieniem na niebiałą nie cyfrę.
- * Jeżeli podany znak jest poprawnym parametrem instrukcji to ustwia nań
- * wartość @p p, w przeciwnym wypadku ustawia @p ignore na true, ustawia
- * @p p na @p E oraz wypisuje komunikat o błędzie.
- * @param[in] line                 – numer bieżącej linii,
- * @param[in] input                – aktualnie przetważany znak,
- * @param[in, out]  ignore         – wskazuje czy należy analizować znak,
- * @param[in, out]  p              – parametr wczytywanej instrukcji,
- * @param[in, out]  g_iter         – iterator po tablicy z parametrem,
- * @param[in, out]  i_iter         – iterator po tablicy instrukcji.
+void parse_span(line_parser_t *lp, const char *s, size_t len);
+
+
+/** @brief Kończy analizę linii.
+ * Przepisuje ostatnią liczbę do tablicy instrukcji i sprawdza poprawność
+ * wczytanej instrukcji. Linia niezakończona znakiem nowej linii jest zawsze
+ * błędna, o ile nie jest pusta lub nie została już odrzucona.
+ * Przygotowuje @p lp do analizy kolejnej linii.
+ * @param[in, out] lp   – stan analizy bieżącej linii,
+ * @param[in] eol       – czy linia zakończyła się znakiem nowej linii,
+ * @param[out] p        – parametr wczytanej instrukcji,
+ * @param[out] count    – liczba wczytanych liczb,
+ * @param[out] errors   – liczba komunikatów o błędzie do wypisania.
+ * @return Wartość @p true jeżeli instrukcja była poprawna składniowo,
+ * @p false w przeciwnym wypadku.
  */
-void non_digit(uint32_t line, int input, bool *ignore,
-               parameter *p, int g_iter, int *i_iter);
+bool parse_end(line_parser_t *lp, bool eol, parameter *p, int *count,
+               int *errors);
 
 
 #endif /* GAMMA_BATCH_AUX_H */
@@ -1,10 +1,10 @@
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
-#include <ctype.h>
 #include "batch_mode.h"
 #include "parameter_gamma.h"
 #include "batch_aux.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
 
 
 /* Sprawdza czy w tablicy występuje element równy zero */
@@ -18,141 +18,221 @@ static inline bool any_is_zero(const uint32_t tab[], int max) {
 }
 
 
-/* Przetwarza pojedyczny znak wejścia */
-static bool parse(int input, bool *processed, uint32_t *line,
-                  uint32_t instructions[], bool *ignore, parameter *p,
-                  char game_params[], int *g_iter, int *i_iter, bool empty_line) {
-    if (input == '\n') {
-        new_line(line, processed, instructions, ignore, p,
-                 game_params, g_iter, i_iter, empty_line);
-    } else if (*ignore) {
-    } else if (isspace(input) != 0) {
-        if (empty_line) { /* wykomenotwanie tego ifa pozwoli na akceptowanie */
-            *ignore = true; /* poleceń po serii białych znaków w wierszu*/
-            print_err(*line);
-        }
-        whitespace(*line, instructions, ignore, p, game_params, g_iter, i_iter);
-    } else if (input == '#') {
-        hash(*line, ignore, *g_iter, *i_iter, p);
-    } else if (isdigit(input) != 0) {
-        digit(*line, input, ignore, p, game_params, g_iter, *i_iter);
-    } else {
-        non_digit(*line, input, ignore, p, *g_iter, i_iter);
+/* Wypisuje komunikaty o błędach zgłoszonych w linii */
+static inline void print_errors(output_t *err, uint32_t line, int errors) {
+    for (int i = 0; i < errors; i++)
+        write_err(err, line);
+}
+
+
+bool end_first_line(line_parser_t *lp, bool eol, uint32_t *line,
+                    parameter *p, output_t *err) {
+    bool processed;
+    int count, errors;
+
+    processed = parse_end(lp, eol, p, &count, &errors);
+    print_errors(err, *line, errors);
+
+    if (!eol) {
+        *p = E;
+        return false;
+    }
+
+    (*line)++;
+
+    if (processed
+        && (any_is_zero(lp->instructions, 4) || !(*p == B || *p == I))) {
+        write_err(err, *line - 1);
+        processed = false;
+        *p = E;
     }
 
-    return (input == '\n');
+    return processed;
 }
 
 
 enum parameter get_first_line(uint32_t *line, uint32_t instructions[4]) {
-    int input;
+    line_parser_t lp;
+    const char *span;
+    size_t len;
+    bool eol;
     bool processed = false;
-    bool ignore = false;
-    bool empty_line = true;
     enum parameter p = E;
-    char game_params[MAX_GAME_PARAM_LEN + 1];
-    int game_iter = -1;
-    int instructions_iter = -1;
-    memset(game_params, ' ', MAX_GAME_PARAM_LEN * sizeof(char));
-    game_params[MAX_GAME_PARAM_LEN] = '\0';
-    memset(instructions, 0, (MAX_INSTRUCTIONS_INDEX + 1) * sizeof(uint32_t));
-
-    while (!processed && (input = getc(stdin)) != EOF) {
-        empty_line = parse(input, &processed, line, instructions, &ignore, &p,
-                           game_params, &game_iter, &instructions_iter, empty_line);
-
-        if (empty_line) {
-            instructions_iter = -1;
-            if (processed
-                && (any_is_zero(instructions, 4) || !(p == B || p == I))) {
-                print_err(*line - 1);
-                processed = false;
-                p = E;
-            }
-        }
+
+    parser_init(&lp);
+
+    while (!processed && input_next_span(&span, &len, &eol)) {
+        parse_span(&lp, span, len);
+
+        if (eol)
+            processed = end_first_line(&lp, true, line, &p, &std_err);
     }
 
     /* Jeśli ostatni wiersz nie zakończył się '\n' */
-    if (!processed && !ignore && !empty_line) {
-        print_err(*line);
-        p = E;
+    if (!processed)
+        end_first_line(&lp, false, line, &p, &std_err);
 
-    }
+    memcpy(instructions, lp.instructions, 4 * sizeof(uint32_t));
 
     return p;
 }
 
 
-/* Funkcja interpretująca instrukcje dla gry w trybie wsadowym */
-static bool interpret(gamma_t *game, parameter par, uint32_t line,
-                      uint32_t instr[], int instr_count) {
-    bool a;
-    uint64_t c;
-    char *d;
-
-    if (par == m && instr_count == 3) {
-        a = gamma_move(game, instr[0], instr[1], instr[2]);
-        printf("%d\n", a);
-    } else if (par == g && instr_count == 3) {
-        a = gamma_golden_move(game, instr[0], instr[1], instr[2]);
-        printf("%d\n", a);
-    } else if (par == b && instr_count == 1) {
-        c = gamma_busy_fields(game, instr[0]);
-        printf("%ld\n", c);
-    } else if (par == f && instr_count == 1) {
-        c = gamma_free_fields(game, instr[0]);
-        printf("%ld\n", c);
-    } else if (par == q && instr_count == 1) {
-        a = gamma_golden_possible(game, instr[0]);
-        printf("%d\n", a);
-    } else if (par == p && instr_count == 0) {
-        d = gamma_board(game);
-        if (d != NULL) {
-            printf("%s", d);
-            free(d);
+void end_op(line_parser_t *lp, bool eol, uint32_t *line, batch_op_t *op) {
+    parameter p;
+    int count, errors;
+    bool processed = parse_end(lp, eol, &p, &count, &errors);
+
+    op->errors = (uint8_t) errors;
+    op->end = !eol;
+
+    if (eol) {
+        memcpy(op->args, lp->instructions, sizeof(op->args));
+        op->line = (*line)++;
+        op->count = (int8_t) count;
+        op->p = processed ? p : E;
+    } else {
+        op->line = *line;
+        op->count = -1;
+        op->p = E;
+    }
+}
+
+
+bool read_op(line_parser_t *lp, uint32_t *line, batch_op_t *op) {
+    const char *span;
+    size_t len;
+    bool eol;
+
+    while (input_next_span(&span, &len, &eol)) {
+        parse_span(lp, span, len);
+
+        if (eol) {
+            end_op(lp, true, line, op);
+            return true;
+        }
+    }
+
+    /* Jeśli ostatni wiersz nie zakończył się '\n' */
+    end_op(lp, false, line, op);
+
+    return false;
+}
+
+
+/* Ustawia wynik będący liczbą */
+static inline void set_value(batch_result_t *r, uint64_t value) {
+    r->kind = RESULT_VALUE;
+    r->value = value;
+}
+
+
+void execute_op(gamma_t *game, const batch_op_t *op, batch_result_t *r) {
+    const uint32_t *instr = op->args;
+    int count = op->count;
+
+    r->line = op->line;
+    r->errors = op->errors;
+    r->kind = RESULT_NONE;
+    r->end = op->end;
+
+    if (op->p == E)
+        return;
+
+    if (op->p == m && count == 3) {
+        set_value(r, gamma_move(game, instr[0], instr[1], instr[2]));
+    } else if (op->p == g && count == 3) {
+        set_value(r, gamma_golden_move(game, instr[0], instr[1], instr[2]));
+    } else if (op->p == b && count == 1) {
+        set_value(r, gamma_busy_fields(game, instr[0]));
+    } else if (op->p == f && count == 1) {
+        set_value(r, gamma_free_fields(game, instr[0]));
+    } else if (op->p == q && count == 1) {
+        set_value(r, gamma_golden_possible(game, instr[0]));
+    } else if (op->p == d && count == 0) {
+        if (gamma_diff(game, &r->changes, &r->value)) {
+            r->kind = RESULT_DIFF;
         } else {
-            print_err(line);
+            r->kind = RESULT_ERROR;
+            r->error_line = op->line;
+        }
+    } else if (op->p == p && count == 0) {
+        r->board = gamma_board(game);
+        if (r->board != NULL) {
+            r->kind = RESULT_BOARD;
+        } else {
+            r->kind = RESULT_ERROR;
+            r->error_line = op->line + 1;
         }
     } else {
-        return false;
+        r->kind = RESULT_ERROR;
+        r->error_line = op->line;
     }
-
-    return true;
 }
 
 
-void run_batch_mode(gamma_t *g, uint32_t *line) {
-    int input;
-    bool processed = false;
-    bool ignore = false;
-    bool empty_line = true;
-    enum parameter p = E;
-    char game_params[MAX_GAME_PARAM_LEN + 1];
-    int game_iter = -1;
-    uint32_t instructions[MAX_INSTRUCTIONS_INDEX + 1];
-    memset(game_params, ' ', MAX_GAME_PARAM_LEN * sizeof(char));
-    game_params[MAX_GAME_PARAM_LEN] = '\0';
-    int instructions_iter = -1;
-    memset(instructions, 0, (MAX_INSTRUCTIONS_INDEX + 1) * sizeof(uint32_t));
-    while ((input = getc(stdin)) != EOF) {
-        empty_line = parse(input, &processed, line, instructions, &ignore, &p,
-                           game_params, &game_iter, &instructions_iter, empty_line);
-
-        if (empty_line) {
-            if (processed) {
-                processed = interpret(g, p, *line, instructions,
-                                      instructions_iter);
-                if (!processed)
-                    print_err(*line - 1);
+void format_result(batch_result_t *r, output_t *out, output_t *err) {
+    for (int i = 0; i < r->errors; i++)
+        write_err(err, r->line);
+
+    switch (r->kind) {
+        case RESULT_VALUE:
+            output_uint(out, r->value);
+            output_char(out, '\n');
+            break;
+        case RESULT_BOARD:
+            output_str(out, r->board);
+            free(r->board);
+            r->board = NULL;
+            break;
+        case RESULT_DIFF:
+            output_uint(out, r->value);
+            output_char(out, '\n');
+            for (uint64_t i = 0; i < r->value; i++) {
+                output_uint(out, r->changes[i].x);
+                output_char(out, ' ');
+                output_uint(out, r->changes[i].y);
+                output_char(out, ' ');
+                output_uint(out, r->changes[i].owner);
+                output_char(out, '\n');
             }
-            processed = false;
-            instructions_iter = -1;
-            p = E;
-        }
+            free(r->changes);
+            r->changes = NULL;
+            break;
+        case RESULT_ERROR:
+            write_err(err, r->error_line);
+            break;
+        default:
+            break;
     }
+}
 
-    /* Jeśli ostatni wiersz nie zakończył się '\n' */
-    if (!ignore && !empty_line)
-        print_err(*line);
 
-}
\ No newline at end of file
+void run_batch_mode(gamma_t *g, uint32_t *line,
+                    const checkpoint_config_t *cp) {
+    line_parser_t lp;
+    batch_op_t op;
+    batch_result_t r;
+    bool more = true;
+
+    parser_init(&lp);
+
+    while (more) {
+        /* Wyniki muszą być widoczne zanim zaczniemy czekać na wejście */
+        if (!input_buffered()) {
+            output_flush(&std_out);
+            output_flush(&std_err);
+        }
+
+        more = read_op(&lp, line, &op);
+        execute_op(g, &op, &r);
+        format_result(&r, &std_out, &std_err);
+
+        if (cp != NULL && more && op.line % cp->every == 0) {
+            /* Wyniki sprzed punktu kontrolnego nie zostaną powtórzone */
+            output_flush(&std_out);
+            output_flush(&std_err);
+            checkpoint_write(cp->path, g, input_offset(), *line);
+        }
+    }
+}
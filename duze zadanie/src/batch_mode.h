@@ -12,6 +12,52 @@
 #include <stdint.h>
 #include "gamma.h"
 #include "parameter_gamma.h"
+#include "batch_aux.h"
+#include "output_buffer.h"
+#include "checkpoint.h"
+
+
+/**
+ * Pojedyncza przeanalizowana linia wejścia w trybie wsadowym.
+ */
+typedef struct batch_op {
+    /** argumenty instrukcji */
+    uint32_t args[MAX_INSTRUCTIONS_INDEX + 1];
+    uint32_t line; /**< numer linii */
+    int8_t count; /**< liczba argumentów instrukcji */
+    uint8_t errors; /**< liczba błędów składniowych w linii */
+    uint8_t p; /**< parametr instrukcji, @p E jeżeli nie ma jej wykonywać */
+    bool end; /**< czy to ostatnia operacja na wejściu */
+} batch_op_t;
+
+
+/**
+ * Rodzaje wyników operacji w trybie wsadowym.
+ */
+typedef enum result_kind {
+    RESULT_NONE,  /**< brak wyniku                               */
+    RESULT_VALUE, /**< wynikiem jest liczba                      */
+    RESULT_BOARD, /**< wynikiem jest napis z planszą             */
+    RESULT_ERROR, /**< instrukcja jest błędna                    */
+    RESULT_DIFF   /**< wynikiem jest tablica zmienionych pól     */
+} result_kind;
+
+
+/**
+ * Wynik wykonania @ref batch_op_t gotowy do wypisania.
+ */
+typedef struct batch_result {
+    /** wartość wyniku @p RESULT_VALUE, liczba pól wyniku @p RESULT_DIFF */
+    uint64_t value;
+    char *board; /**< plansza wyniku @p RESULT_BOARD, do zwolnienia */
+    /** zmienione pola wyniku @p RESULT_DIFF, do zwolnienia */
+    gamma_change_t *changes;
+    uint32_t line; /**< numer linii operacji */
+    uint32_t error_line; /**< numer linii zgłaszany dla @p RESULT_ERROR */
+    uint8_t errors; /**< liczba błędów składniowych w linii */
+    uint8_t kind; /**< rodzaj wyniku, @ref result_kind */
+    bool end; /**< czy to wynik ostatniej operacji */
+} batch_result_t;
 
 
 /** @brief Zczytuje linię uruchamiającą grę.
@@ -25,12 +71,68 @@
 parameter get_first_line(uint32_t *line, uint32_t *instructions);
 
 
+/** @brief Kończy analizę linii uruchamiającej grę.
+ * Wypisuje komunikaty o błędach w linii i sprawdza, czy jest ona poprawnym
+ * poleceniem @p B lub @p I.
+ * @param[in, out] lp   – stan analizy linii,
+ * @param[in] eol       – @p true jeżeli linia zakończyła się znakiem nowej
+ *                        linii, @p false jeżeli końcem wejścia,
+ * @param[in, out] line – licznik linii na wejściu,
+ * @param[out] p        – parametr (B, I, E) opisujący wybrany tryb gry,
+ * @param[in, out] err  – bufor na komunikaty o błędach.
+ * @return Wartość @p true jeżeli linia była poprawna, wtedy jej parametry
+ * są w @p lp->instructions, @p false w przeciwnym wypadku.
+ */
+bool end_first_line(line_parser_t *lp, bool eol, uint32_t *line,
+                    parameter *p, output_t *err);
+
+
+/** @brief Kończy analizę linii z operacją.
+ * @param[in, out] lp   – stan analizy linii,
+ * @param[in] eol       – @p true jeżeli linia zakończyła się znakiem nowej
+ *                        linii, @p false jeżeli końcem wejścia,
+ * @param[in, out] line – licznik linii na wejściu,
+ * @param[out] op       – przeanalizowana operacja.
+ */
+void end_op(line_parser_t *lp, bool eol, uint32_t *line, batch_op_t *op);
+
+
+/** @brief Wczytuje kolejną operację z wejścia.
+ * @param[in, out] lp   – stan analizy linii,
+ * @param[in, out] line – licznik linii na wejściu,
+ * @param[out] op       – wczytana operacja.
+ * @return Wartość @p false jeżeli po tej operacji nie ma już kolejnych,
+ * @p true w przeciwnym wypadku.
+ */
+bool read_op(line_parser_t *lp, uint32_t *line, batch_op_t *op);
+
+
+/** @brief Wykonuje operację na grze.
+ * @param[in, out] game – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] op        – wykonywana operacja,
+ * @param[out] r        – wynik operacji.
+ */
+void execute_op(gamma_t *game, const batch_op_t *op, batch_result_t *r);
+
+
+/** @brief Wypisuje wynik operacji i zwalnia jego pamięć.
+ * @param[in, out] r    – wypisywany wynik,
+ * @param[in, out] out  – bufor na wyniki,
+ * @param[in, out] err  – bufor na komunikaty o błędach.
+ */
+void format_result(batch_result_t *r, output_t *out, output_t *err);
+
+
 /** @brief Przeprowadza rozgrywkę w trybie wsadowym.
+ * Jeżeli @p cp nie jest NULL, to co @p cp->every linii zapisuje punkt
+ * kontrolny. Nieudany zapis nie przerywa rozgrywki.
  * @param[in, out] line – licznik linii na wejściu,
  * @param[in, out] g    – wskaźnik na strukturę przechowywującą
- *                        stan gry, gamma_t.
+ *                        stan gry, gamma_t,
+ * @param[in] cp        – ustawienia punktów kontrolnych lub NULL.
  */
-void run_batch_mode(gamma_t *g, uint32_t *line);
+void run_batch_mode(gamma_t *g, uint32_t *line,
+                    const checkpoint_config_t *cp);
 
 
 #endif /* GAMMA_BATCH_MODE_H */
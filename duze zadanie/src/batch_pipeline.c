@@ -0,0 +1,100 @@
+#include <pthread.h>
+#include "batch_pipeline.h"
+#include "batch_mode.h"
+#include "ring_buffer.h"
+#include "output_buffer.h"
+
+
+/* Kolejki łączące wątki potoku */
+
+static ring_t ops; /* operacje od wątku analizującego */
+static ring_t results; /* wyniki od wątku wykonującego */
+
+
+/* Wątek analizujący wejście */
+static void *parser_thread(void *arg) {
+    uint32_t *line = arg;
+    line_parser_t lp;
+    batch_op_t op;
+    bool more = true;
+
+    parser_init(&lp);
+
+    while (more) {
+        more = read_op(&lp, line, &op);
+        ring_push(&ops, &op);
+    }
+
+    return NULL;
+}
+
+
+/* Wątek wypisujący wyniki */
+static void *formatter_thread(void *arg) {
+    batch_result_t r;
+    (void) arg;
+
+    do {
+        /* Wyniki muszą być widoczne zanim zaczniemy czekać na kolejne */
+        if (!ring_try_pop(&results, &r)) {
+            output_flush(&std_out);
+            output_flush(&std_err);
+            ring_pop(&results, &r);
+        }
+
+        format_result(&r, &std_out, &std_err);
+    } while (!r.end);
+
+    return NULL;
+}
+
+
+void run_pipelined_batch_mode(gamma_t *g, uint32_t *line) {
+    pthread_t parser, formatter;
+    batch_op_t op;
+    batch_result_t r;
+
+    if (!ring_init(&ops, PIPELINE_RING_SIZE, sizeof(batch_op_t))) {
+        run_batch_mode(g, line, NULL);
+        return;
+    }
+
+    if (!ring_init(&results, PIPELINE_RING_SIZE, sizeof(batch_result_t))) {
+        ring_free(&ops);
+        run_batch_mode(g, line, NULL);
+        return;
+    }
+
+    if (pthread_create(&formatter, NULL, formatter_thread, NULL) != 0) {
+        ring_free(&ops);
+        ring_free(&results);
+        run_batch_mode(g, line, NULL);
+        return;
+    }
+
+    if (pthread_create(&parser, NULL, parser_thread, line) != 0) {
+        /* Wątek wypisujący czeka na wynik ostatniej operacji */
+        op.end = true;
+        op.p = E;
+        op.errors = 0;
+        op.line = *line;
+        execute_op(g, &op, &r);
+        ring_push(&results, &r);
+        pthread_join(formatter, NULL);
+        ring_free(&ops);
+        ring_free(&results);
+        run_batch_mode(g, line, NULL);
+        return;
+    }
+
+    do {
+        ring_pop(&ops, &op);
+        execute_op(g, &op, &r);
+        ring_push(&results, &r);
+    } while (!op.end);
+
+    pthread_join(parser, NULL);
+    pthread_join(formatter, NULL);
+    ring_free(&ops);
+    ring_free(&results);
+}
@@ -0,0 +1,36 @@
+/** @file
+ * Interfejs potokowego trybu wsadowego gry gamma
+ *
+ * Tryb potokowy dzieli pracę trybu wsadowego na trzy wątki: analizujący
+ * wejście, wykonujący operacje na grze i wypisujący wyniki. Wątki
+ * komunikują się kolejkami @ref ring_t, a wyjście jest identyczne
+ * z wyjściem @ref run_batch_mode.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_BATCH_PIPELINE_H
+#define GAMMA_BATCH_PIPELINE_H
+
+#include <stdint.h>
+#include "gamma.h"
+
+
+/**
+ * Liczba elementów każdej z kolejek między wątkami.
+ */
+#define PIPELINE_RING_SIZE 4096
+
+
+/** @brief Przeprowadza rozgrywkę w potokowym trybie wsadowym.
+ * Jeżeli nie uda się utworzyć wątków, wywołuje @ref run_batch_mode.
+ * @param[in, out] g    – wskaźnik na strukturę przechowywującą
+ *                        stan gry, gamma_t,
+ * @param[in, out] line – licznik linii na wejściu.
+ */
+void run_pipelined_batch_mode(gamma_t *g, uint32_t *line);
+
+
+#endif /* GAMMA_BATCH_PIPELINE_H */
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+#include "binary_mode.h"
+#include "batch_mode.h"
+#include "input_buffer.h"
+
+
+bool binary_input(void) {
+    const char *s;
+
+    return (input_peek(&s, BINARY_MAGIC_LEN) >= BINARY_MAGIC_LEN
+            && memcmp(s, BINARY_MAGIC, BINARY_MAGIC_LEN) == 0);
+}
+
+
+void put_u32(output_t *o, uint32_t n) {
+    char s[4];
+
+    for (int i = 0; i < 4; i++)
+        s[i] = (char) (n >> (8 * i));
+
+    output_write(o, s, sizeof(s));
+}
+
+
+void put_u64(output_t *o, uint64_t n) {
+    char s[8];
+
+    for (int i = 0; i < 8; i++)
+        s[i] = (char) (n >> (8 * i));
+
+    output_write(o, s, sizeof(s));
+}
+
+
+uint32_t get_u32(const char *s) {
+    const unsigned char *u = (const unsigned char *) s;
+
+    return (uint32_t) u[0] | (uint32_t) u[1] << 8
+           | (uint32_t) u[2] << 16 | (uint32_t) u[3] << 24;
+}
+
+
+uint64_t get_u64(const char *s) {
+    return (uint64_t) get_u32(s) | (uint64_t) get_u32(s + 4) << 32;
+}
+
+
+/* Zapisuje wynik z numerem ramki */
+static inline void put_frame_result(char kind, uint32_t frame) {
+    output_char(&std_out, kind);
+    put_u32(&std_out, frame);
+}
+
+
+/* Zapisuje wynik operacji i zwalnia jego pamięć */
+static void format_binary_result(batch_result_t *r) {
+    size_t len;
+
+    for (int i = 0; i < r->errors; i++)
+        put_frame_result(BINARY_ERROR, r->line);
+
+    switch (r->kind) {
+        case RESULT_VALUE:
+            output_char(&std_out, BINARY_VALUE);
+            put_u64(&std_out, r->value);
+            break;
+        case RESULT_BOARD:
+            len = strlen(r->board);
+            output_char(&std_out, BINARY_BOARD);
+            put_u64(&std_out, len);
+            output_write(&std_out, r->board, len);
+            free(r->board);
+            r->board = NULL;
+            break;
+        case RESULT_DIFF:
+            output_char(&std_out, BINARY_DIFF);
+            put_u64(&std_out, r->value);
+            for (uint64_t i = 0; i < r->value; i++) {
+                put_u32(&std_out, r->changes[i].x);
+                put_u32(&std_out, r->changes[i].y);
+                put_u32(&std_out, r->changes[i].owner);
+            }
+            free(r->changes);
+            r->changes = NULL;
+            break;
+        case RESULT_ERROR:
+            put_frame_result(BINARY_ERROR, r->error_line);
+            break;
+        default:
+            break;
+    }
+}
+
+
+/* Dekoduje ramkę o długości len (bez bajtu długości) do operacji */
+static void decode_frame(const char *s, uint8_t len, uint32_t frame,
+                         batch_op_t *op) {
+    char code = len > 0 ? s[0] : BINARY_NOP;
+
+    op->line = frame;
+    op->count = -1;
+    op->errors = 0;
+    op->p = E;
+    op->end = false;
+
+    if (len == 0) {
+        op->errors = 1;
+    } else if (code == BINARY_NOP && len == 1) {
+        return;
+    } else if (code == BINARY_INVALID && len == 2) {
+        op->errors = (uint8_t) s[1];
+    } else if (correct_parameter(code) && (len - 1) % 4 == 0
+               && (len - 1) / 4 <= MAX_INSTRUCTIONS_INDEX + 1) {
+        op->p = char_to_param(code);
+        op->count = (int8_t) ((len - 1) / 4);
+        for (int i = 0; i < op->count; i++)
+            op->args[i] = get_u32(s + 1 + 4 * i);
+    } else {
+        op->errors = 1;
+    }
+}
+
+
+void run_binary_mode(void) {
+    const char *s;
+    size_t n;
+    uint32_t frame = 1;
+    gamma_t *game;
+    batch_op_t op;
+    batch_result_t r;
+
+    if (input_peek(&s, BINARY_HEADER_LEN) < BINARY_HEADER_LEN) {
+        put_frame_result(BINARY_ERROR, frame);
+        return;
+    }
+
+    s += BINARY_MAGIC_LEN;
+    game = gamma_new(get_u32(s), get_u32(s + 4),
+                     get_u32(s + 8), get_u32(s + 12));
+    input_skip(BINARY_HEADER_LEN);
+
+    if (game == NULL) {
+        put_frame_result(BINARY_ERROR, frame);
+        return;
+    }
+
+    put_frame_result(BINARY_OK, frame);
+
+    for (;;) {
+        frame++;
+
+        /* Wyniki muszą być widoczne zanim zaczniemy czekać na wejście */
+        if (!input_buffered())
+            output_flush(&std_out);
+
+        if (input_peek(&s, 1) == 0)
+            break;
+
+        uint8_t len = (uint8_t) s[0];
+        n = input_peek(&s, 1 + (size_t) len);
+        if (n < 1 + (size_t) len) {
+            /* Ramka ucięta przez koniec wejścia */
+            put_frame_result(BINARY_ERROR, frame);
+            input_skip(n);
+            break;
+        }
+
+        decode_frame(s + 1, len, frame, &op);
+        execute_op(game, &op, &r);
+        format_binary_result(&r);
+        input_skip(1 + (size_t) len);
+    }
+
+    gamma_delete(game);
+}
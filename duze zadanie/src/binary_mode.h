@@ -0,0 +1,136 @@
+/** @file
+ * Interfejs binarnego protokołu trybu wsadowego gry gamma
+ *
+ * Strumień binarny zaczyna się od @ref BINARY_MAGIC, po którym następują
+ * cztery liczby @p uint32_t: szerokość, wysokość, liczba graczy i liczba
+ * obszarów. Dalej występują ramki: bajt długości, bajt kodu instrukcji
+ * (ten sam znak co w trybie tekstowym) i argumenty jako @p uint32_t.
+ * Wszystkie liczby zapisywane są w kolejności little-endian.
+ * Nagłówek ma numer 1, a kolejne ramki numery 2, 3, ..., tak jak linie
+ * w trybie tekstowym.
+ *
+ * Wyniki również są binarne: bajt rodzaju wyniku, a po nim
+ * - dla @ref BINARY_OK i @ref BINARY_ERROR numer ramki (@p uint32_t),
+ * - dla @ref BINARY_VALUE wartość (@p uint64_t),
+ * - dla @ref BINARY_BOARD długość (@p uint64_t) i tekst planszy,
+ * - dla @ref BINARY_DIFF liczba pól (@p uint64_t), a po niej dla każdego
+ *   pola kolumna, wiersz i numer gracza (@p uint32_t).
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_BINARY_MODE_H
+#define GAMMA_BINARY_MODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "output_buffer.h"
+
+
+/**
+ * Początek strumienia binarnego. Zaczyna się od bajtu zerowego,
+ * więc nie może być poprawną linią trybu tekstowego.
+ */
+#define BINARY_MAGIC "\0GMB"
+
+
+/**
+ * Długość @ref BINARY_MAGIC.
+ */
+#define BINARY_MAGIC_LEN 4
+
+
+/**
+ * Długość nagłówka strumienia binarnego.
+ */
+#define BINARY_HEADER_LEN (BINARY_MAGIC_LEN + 4 * sizeof(uint32_t))
+
+
+/**
+ * Kod ramki odpowiadającej pustej linii lub komentarzowi.
+ */
+#define BINARY_NOP '\0'
+
+
+/**
+ * Kod ramki odpowiadającej linii z błędem składniowym. Jej jedynym
+ * argumentem jest bajt z liczbą komunikatów o błędzie do wypisania.
+ */
+#define BINARY_INVALID 'E'
+
+
+/**
+ * Rodzaj wyniku: poprawny nagłówek.
+ */
+#define BINARY_OK 'o'
+
+
+/**
+ * Rodzaj wyniku: błąd w ramce.
+ */
+#define BINARY_ERROR 'e'
+
+
+/**
+ * Rodzaj wyniku: liczba.
+ */
+#define BINARY_VALUE 'v'
+
+
+/**
+ * Rodzaj wyniku: plansza.
+ */
+#define BINARY_BOARD 'p'
+
+
+/**
+ * Rodzaj wyniku: pola zmienione od poprzedniej instrukcji @p d.
+ */
+#define BINARY_DIFF 'd'
+
+
+/** @brief Sprawdza, czy wejście jest strumieniem binarnym.
+ * Nie zużywa wejścia.
+ * @return Wartość @p true jeżeli wejście zaczyna się od @ref BINARY_MAGIC,
+ * @p false w przeciwnym wypadku.
+ */
+bool binary_input(void);
+
+
+/** @brief Przeprowadza rozgrywkę w binarnym trybie wsadowym.
+ * Czyta nagłówek i ramki z wejścia, a wyniki zapisuje do @ref std_out.
+ */
+void run_binary_mode(void);
+
+
+/** @brief Zapisuje liczbę @p uint32_t w kolejności little-endian.
+ * @param[in, out] o – bufor wyjścia,
+ * @param[in] n      – zapisywana liczba.
+ */
+void put_u32(output_t *o, uint32_t n);
+
+
+/** @brief Zapisuje liczbę @p uint64_t w kolejności little-endian.
+ * @param[in, out] o – bufor wyjścia,
+ * @param[in] n      – zapisywana liczba.
+ */
+void put_u64(output_t *o, uint64_t n);
+
+
+/** @brief Odczytuje liczbę @p uint32_t zapisaną w kolejności little-endian.
+ * @param[in] s – początek liczby.
+ * @return Odczytana liczba.
+ */
+uint32_t get_u32(const char *s);
+
+
+/** @brief Odczytuje liczbę @p uint64_t zapisaną w kolejności little-endian.
+ * @param[in] s – początek liczby.
+ * @return Odczytana liczba.
+ */
+uint64_t get_u64(const char *s);
+
+
+#endif /* GAMMA_BINARY_MODE_H */
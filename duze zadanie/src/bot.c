@@ -0,0 +1,428 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "bot.h"
+
+
+/* Pole rozważane jako ruch */
+typedef struct candidate {
+    uint32_t x, y; /* współrzędne pola */
+    int64_t score; /* ocena pola */
+} candidate_t;
+
+
+/* Gra widziana przez gracza przed ruchem */
+typedef struct position {
+    int64_t mine; /* ocena gracza: podwojone zajęte pola i wolne pola */
+    int64_t others; /* suma ocen przeciwników */
+    int64_t open; /* przeciwnicy, którym ubywa pola przy każdym zwykłym
+                     ruchu, bo mogą zająć każde wolne pole */
+    uint64_t free_count; /* liczba wolnych pól */
+} position_t;
+
+
+/* Wybrany ruch */
+typedef struct choice {
+    uint32_t x, y; /* współrzędne pola */
+    bool golden; /* czy to złoty ruch */
+} choice_t;
+
+
+/* Parametry gry */
+
+static uint32_t width; /* szerokość planszy */
+static uint32_t height; /* wysokość planszy */
+static uint32_t players_count; /* liczba graczy */
+static uint32_t *bots = NULL; /* posortowane numery botów */
+static uint32_t bots_count = 0; /* liczba botów */
+
+/* Szukanie ruchu w tle */
+
+static pthread_t ponder_thread;
+static bool pondering = false; /* czy wątek szukający w tle działa */
+static atomic_bool cancelled; /* czy należy przerwać szukanie */
+static gamma_t *ponder_game; /* kopia gry, na której szuka wątek */
+static uint32_t ponder_player; /* gracz, dla którego szuka wątek */
+static uint64_t ponder_version; /* wersja gry w chwili utworzenia kopii */
+static choice_t ponder_choice; /* ruch znaleziony przez wątek */
+static bool ponder_found; /* czy wątek znalazł ruch */
+
+
+static int compare_players(const void *a, const void *b) {
+    uint32_t pa = *(const uint32_t *) a, pb = *(const uint32_t *) b;
+
+    return (pa > pb) - (pa < pb);
+}
+
+
+/* Liczy sąsiadów pola (x, y): własnych, wolnych i należących do innych */
+static void count_neighbours(gamma_t *g, uint32_t player, uint32_t x,
+                             uint32_t y, uint32_t counts[3]) {
+    static const int dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+
+    counts[0] = counts[1] = counts[2] = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint32_t nx = x + (uint32_t) dx[i], ny = y + (uint32_t) dy[i];
+        uint32_t owner;
+
+        /* Wyjście poza planszę zawija się do wartości spoza zakresu */
+        if (nx >= width || ny >= height)
+            continue;
+
+        owner = gamma_whose_field(g, nx, ny);
+        if (owner == player)
+            counts[0]++;
+        else if (owner == 0)
+            counts[1]++;
+        else
+            counts[2]++;
+    }
+}
+
+
+/* Dodaje pole do listy najlepszych pól posortowanej malejąco */
+static void offer(candidate_t *list, uint32_t *n, uint32_t cap,
+                  uint32_t x, uint32_t y, int64_t score) {
+    uint32_t i;
+
+    if (*n == cap && list[cap - 1].score >= score)
+        return;
+
+    if (*n < cap)
+        (*n)++;
+
+    for (i = *n - 1; i > 0 && list[i - 1].score < score; i--)
+        list[i] = list[i - 1];
+
+    list[i] = (candidate_t) {x, y, score};
+}
+
+
+/* Ocenia grę z punktu widzenia gracza: jego zajęte i możliwe do zajęcia
+ * pola względem średniej przeciwników */
+static int64_t outlook(int64_t mine, int64_t others) {
+    return players_count == 1 ? mine
+                              : mine * (players_count - 1) - others;
+}
+
+
+/* Mierzy grę przed ruchem gracza; free_count to liczba wolnych pól planszy */
+static void measure(gamma_t *g, uint32_t player, uint64_t free_count,
+                    position_t *pos) {
+    pos->mine = pos->others = pos->open = 0;
+    pos->free_count = free_count;
+
+    for (uint32_t p = 1; p <= players_count; p++) {
+        uint64_t free_fields = gamma_free_fields(g, p);
+        int64_t value = 2 * (int64_t) gamma_busy_fields(g, p)
+                        + (int64_t) free_fields;
+
+        if (p == player) {
+            pos->mine = value;
+        } else {
+            pos->others += value;
+            if (free_fields == free_count)
+                pos->open++;
+        }
+    }
+}
+
+
+/* Liczy przeciwników z ograniczoną liczbą wolnych pól sąsiadujących
+ * z polem (x, y); zajęcie tego pola odbiera im jedno z nich */
+static int64_t limited_neighbours(gamma_t *g, uint32_t player,
+                                  const position_t *pos,
+                                  uint32_t x, uint32_t y) {
+    static const int dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+    uint32_t seen[4];
+    int64_t count = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint32_t nx = x + (uint32_t) dx[i], ny = y + (uint32_t) dy[i];
+        uint32_t owner;
+        bool repeated = false;
+
+        seen[i] = 0;
+        if (nx >= width || ny >= height)
+            continue;
+
+        owner = gamma_whose_field(g, nx, ny);
+        for (int j = 0; j < i; j++)
+            repeated = repeated || seen[j] == owner;
+
+        if (owner != 0 && owner != player && !repeated
+            && gamma_free_fields(g, owner) != pos->free_count)
+            count++;
+        seen[i] = owner;
+    }
+
+    return count;
+}
+
+
+/* Ocenia ruch bez wykonywania go. Zwraca false, jeżeli ruch jest
+ * niemożliwy */
+static bool evaluate(gamma_t *g, uint32_t player, const position_t *pos,
+                     const candidate_t *c, bool golden, int64_t *score) {
+    gamma_effect_t e;
+    int64_t others = pos->others;
+
+    if (golden ? !gamma_try_golden_move(g, player, c->x, c->y, &e)
+               : !gamma_try_move(g, player, c->x, c->y, &e))
+        return false;
+
+    if (golden)
+        others += e.victim_free_delta - 2; /* pole przechodzi do gracza */
+    else
+        others -= pos->open + limited_neighbours(g, player, pos, c->x, c->y);
+
+    *score = outlook(pos->mine + 2 * e.busy_delta + e.free_delta, others);
+    /* Złoty ruch jest jednorazowy, więc musi się opłacać */
+    if (golden)
+        *score -= players_count > 1 ? 2 * (int64_t) (players_count - 1) : 2;
+
+    return true;
+}
+
+
+/* Szuka najlepszego ruchu gracza. Zwraca false, jeżeli nie znalazł żadnego
+ * ruchu albo szukanie przerwano */
+static bool search(gamma_t *g, uint32_t player, choice_t *best) {
+    candidate_t any[BOT_CANDIDATES], adjacent[BOT_CANDIDATES];
+    candidate_t golden[BOT_GOLDEN_CANDIDATES];
+    uint32_t any_n = 0, adjacent_n = 0, golden_n = 0;
+    uint64_t free_count = 0;
+    bool golden_possible = gamma_golden_possible(g, player);
+    candidate_t *normal;
+    uint32_t normal_n;
+    position_t pos;
+    int64_t best_score = INT64_MIN, score;
+    bool found = false;
+
+    for (uint32_t x = 0; x < width; x++) {
+        if (atomic_load(&cancelled))
+            return false;
+
+        for (uint32_t y = 0; y < height; y++) {
+            uint32_t owner = gamma_whose_field(g, x, y);
+            uint32_t counts[3];
+
+            if (owner == player || (owner != 0 && !golden_possible))
+                continue;
+
+            count_neighbours(g, player, x, y, counts);
+
+            if (owner == 0) {
+                int64_t s = 2 * counts[1] + counts[2];
+
+                free_count++;
+                offer(any, &any_n, BOT_CANDIDATES, x, y, s);
+                if (counts[0] > 0)
+                    offer(adjacent, &adjacent_n, BOT_CANDIDATES, x, y, s);
+            } else {
+                offer(golden, &golden_n, BOT_GOLDEN_CANDIDATES, x, y,
+                      3 * counts[0] + counts[1]);
+            }
+        }
+    }
+
+    /* Gracz z maksymalną liczbą obszarów może jedynie je powiększać */
+    if (gamma_free_fields(g, player) == free_count) {
+        normal = any;
+        normal_n = any_n;
+    } else {
+        normal = adjacent;
+        normal_n = adjacent_n;
+    }
+
+    measure(g, player, free_count, &pos);
+
+    for (uint32_t i = 0; i < normal_n + golden_n; i++) {
+        bool is_golden = i >= normal_n;
+        const candidate_t *c = is_golden ? &golden[i - normal_n] : &normal[i];
+
+        if (atomic_load(&cancelled))
+            return false;
+
+        if (evaluate(g, player, &pos, c, is_golden, &score)
+            && score > best_score) {
+            best_score = score;
+            *best = (choice_t) {c->x, c->y, is_golden};
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+
+/* Sprawdza, czy od wersji version nie zmieniono pól w pobliżu ruchu */
+static bool still_fresh(gamma_t *g, uint64_t version, const choice_t *c) {
+    gamma_change_t *changes;
+    uint64_t count;
+    bool fresh = true;
+
+    if (gamma_version(g) == version)
+        return true;
+
+    if (!gamma_changes(g, version, &changes, &count))
+        return false;
+
+    for (uint64_t i = 0; i < count && fresh; i++) {
+        uint32_t dx = changes[i].x > c->x ? changes[i].x - c->x
+                                          : c->x - changes[i].x;
+        uint32_t dy = changes[i].y > c->y ? changes[i].y - c->y
+                                          : c->y - changes[i].y;
+        fresh = dx > 2 || dy > 2;
+    }
+
+    free(changes);
+
+    return fresh;
+}
+
+
+static bool apply(gamma_t *g, uint32_t player, const choice_t *c) {
+    if (c->golden)
+        return gamma_golden_move(g, player, c->x, c->y);
+    else
+        return gamma_move(g, player, c->x, c->y);
+}
+
+
+/* Wątek szukający ruchu w tle */
+static void *ponder(void *arg) {
+    (void) arg;
+    ponder_found = search(ponder_game, ponder_player, &ponder_choice);
+
+    return NULL;
+}
+
+
+/* Czeka na zakończenie szukania w tle, przerywając je jeżeli cancel */
+static void finish_pondering(bool cancel) {
+    if (!pondering)
+        return;
+
+    if (cancel)
+        atomic_store(&cancelled, true);
+
+    pthread_join(ponder_thread, NULL);
+    gamma_delete(ponder_game);
+    ponder_game = NULL;
+    pondering = false;
+    atomic_store(&cancelled, false);
+}
+
+
+bool bot_init(const uint32_t *players, uint32_t count,
+              uint32_t width0, uint32_t height0, uint32_t players_count0) {
+    width = width0;
+    height = height0;
+    players_count = players_count0;
+    bots_count = 0;
+    atomic_store(&cancelled, false);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (players[i] == 0 || players[i] > players_count)
+            return false;
+    }
+
+    if (count == 0)
+        return true;
+
+    bots = malloc(count * sizeof(uint32_t));
+    if (bots == NULL)
+        return false;
+
+    for (uint32_t i = 0; i < count; i++)
+        bots[i] = players[i];
+    qsort(bots, count, sizeof(uint32_t), compare_players);
+    bots_count = count;
+
+    return true;
+}
+
+
+bool bot_controls(uint32_t player) {
+    return bots_count > 0
+           && bsearch(&player, bots, bots_count, sizeof(uint32_t),
+                      compare_players) != NULL;
+}
+
+
+uint32_t bot_next(uint32_t player) {
+    uint32_t lo = 0, hi = bots_count;
+
+    if (bots_count == 0)
+        return 0;
+
+    /* Pierwszy bot o numerze większym od player */
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (bots[mid] <= player)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < bots_count ? bots[lo] : bots[0];
+}
+
+
+void bot_ponder(gamma_t *g, uint32_t player) {
+    finish_pondering(true);
+
+    ponder_game = gamma_copy(g);
+    if (ponder_game == NULL)
+        return;
+
+    ponder_player = player;
+    ponder_version = gamma_version(g);
+
+    if (pthread_create(&ponder_thread, NULL, ponder, NULL) != 0) {
+        gamma_delete(ponder_game);
+        ponder_game = NULL;
+        return;
+    }
+
+    pondering = true;
+}
+
+
+bool bot_move(gamma_t *g, uint32_t player) {
+    choice_t c;
+
+    if (pondering && ponder_player == player) {
+        finish_pondering(false);
+        if (ponder_found && still_fresh(g, ponder_version, &ponder_choice)
+            && apply(g, player, &ponder_choice))
+            return true;
+    } else {
+        finish_pondering(true);
+    }
+
+    if (search(g, player, &c) && apply(g, player, &c))
+        return true;
+
+    /* Żadne z ocenianych pól nie pozwalało na złoty ruch */
+    if (gamma_golden_possible(g, player)) {
+        for (uint32_t x = 0; x < width; x++) {
+            for (uint32_t y = 0; y < height; y++) {
+                if (gamma_golden_move(g, player, x, y))
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+void bot_free(void) {
+    finish_pondering(true);
+    free(bots);
+    bots = NULL;
+    bots_count = 0;
+}
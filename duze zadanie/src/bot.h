@@ -0,0 +1,93 @@
+/** @file
+ * Interfejs graczy sterowanych przez komputer w trybie interaktywnym
+ *
+ * Bot wybiera ruch w dwóch krokach. Najpierw ocenia każde pole planszy
+ * na podstawie jego sąsiadów i wybiera kilka najlepszych pól dla zwykłego
+ * i złotego ruchu. Potem sprawdza skutki każdego z tych ruchów przez
+ * @ref gamma_try_move i @ref gamma_try_golden_move, nie zmieniając gry,
+ * i porównuje liczby pól, które po nim mogą zająć on i jego przeciwnicy.
+ *
+ * Podczas tury człowieka bot może szukać ruchu w tle, na kopii gry.
+ * Jeżeli człowiek nie zmienił planszy w pobliżu wybranego pola, bot
+ * wykonuje przygotowany ruch od razu.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_BOT_H
+#define GAMMA_BOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamma.h"
+
+
+/**
+ * Liczba pól dla zwykłego ruchu, których skutki bot sprawdza.
+ */
+#define BOT_CANDIDATES 8
+
+
+/**
+ * Liczba pól dla złotego ruchu, których skutki bot sprawdza.
+ */
+#define BOT_GOLDEN_CANDIDATES 4
+
+
+/** @brief Wybiera graczy sterowanych przez komputer.
+ * @param[in] players       – numery graczy sterowanych przez komputer,
+ * @param[in] count         – liczba elementów tablicy @p players,
+ * @param[in] width         – szerokość planszy,
+ * @param[in] height        – wysokość planszy,
+ * @param[in] players_count – liczba graczy w grze.
+ * @return Wartość @p true, jeżeli wszystkie numery są poprawne i udało się
+ * zaalokować pamięć, @p false w przeciwnym przypadku.
+ */
+bool bot_init(const uint32_t *players, uint32_t count,
+              uint32_t width, uint32_t height, uint32_t players_count);
+
+
+/** @brief Sprawdza, czy gracz jest sterowany przez komputer.
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Wartość @p true, jeżeli gracz jest sterowany przez komputer,
+ * @p false w przeciwnym przypadku.
+ */
+bool bot_controls(uint32_t player);
+
+
+/** @brief Podaje bota, który jako pierwszy wykona ruch po danym graczu.
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Numer pierwszego bota o numerze większym od @p player, a jeżeli
+ * takiego nie ma, to bota o najmniejszym numerze. Zero, jeżeli nie ma botów.
+ */
+uint32_t bot_next(uint32_t player);
+
+
+/** @brief Zaczyna w tle szukać ruchu gracza.
+ * Szukanie odbywa się na kopii gry, więc @p g można zmieniać, zanim gracz
+ * wykona ruch. Przerywa wcześniejsze szukanie w tle.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza sterowanego przez komputer.
+ */
+void bot_ponder(gamma_t *g, uint32_t player);
+
+
+/** @brief Wykonuje ruch gracza sterowanego przez komputer.
+ * Korzysta z ruchu znalezionego w tle, jeżeli jest on wciąż aktualny,
+ * w przeciwnym wypadku szuka ruchu od nowa.
+ * @param[in,out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza sterowanego przez komputer.
+ * @return Wartość @p true, jeżeli gracz wykonał ruch, @p false jeżeli nie
+ * miał żadnego ruchu.
+ */
+bool bot_move(gamma_t *g, uint32_t player);
+
+
+/** @brief Kończy szukanie w tle i zwalnia pamięć botów.
+ */
+void bot_free(void);
+
+
+#endif /* GAMMA_BOT_H */
@@ -0,0 +1,77 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+
+/* Początek pliku punktu kontrolnego */
+#define CHECKPOINT_MAGIC "GMCP"
+
+
+/* Zapisuje nagłówek i stan gry do otwartego pliku */
+static bool write_contents(FILE *f, gamma_t *g,
+                           uint64_t offset, uint32_t line) {
+    return (fwrite(CHECKPOINT_MAGIC, 1, 4, f) == 4
+            && fwrite(&offset, sizeof(offset), 1, f) == 1
+            && fwrite(&line, sizeof(line), 1, f) == 1
+            && gamma_save(g, f)
+            && fflush(f) == 0
+            && fsync(fileno(f)) == 0);
+}
+
+
+bool checkpoint_write(const char *path, gamma_t *g,
+                      uint64_t offset, uint32_t line) {
+    size_t len = strlen(path);
+    char *tmp = malloc(len + sizeof(".tmp"));
+    FILE *f;
+    bool written;
+
+    if (tmp == NULL)
+        return false;
+
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", sizeof(".tmp"));
+
+    f = fopen(tmp, "wb");
+    if (f == NULL) {
+        free(tmp);
+        return false;
+    }
+
+    written = write_contents(f, g, offset, line);
+    if (fclose(f) != 0)
+        written = false;
+
+    if (written)
+        written = rename(tmp, path) == 0;
+    else
+        remove(tmp);
+
+    free(tmp);
+
+    return written;
+}
+
+
+gamma_t *checkpoint_read(const char *path, uint64_t *offset, uint32_t *line) {
+    char magic[4];
+    gamma_t *g = NULL;
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL)
+        return NULL;
+
+    if (fread(magic, 1, 4, f) == 4
+        && memcmp(magic, CHECKPOINT_MAGIC, 4) == 0
+        && fread(offset, sizeof(*offset), 1, f) == 1
+        && fread(line, sizeof(*line), 1, f) == 1)
+        g = gamma_load(f);
+
+    fclose(f);
+
+    return g;
+}
@@ -0,0 +1,62 @@
+/** @file
+ * Interfejs punktów kontrolnych trybu wsadowego gry gamma
+ *
+ * Punkt kontrolny zawiera pełny stan gry (@ref gamma_save), pozycję
+ * w strumieniu wejścia (@ref input_offset) i licznik linii. Po awarii
+ * rozgrywkę można wznowić od ostatniego punktu kontrolnego zamiast od
+ * pierwszej linii wejścia. Wyniki linii przeczytanych po zapisaniu punktu
+ * zostaną wypisane ponownie.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_CHECKPOINT_H
+#define GAMMA_CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamma.h"
+
+
+/**
+ * Domyślna liczba linii między kolejnymi punktami kontrolnymi.
+ */
+#define CHECKPOINT_DEFAULT_EVERY 1000000
+
+
+/**
+ * Ustawienia zapisywania punktów kontrolnych.
+ */
+typedef struct checkpoint_config {
+    const char *path; /**< plik punktu kontrolnego */
+    uint32_t every; /**< liczba linii między punktami, liczba dodatnia */
+} checkpoint_config_t;
+
+
+/** @brief Zapisuje punkt kontrolny.
+ * Zapis trafia najpierw do pliku tymczasowego, który po zsynchronizowaniu
+ * z dyskiem zastępuje @p path, więc przerwany zapis nie niszczy
+ * poprzedniego punktu kontrolnego.
+ * @param[in] path   – ścieżka pliku punktu kontrolnego,
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] offset – pozycja pierwszej niewykonanej linii na wejściu,
+ * @param[in] line   – numer pierwszej niewykonanej linii.
+ * @return Wartość @p true jeżeli się udało, @p false w przeciwnym wypadku.
+ */
+bool checkpoint_write(const char *path, gamma_t *g,
+                      uint64_t offset, uint32_t line);
+
+
+/** @brief Wczytuje punkt kontrolny zapisany przez @ref checkpoint_write.
+ * @param[in] path    – ścieżka pliku punktu kontrolnego,
+ * @param[out] offset – pozycja pierwszej niewykonanej linii na wejściu,
+ * @param[out] line   – numer pierwszej niewykonanej linii.
+ * @return Wskaźnik na odtworzoną grę lub NULL, jeżeli nie udało się
+ * odczytać pliku lub jest on niepoprawny.
+ */
+gamma_t *checkpoint_read(const char *path, uint64_t *offset, uint32_t *line);
+
+
+#endif /* GAMMA_CHECKPOINT_H */
@@ -0,0 +1,290 @@
+/** @file
+ * Test trybu współbieżnego gry gamma
+ *
+ * Kilka wątków wykonuje jednocześnie losowe ruchy i złote ruchy na jednej
+ * grze. Po każdej serii liczniki graczy są porównywane z wartościami
+ * policzonymi od nowa z planszy, a skrót gry ze skrótem gry zbudowanej
+ * z tej samej planszy przez @ref gamma_new_from_owners. Cel budowany jest
+ * z @p -fsanitize=thread, więc wyścigi między wątkami też są błędem testu.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+// CMake w wersji release wyłącza asercje.
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gamma.h"
+
+
+/**
+ * Szerokość planszy testowej, kilka fragmentów blokad.
+ */
+#define WIDTH 256
+
+
+/**
+ * Wysokość planszy testowej.
+ */
+#define HEIGHT 160
+
+
+/**
+ * Liczba graczy w grze testowej.
+ */
+#define PLAYERS 6
+
+
+/**
+ * Maksymalna liczba obszarów gracza w grze testowej.
+ */
+#define AREAS 3000
+
+
+/**
+ * Liczba wątków wykonujących ruchy.
+ */
+#define THREADS 4
+
+
+/**
+ * Liczba prób ruchu jednego wątku w serii.
+ */
+#define BATCH 6000
+
+
+/**
+ * Liczba serii ruchów.
+ */
+#define ROUNDS 6
+
+
+/**
+ * Stan wątku wykonującego ruchy.
+ */
+typedef struct worker {
+    gamma_t *g; /**< wspólna gra */
+    uint64_t random; /**< stan generatora liczb losowych wątku */
+    bool golden; /**< czy wątek próbuje też złotych ruchów */
+    uint64_t moves; /**< liczba wykonanych ruchów */
+} worker_t;
+
+
+/** @brief Losuje kolejną liczbę generatorem xorshift.
+ * Zwraca starsze bity stanu, bo młodsze bity kolejnych liczb są ze sobą
+ * powiązane i same nie trafiają we wszystkie pola planszy.
+ * @param[in, out] state – stan generatora, liczba niezerowa.
+ * @return Wylosowana liczba.
+ */
+static inline uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state >> 32;
+}
+
+
+/** @brief Wykonuje serię losowych ruchów w osobnym wątku.
+ * Co dwusetna próba wątku ze złotymi ruchami jest złotym ruchem.
+ * @param[in,out] arg – wskaźnik na stan wątku, @ref worker_t.
+ * @return NULL.
+ */
+static void *play(void *arg) {
+    worker_t *w = arg;
+
+    for (int i = 0; i < BATCH; i++) {
+        uint32_t player = (uint32_t) (next_random(&w->random) % PLAYERS) + 1;
+        uint32_t x = (uint32_t) (next_random(&w->random) % WIDTH);
+        uint32_t y = (uint32_t) (next_random(&w->random) % HEIGHT);
+
+        if (w->golden && next_random(&w->random) % 200 == 0
+            ? gamma_golden_move(w->g, player, x, y)
+            : gamma_move(w->g, player, x, y))
+            w->moves++;
+    }
+
+    return NULL;
+}
+
+
+/** @brief Podaje składnik skrótu gry od złotego ruchu gracza.
+ * Jest to różnica skrótów planszy 2 x 1 po złotym ruchu gracza
+ * @p player i tej samej planszy zbudowanej bez złotego ruchu.
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Składnik skrótu.
+ */
+static uint64_t golden_hash(uint32_t player) {
+    uint32_t owners[2] = {player, 0};
+    uint32_t other = player % PLAYERS + 1;
+    gamma_t *g = gamma_new(2, 1, PLAYERS, 1);
+    gamma_t *plain = gamma_new_from_owners(2, 1, PLAYERS, 1, owners);
+    uint64_t hash;
+
+    assert(g != NULL && plain != NULL);
+    assert(gamma_move(g, other, 0, 0));
+    assert(gamma_golden_move(g, player, 0, 0));
+    hash = gamma_hash(g) ^ gamma_hash(plain);
+
+    gamma_delete(g);
+    gamma_delete(plain);
+
+    return hash;
+}
+
+
+/** @brief Oznacza obszar gracza zawierający dane pole.
+ * @param[in] owners   – właściciele pól jak w @ref gamma_export_owners,
+ * @param[in,out] seen – znaczniki odwiedzenia pól,
+ * @param[in,out] stack – stos numerów pól, co najmniej WIDTH * HEIGHT,
+ * @param[in] start    – numer pola, od którego zaczyna się przegląd.
+ */
+static void mark_area(const uint32_t *owners, bool *seen, uint32_t *stack,
+                      uint32_t start) {
+    uint32_t size = 0;
+
+    seen[start] = true;
+    stack[size++] = start;
+
+    while (size > 0) {
+        uint32_t i = stack[--size];
+        uint32_t x = i % WIDTH, y = i / WIDTH;
+        uint32_t next[4] = {
+            x > 0 ? i - 1 : i,
+            x + 1 < WIDTH ? i + 1 : i,
+            y > 0 ? i - WIDTH : i,
+            y + 1 < HEIGHT ? i + WIDTH : i,
+        };
+
+        for (int k = 0; k < 4; k++) {
+            if (!seen[next[k]] && owners[next[k]] == owners[i]) {
+                seen[next[k]] = true;
+                stack[size++] = next[k];
+            }
+        }
+    }
+}
+
+
+/** @brief Sprawdza, czy wolne pole sąsiaduje z polem gracza.
+ * @param[in] owners – właściciele pól jak w @ref gamma_export_owners,
+ * @param[in] i      – numer pola,
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Wartość @p true, jeżeli któryś z sąsiadów pola należy
+ * do gracza @p player, @p false w przeciwnym wypadku.
+ */
+static bool touches(const uint32_t *owners, uint32_t i, uint32_t player) {
+    uint32_t x = i % WIDTH, y = i / WIDTH;
+
+    return (x > 0 && owners[i - 1] == player)
+           || (x + 1 < WIDTH && owners[i + 1] == player)
+           || (y > 0 && owners[i - WIDTH] == player)
+           || (y + 1 < HEIGHT && owners[i + WIDTH] == player);
+}
+
+
+/** @brief Porównuje stan gry z wartościami policzonymi z planszy.
+ * @param[in] g – wskaźnik na grę, poza trybem współbieżnym.
+ */
+static void check_game(gamma_t *g) {
+    static uint32_t owners[WIDTH * HEIGHT], stack[WIDTH * HEIGHT];
+    static bool seen[WIDTH * HEIGHT];
+    uint64_t busy[PLAYERS + 1] = {0}, areas[PLAYERS + 1] = {0};
+    uint64_t adjacent[PLAYERS + 1] = {0};
+    uint64_t hash;
+    gamma_t *rebuilt;
+
+    assert(gamma_export_owners(g, owners, WIDTH));
+    memset(seen, 0, sizeof(seen));
+
+    for (uint32_t i = 0; i < WIDTH * HEIGHT; i++) {
+        busy[owners[i]]++;
+
+        if (owners[i] != 0 && !seen[i]) {
+            areas[owners[i]]++;
+            mark_area(owners, seen, stack, i);
+        }
+
+        for (uint32_t player = 1; owners[i] == 0 && player <= PLAYERS;
+             player++) {
+            if (touches(owners, i, player))
+                adjacent[player]++;
+        }
+    }
+
+    rebuilt = gamma_new_from_owners(WIDTH, HEIGHT, PLAYERS, AREAS, owners);
+    assert(rebuilt != NULL);
+    hash = gamma_hash(rebuilt);
+
+    for (uint32_t player = 1; player <= PLAYERS; player++) {
+        gamma_player_stats_t stats;
+        uint64_t free_fields = areas[player] == AREAS ? adjacent[player]
+                                                      : busy[0];
+
+        assert(gamma_busy_fields(g, player) == busy[player]);
+        assert(gamma_free_fields(g, player) == free_fields);
+        assert(gamma_player_stats(g, player, &stats));
+        assert(stats.areas == areas[player]);
+
+        assert(gamma_busy_fields(rebuilt, player) == busy[player]);
+        assert(gamma_free_fields(rebuilt, player) == free_fields);
+
+        if (gamma_golden_used(g, player))
+            hash ^= golden_hash(player);
+    }
+
+    assert(gamma_hash(g) == hash);
+    gamma_delete(rebuilt);
+}
+
+
+/** @brief Sprawdza tryb współbieżny.
+ * W pierwszych seriach wątki wykonują tylko zwykłe ruchy, które blokują
+ * fragmenty planszy, a w kolejnych także złote ruchy, które blokują
+ * całą planszę.
+ * @return Zero, gdy wszystkie testy przebiegły poprawnie,
+ * a w przeciwnym przypadku kod zakończenia programu jest kodem błędu.
+ */
+int main() {
+    gamma_t *g = gamma_new(WIDTH, HEIGHT, PLAYERS, AREAS);
+    pthread_t threads[THREADS];
+    worker_t workers[THREADS];
+    uint64_t moves = 0;
+
+    assert(g != NULL);
+
+    for (int i = 0; i < THREADS; i++)
+        workers[i] = (worker_t) {g, 0x9e3779b97f4a7c15ULL * (i + 1), false, 0};
+
+    for (int round = 0; round < ROUNDS; round++) {
+        assert(gamma_set_concurrent(g, true));
+
+        for (int i = 0; i < THREADS; i++) {
+            workers[i].golden = round >= ROUNDS / 2;
+            assert(pthread_create(&threads[i], NULL, play, &workers[i]) == 0);
+        }
+
+        for (int i = 0; i < THREADS; i++)
+            assert(pthread_join(threads[i], NULL) == 0);
+
+        assert(gamma_set_concurrent(g, false));
+        check_game(g);
+    }
+
+    for (int i = 0; i < THREADS; i++)
+        moves += workers[i].moves;
+    assert(gamma_version(g) >= moves);
+    gamma_delete(g);
+
+    printf("%llu concurrent moves checked\n", (unsigned long long) moves);
+
+    return 0;
+}
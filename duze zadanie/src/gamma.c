@@ -6,10 +6,96 @@
  * @date 09.06.2020
  */
 
+#define _GNU_SOURCE
+
 #include "gamma.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Początek zapisu stanu gry tworzonego przez @ref gamma_save.
+ */
+#define GAMMA_SAVE_MAGIC "GMST"
+
+
+/**
+ * Wersja formatu zapisu stanu gry.
+ */
+#define GAMMA_SAVE_VERSION 3
+
+
+/**
+ * Wersja formatu zapisu bez wersji gry i dziennika zmian.
+ */
+#define GAMMA_SAVE_VERSION_NO_LOG 2
+
+
+/**
+ * Wersja formatu zapisu, w której wolne numery obszarów opisywały pola
+ * lowest_free_id i highest_freed_id.
+ */
+#define GAMMA_SAVE_VERSION_SCAN 1
+
+
+/**
+ * Koniec listy wolnych numerów obszarów.
+ */
+#define NO_AREA UINT32_MAX
+
+
+/**
+ * Znacznik elementów area_fields_count zajętych przez listę wolnych numerów
+ * obszarów, odróżniający je od liczb pól używanych obszarów.
+ */
+#define FREE_AREA_TAG (UINT64_C(1) << 63)
+
+
+/**
+ * Koniec listy wolnych grup rankingu.
+ */
+#define NO_GROUP UINT32_MAX
+
+
+/**
+ * Rozmiar dużej strony pamięci. Plansze co najmniej tej wielkości są
+ * mapowane przez mmap z prośbą o duże strony.
+ */
+#define HUGE_PAGE_SIZE (UINT64_C(1) << 21)
+
+
+/**
+ * Najmniejsza liczba pól planszy na jeden wątek w @ref gamma_new_from_owners.
+ */
+#define IMPORT_FIELDS_PER_THREAD (1u << 16)
+
+
+/**
+ * Bok kwadratu pól kopiowanego naraz przez @ref export_block.
+ */
+#define EXPORT_TILE 64
+
+
+/**
+ * Bok kwadratowego fragmentu planszy z własną blokadą w trybie
+ * współbieżnym, co najmniej 5, żeby ruch dotykał najwyżej 2 x 2 fragmentów.
+ */
+#define CONCURRENT_TILE 64
+
+
+/**
+ * Początek segmentu pamięci współdzielonej tworzonego przez @ref gamma_share.
+ */
+#define GAMMA_SHARE_MAGIC "GMSH"
+
 
 /**
  * Alias dla typu unsigned __int128.
@@ -19,11 +105,13 @@ typedef unsigned __int128 uint128_t;
 
 /**
  * Struktura reprezentująca stan pola w planszy.
+ * Pole wolne ma wszystkie bity zerowe, więc wyzerowana pamięć jest od razu
+ * pustą planszą.
  */
 typedef struct field {
     uint32_t taken; /**< numer gracza zajmującego pole - 1 */
     uint32_t area; /**< numer obszaru do którego pole należy */
-    bool free; /**< @p true jeżeli pole jest wolne, startowo @p true */
+    bool busy; /**< @p true jeżeli pole jest zajęte, startowo @p false */
     bool visited; /**< znacznik odwedzenia pola, początkowo @p false*/
 } field_t;
 
@@ -34,14 +122,115 @@ typedef struct field {
 typedef struct player {
     bool golden_move; /**< czy nie zrobił złotego ruchu, startowo @p true */
     uint64_t *area_fields_count;  /**< tablica ilości pól w obszarach */
-    uint32_t lowest_free_id; /**< pierwszy wolny obszar, startowo @p UINT32_MAX */
-    uint32_t highest_freed_id; /**< ostatni zwolniony obszar, startowo @p 0 */
+    uint32_t free_area; /**< ostatnio zwolniony numer obszaru, początek listy
+                             wolnych numerów, startowo @p NO_AREA */
+    uint32_t unused_area; /**< najmniejszy nigdy nieużyty numer obszaru,
+                               startowo @p 0 */
     uint64_t adjacent_free_count; /**< ilość przylegająych pól, startowo @p 0 */
     uint32_t fields_count; /**< liczba zajmowanych pól, startowo @p 0 */
     uint32_t areas_count; /**< liczba posiadanych obszrów, startowo @p 0 */
+    uint64_t golden_version; /**< wersja gry, dla której policzono
+                                  @p golden_possible, startowo @p UINT64_MAX */
+    bool golden_possible; /**< ostatni wynik @ref gamma_golden_possible */
+    uint64_t golden_epoch; /**< liczba ruchów gracza i ruchów obok jego pól,
+                                startowo @p 0 */
+    uint64_t golden_stamp; /**< suma @p golden_epoch gracza i gry z chwili
+                                policzenia @p golden_possible,
+                                startowo @p UINT64_MAX */
+    uint64_t loose_stamp; /**< @p loose_epoch gry z chwili policzenia
+                               @p golden_possible */
+    uint32_t witness_x; /**< odcięta pola ostatnio dopuszczającego złoty ruch,
+                             startowo @p UINT32_MAX */
+    uint32_t witness_y; /**< rzędna pola ostatnio dopuszczającego złoty ruch */
+    uint64_t perimeter; /**< liczba boków pól gracza, które nie stykają się
+                             z innym jego polem, startowo @p 0 */
+    uint64_t largest_area; /**< liczba pól największego obszaru,
+                                startowo @p 0 */
+    uint32_t area_sizes[GAMMA_AREA_SIZE_BUCKETS]; /**< histogram wielkości
+                                                       obszarów jak
+                                                       w @ref gamma_player_stats_t,
+                                                       startowo zera */
+    uint32_t rank_position; /**< pozycja gracza w rankingu */
+    uint32_t rank_group; /**< numer grupy rankingu gracza,
+                              @ref rank_group_t */
 } player_t;
 
 
+/**
+ * Grupa graczy z tą samą liczbą pól, zajmująca spójny fragment rankingu.
+ */
+typedef struct rank_group {
+    uint32_t fields; /**< liczba pól graczy grupy */
+    uint32_t first; /**< pierwsza pozycja grupy w rankingu, dla wolnej
+                         grupy numer następnej wolnej grupy */
+    uint32_t end; /**< pozycja za ostatnim graczem grupy */
+} rank_group_t;
+
+
+/**
+ * Wpis dziennika zmian pól planszy.
+ */
+typedef struct change {
+    uint32_t x; /**< odcięta zmienionego pola */
+    uint32_t y; /**< rzędna zmienionego pola */
+    uint64_t version; /**< wersja gry po tej zmianie */
+} change_t;
+
+
+/**
+ * Początkowa pojemność dziennika zmian.
+ */
+#define CHANGES_INITIAL_CAPACITY 1024
+
+
+/**
+ * Pas kolumn planszy etykietowany przez jeden wątek
+ * w @ref gamma_new_from_owners.
+ */
+typedef struct stripe {
+    gamma_t *g; /**< wypełniana gra */
+    pthread_t thread; /**< wątek przetwarzający pas */
+    bool started; /**< czy udało się utworzyć wątek */
+    const uint32_t *owners; /**< właściciele pól, wiersz po wierszu */
+    uint64_t *parent; /**< las Find-Union pól o indeksach x * height + y */
+    uint64_t *root; /**< korzenie drzew pól, wypełniane w drugim przebiegu */
+    uint32_t from; /**< pierwsza kolumna pasa */
+    uint32_t to; /**< kolumna za ostatnią kolumną pasa */
+    bool correct; /**< czy numery graczy w pasie są poprawne */
+} stripe_t;
+
+
+/**
+ * Blokady gry w trybie współbieżnym, @ref gamma_set_concurrent.
+ * Kolejność brania: @p board, fragmenty rosnąco, gracze rosnąco,
+ * @p shared.
+ */
+typedef struct locks {
+    pthread_rwlock_t board; /**< wspólna przy ruchach nie łączących obszarów,
+                                 wyłączna przy pozostałych ruchach */
+    pthread_mutex_t *tiles; /**< blokady fragmentów planszy, kolumnami */
+    uint64_t tiles_count; /**< liczba fragmentów planszy */
+    uint32_t tiles_height; /**< liczba fragmentów w kolumnie */
+    pthread_mutex_t *players; /**< blokady liczników i obszarów graczy */
+    pthread_mutex_t shared; /**< blokada liczników całej gry, skrótu
+                                 i dziennika zmian */
+} locks_t;
+
+
+/**
+ * Nagłówek segmentu pamięci współdzielonej z planszą, @ref gamma_share.
+ * Za nim leżą pola planszy kolumna po kolumnie.
+ */
+typedef struct shared_board {
+    char magic[4]; /**< @ref GAMMA_SHARE_MAGIC */
+    uint32_t width; /**< szerokość planszy */
+    uint32_t height; /**< wysokość planszy */
+    uint32_t players_count; /**< liczba graczy */
+    _Atomic uint64_t sequence; /**< licznik zmian planszy, nieparzysty
+                                    w trakcie ruchu */
+} shared_board_t;
+
+
 /**
  * Struktura przechowywująca stan gry gamma.
  */
@@ -53,9 +242,42 @@ typedef struct gamma {
     uint32_t width; /**< szerokość planszy, zadana przy inicjalizacji */
     uint32_t height; /**< wysokość planszy, zadana przy inicjalizacji */
     uint32_t max_areas; /**< maksimum obszarów, zadane przy inicjalizacji */
+    uint64_t version; /**< liczba zmian pól planszy, początkowo @p 0 */
+    change_t *changes; /**< dziennik zmian, NULL dopóki nie jest potrzebny */
+    uint64_t changes_count; /**< liczba wpisów w dzienniku zmian */
+    uint64_t changes_capacity; /**< pojemność dziennika zmian */
+    uint64_t tracked_from; /**< wersja, od której prowadzony jest dziennik */
+    uint64_t diff_version; /**< wersja z ostatniego @ref gamma_diff */
+    uint64_t hash; /**< skrót Zobrista pozycji, dla pustej planszy @p 0 */
+    locks_t *locks; /**< blokady trybu współbieżnego, NULL poza nim */
+    gamma_observer_t observer; /**< funkcje obserwatora, bez niego NULL */
+    void *observer_ctx; /**< kontekst funkcji obserwatora */
+    shared_board_t *shared; /**< segment pamięci współdzielonej z planszą,
+                                 NULL gdy plansza jest w pamięci procesu */
+    size_t shared_size; /**< rozmiar segmentu @p shared */
+    char *shared_name; /**< nazwa segmentu @p shared */
+    size_t board_mapped; /**< rozmiar mapowania pól planszy, @p 0 gdy pola
+                              zaalokowano przez calloc */
+    uint32_t *ranking; /**< numery graczy - 1 nierosnąco według liczby pól */
+    rank_group_t *groups; /**< grupy rankingu, o jedną więcej niż graczy */
+    uint32_t free_group; /**< początek listy wolnych grup rankingu */
+    uint64_t golden_epoch; /**< liczba złotych ruchów i ruchów na pola
+                                z co najmniej dwoma sąsiadami gracza */
+    uint64_t loose_epoch; /**< liczba ruchów na pola z co najwyżej jednym
+                               sąsiadem gracza */
 } gamma_t;
 
 
+/**
+ * Widok planszy gry z segmentu pamięci współdzielonej.
+ */
+struct gamma_view {
+    gamma_t game; /**< gra z planszą w segmencie, do odczytu */
+    shared_board_t *shared; /**< zmapowany segment */
+    size_t size; /**< rozmiar segmentu */
+};
+
+
 /** @brief Sprawdza czy gracz ma max obszaróww.
  * @param[in] g      – wskaźnik na grę, @ref gamma_t,
  * @param[in] player – numer gracza, liczba dodatnia,
@@ -80,7 +302,7 @@ static inline bool left_is_players(gamma_t *g, uint32_t player,
     if (x == 0) {
         return false;
     } else {
-        return (!(g->board[x - 1][y].free)
+        return (g->board[x - 1][y].busy
                 && g->board[x - 1][y].taken == player - 1);
     }
 }
@@ -99,7 +321,7 @@ static inline bool right_is_players(gamma_t *g, uint32_t player,
     if (x == g->width - 1) {
         return false;
     } else {
-        return (!(g->board[x + 1][y].free)
+        return (g->board[x + 1][y].busy
                 && g->board[x + 1][y].taken == player - 1);
     }
 }
@@ -118,7 +340,7 @@ static inline bool up_is_players(gamma_t *g, uint32_t player,
     if (y == g->height - 1) {
         return false;
     } else {
-        return (!(g->board[x][y + 1].free)
+        return (g->board[x][y + 1].busy
                 && g->board[x][y + 1].taken == player - 1);
     }
 }
@@ -137,7 +359,7 @@ static inline bool down_is_players(gamma_t *g, uint32_t player,
     if (y == 0) {
         return false;
     } else {
-        return (!(g->board[x][y - 1].free)
+        return (g->board[x][y - 1].busy
                 && g->board[x][y - 1].taken == player - 1);
     }
 }
@@ -171,6 +393,58 @@ static inline char how_many_neighbours_owns(gamma_t *g, uint32_t player,
 }
 
 
+/** @brief Zmienia obwód gracza po postawieniu lub zabraniu jego pionka.
+ * @param[in,out] g  – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia,
+ * @param[in] x      – odcięta zmienionego pola, liczba nieujemna,
+ * @param[in] y      – rzędna zmienionego pola, liczba nieujemna,
+ * @param[in] placed – @p true, jeżeli pionek postawiono, @p false, jeżeli
+ *                     zabrano.
+ */
+static inline void update_perimeter(gamma_t *g, uint32_t player,
+                                    uint32_t x, uint32_t y, bool placed) {
+    player_t *p = &g->players[player - 1];
+    uint64_t shared = 2 * (uint64_t) how_many_neighbours_owns(g, player, x, y);
+
+    if (placed)
+        p->perimeter = p->perimeter + 4 - shared;
+    else
+        p->perimeter = p->perimeter + shared - 4;
+}
+
+
+/** @brief Zaznacza ruch na pole na potrzeby @ref gamma_golden_possible.
+ * Zwiększa @p golden_epoch gracza @p player i właścicieli pól sąsiednich,
+ * a w grze @p golden_epoch, gdy pole ma co najmniej dwóch sąsiadów gracza
+ * @p player, albo @p loose_epoch w przeciwnym razie.
+ * @param[in,out] g  – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza stawiającego pionek, liczba dodatnia,
+ * @param[in] x      – odcięta pola, liczba nieujemna,
+ * @param[in] y      – rzędna pola, liczba nieujemna.
+ */
+static inline void touch_golden(gamma_t *g, uint32_t player,
+                                uint32_t x, uint32_t y) {
+    g->players[player - 1].golden_epoch++;
+
+    if (x > 0 && g->board[x - 1][y].busy)
+        g->players[g->board[x - 1][y].taken].golden_epoch++;
+
+    if (x < g->width - 1 && g->board[x + 1][y].busy)
+        g->players[g->board[x + 1][y].taken].golden_epoch++;
+
+    if (y > 0 && g->board[x][y - 1].busy)
+        g->players[g->board[x][y - 1].taken].golden_epoch++;
+
+    if (y < g->height - 1 && g->board[x][y + 1].busy)
+        g->players[g->board[x][y + 1].taken].golden_epoch++;
+
+    if (how_many_neighbours_owns(g, player, x, y) < 2)
+        g->loose_epoch++;
+    else
+        g->golden_epoch++;
+}
+
+
 /** @brief Sprawdza czy gracz nie sąsiadował z lewym polem.
  * @param[in] g      – wskaźnik na grę, @ref gamma_t,
  * @param[in] player – numer gracza, liczba dodatnia,
@@ -184,7 +458,7 @@ static inline bool adj_from_left(gamma_t *g, uint32_t player,
     if (x == 0) {
         return false;
     } else {
-        return (g->board[x - 1][y].free
+        return (!g->board[x - 1][y].busy
                 && !left_is_players(g, player, x - 1, y)
                 && !up_is_players(g, player, x - 1, y)
                 && !down_is_players(g, player, x - 1, y));
@@ -205,7 +479,7 @@ static inline bool adj_from_up(gamma_t *g, uint32_t player,
     if (y == g->height - 1) {
         return false;
     } else {
-        return (g->board[x][y + 1].free
+        return (!g->board[x][y + 1].busy
                 && !left_is_players(g, player, x, y + 1)
                 && !up_is_players(g, player, x, y + 1)
                 && !right_is_players(g, player, x, y + 1));
@@ -226,7 +500,7 @@ static inline bool adj_from_right(gamma_t *g, uint32_t player,
     if (x == g->width - 1) {
         return false;
     } else {
-        return (g->board[x + 1][y].free
+        return (!g->board[x + 1][y].busy
                 && !right_is_players(g, player, x + 1, y)
                 && !up_is_players(g, player, x + 1, y)
                 && !down_is_players(g, player, x + 1, y));
@@ -247,7 +521,7 @@ static inline bool adj_from_down(gamma_t *g, uint32_t player,
     if (y == 0) {
         return false;
     } else {
-        return (g->board[x][y - 1].free
+        return (!g->board[x][y - 1].busy
                 && !right_is_players(g, player, x, y - 1)
                 && !left_is_players(g, player, x, y - 1)
                 && !down_is_players(g, player, x, y - 1));
@@ -269,6 +543,23 @@ static inline bool was_adjacent(gamma_t *g, uint32_t player,
 }
 
 
+/** @brief Liczy wolne pola, z którymi gracz zacząłby sąsiadować.
+ * @param[in] g      – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia,
+ * @param[in] x      – odcięta rozważanego pola, liczba nieujemna,
+ * @param[in] y      – rzędna rozważanego pola, liczba nieujemna.
+ * @return Liczba wolnych sąsiadów pola (@p x, @p y), z którymi gracz
+ * @p player sąsiadowałby jedynie przez to pole; liczba z przedziału [0, 4].
+ */
+static inline uint64_t afc_gain(gamma_t *g, uint32_t player,
+                                uint32_t x, uint32_t y) {
+    return (uint64_t) adj_from_left(g, player, x, y)
+           + adj_from_up(g, player, x, y)
+           + adj_from_right(g, player, x, y)
+           + adj_from_down(g, player, x, y);
+}
+
+
 /** @brief Zwiększa adjacent_file_count dla @ref place_pawn.
  * Procedura kontroluje liczbę pól sąsiadujących, gracza @p player,
  * którego pionek jest stawiany na polu (@p x, @p y).
@@ -278,17 +569,7 @@ static inline bool was_adjacent(gamma_t *g, uint32_t player,
  * @param[in] y      – rzędna rozważanego pola, liczba nieujemna.
  */
 static void afc_expand(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    if (adj_from_left(g, player, x, y))
-        g->players[player - 1].adjacent_free_count++;
-
-    if (adj_from_up(g, player, x, y))
-        g->players[player - 1].adjacent_free_count++;
-
-    if (adj_from_right(g, player, x, y))
-        g->players[player - 1].adjacent_free_count++;
-
-    if (adj_from_down(g, player, x, y))
-        g->players[player - 1].adjacent_free_count++;
+    g->players[player - 1].adjacent_free_count += afc_gain(g, player, x, y);
 
     if (was_adjacent(g, player, x, y))
         g->players[player - 1].adjacent_free_count--;
@@ -311,14 +592,14 @@ static void afc_dimnish_others(gamma_t *g, uint32_t player,
     uint32_t p3 = UINT32_MAX;
 
     if (x > 0) {
-        if (!(g->board[x - 1][y].free) && g->board[x - 1][y].taken != player - 1) {
+        if (g->board[x - 1][y].busy && g->board[x - 1][y].taken != player - 1) {
             p1 = g->board[x - 1][y].taken;
             g->players[p1].adjacent_free_count--;
         }
     }
 
     if (x < g->width - 1) {
-        if (!(g->board[x + 1][y].free) && g->board[x + 1][y].taken != player - 1
+        if (g->board[x + 1][y].busy && g->board[x + 1][y].taken != player - 1
             && g->board[x + 1][y].taken != p1) {
             p2 = g->board[x + 1][y].taken;
             g->players[g->board[x + 1][y].taken].adjacent_free_count--;
@@ -326,7 +607,7 @@ static void afc_dimnish_others(gamma_t *g, uint32_t player,
     }
 
     if (y > 0) {
-        if (!(g->board[x][y - 1].free) && g->board[x][y - 1].taken != player - 1
+        if (g->board[x][y - 1].busy && g->board[x][y - 1].taken != player - 1
             && g->board[x][y - 1].taken != p1 && g->board[x][y - 1].taken != p2) {
             p3 = g->board[x][y - 1].taken;
             g->players[g->board[x][y - 1].taken].adjacent_free_count--;
@@ -334,7 +615,7 @@ static void afc_dimnish_others(gamma_t *g, uint32_t player,
     }
 
     if (y < g->height - 1) {
-        if (!(g->board[x][y + 1].free) && g->board[x][y + 1].taken != player - 1
+        if (g->board[x][y + 1].busy && g->board[x][y + 1].taken != player - 1
             && g->board[x][y + 1].taken != p1 && g->board[x][y + 1].taken != p2
             && g->board[x][y + 1].taken != p3) {
             g->players[g->board[x][y + 1].taken].adjacent_free_count--;
@@ -343,6 +624,240 @@ static void afc_dimnish_others(gamma_t *g, uint32_t player,
 }
 
 
+/** @brief Usuwa powtórzenia z dziennika zmian.
+ * Zostawia dla każdego pola tylko ostatni wpis, zachowując kolejność wpisów.
+ * Nie zmienia to wyniku @ref gamma_changes dla żadnej wersji.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ */
+static void compact_changes(gamma_t *g) {
+    uint64_t kept = g->changes_count;
+
+    for (uint64_t i = g->changes_count; i >= 1; i--) {
+        change_t c = g->changes[i - 1];
+        if (!g->board[c.x][c.y].visited) {
+            g->board[c.x][c.y].visited = true;
+            g->changes[--kept] = c;
+        }
+    }
+
+    for (uint64_t i = kept; i < g->changes_count; i++)
+        g->board[g->changes[i].x][g->changes[i].y].visited = false;
+
+    g->changes_count -= kept;
+    memmove(g->changes, g->changes + kept, g->changes_count * sizeof(change_t));
+}
+
+
+/** @brief Przestaje prowadzić dziennik zmian.
+ * Kolejne zapytania o zmiany będą przeglądać całą planszę.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ */
+static void stop_tracking(gamma_t *g) {
+    free(g->changes);
+    g->changes = NULL;
+    g->changes_count = 0;
+    g->changes_capacity = 0;
+}
+
+
+/** @brief Odnotowuje zmianę pola.
+ * Zwiększa wersję gry i, jeżeli dziennik zmian jest prowadzony,
+ * dopisuje do niego pole (@p x, @p y). Pełny dziennik najpierw jest
+ * zagęszczany, a dopiero gdy to nie wystarcza – powiększany.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] x       – odcięta zmienionego pola, liczba nieujemna,
+ * @param[in] y       – rzędna zmienionego pola, liczba nieujemna.
+ */
+static inline void record_change(gamma_t *g, uint32_t x, uint32_t y) {
+    g->version++;
+
+    if (g->changes == NULL)
+        return;
+
+    if (g->changes_count == g->changes_capacity) {
+        compact_changes(g);
+
+        if (g->changes_count > g->changes_capacity / 2) {
+            change_t *bigger = realloc(g->changes, 2 * g->changes_capacity
+                                                   * sizeof(change_t));
+            if (bigger == NULL) {
+                stop_tracking(g);
+                return;
+            }
+            g->changes = bigger;
+            g->changes_capacity *= 2;
+        }
+    }
+
+    g->changes[g->changes_count].x = x;
+    g->changes[g->changes_count].y = y;
+    g->changes[g->changes_count].version = g->version;
+    g->changes_count++;
+}
+
+
+/** @brief Miesza bity liczby.
+ * Funkcja kończąca generatora splitmix64: bliskie argumenty dają
+ * niezależnie wyglądające wyniki.
+ * @param[in] z       – mieszana liczba.
+ * @return Wymieszana liczba.
+ */
+static inline uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+
+/** @brief Podaje klucz Zobrista pionka gracza na polu.
+ * Klucze nie są przechowywane w tablicy, tylko wyliczane z współrzędnych
+ * i numeru gracza, więc nie zależą od rozmiaru planszy.
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] x       – odcięta pola, liczba nieujemna,
+ * @param[in] y       – rzędna pola, liczba nieujemna.
+ * @return Klucz pionka.
+ */
+static inline uint64_t field_key(uint32_t player, uint32_t x, uint32_t y) {
+    return mix(mix(((uint64_t) x << 32 | y) + 0x9e3779b97f4a7c15ULL)
+               + player);
+}
+
+
+/** @brief Podaje klucz Zobrista wykorzystanego złotego ruchu gracza.
+ * @param[in] player  – numer gracza, liczba dodatnia.
+ * @return Klucz złotego ruchu.
+ */
+static inline uint64_t golden_key(uint32_t player) {
+    return mix(0xd1b54a32d192ed03ULL ^ player);
+}
+
+
+/** @brief Zamienia miejscami dwóch graczy w rankingu.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] a       – pozycja pierwszego gracza,
+ * @param[in] b       – pozycja drugiego gracza.
+ */
+static inline void swap_ranking(gamma_t *g, uint32_t a, uint32_t b) {
+    uint32_t tmp = g->ranking[a];
+
+    g->ranking[a] = g->ranking[b];
+    g->ranking[b] = tmp;
+    g->players[g->ranking[a]].rank_position = a;
+    g->players[g->ranking[b]].rank_position = b;
+}
+
+
+/** @brief Tworzy grupę rankingu z jednym graczem.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] fields  – liczba pól gracza,
+ * @param[in] pos     – pozycja gracza w rankingu.
+ * @return Numer grupy.
+ */
+static inline uint32_t new_group(gamma_t *g, uint32_t fields, uint32_t pos) {
+    uint32_t id = g->free_group;
+
+    g->free_group = g->groups[id].first;
+    g->groups[id] = (rank_group_t) {fields, pos, pos + 1};
+
+    return id;
+}
+
+
+/** @brief Zwalnia grupę rankingu, jeżeli jest pusta.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] id      – numer grupy.
+ */
+static inline void drop_empty_group(gamma_t *g, uint32_t id) {
+    if (g->groups[id].first == g->groups[id].end) {
+        g->groups[id].first = g->free_group;
+        g->free_group = id;
+    }
+}
+
+
+/** @brief Przesuwa gracza w rankingu po zyskaniu pola.
+ * Gracz przechodzi na początek swojej grupy i staje się ostatnim graczem
+ * grupy o jedno pole większej, tworząc ją w razie potrzeby.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player  – numer gracza - 1.
+ */
+static void rank_up(gamma_t *g, uint32_t player) {
+    player_t *p = &g->players[player];
+    uint32_t id = p->rank_group;
+    uint32_t pos = g->groups[id].first;
+    uint32_t fields = g->groups[id].fields + 1;
+
+    swap_ranking(g, p->rank_position, pos);
+    g->groups[id].first++;
+
+    if (pos > 0 && g->groups[g->players[g->ranking[pos - 1]].rank_group]
+                       .fields == fields) {
+        p->rank_group = g->players[g->ranking[pos - 1]].rank_group;
+        g->groups[p->rank_group].end++;
+    } else {
+        p->rank_group = new_group(g, fields, pos);
+    }
+
+    drop_empty_group(g, id);
+}
+
+
+/** @brief Przesuwa gracza w rankingu po utracie pola.
+ * Gracz przechodzi na koniec swojej grupy i staje się pierwszym graczem
+ * grupy o jedno pole mniejszej, tworząc ją w razie potrzeby.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player  – numer gracza - 1.
+ */
+static void rank_down(gamma_t *g, uint32_t player) {
+    player_t *p = &g->players[player];
+    uint32_t id = p->rank_group;
+    uint32_t pos = g->groups[id].end - 1;
+    uint32_t fields = g->groups[id].fields - 1;
+
+    swap_ranking(g, p->rank_position, pos);
+    g->groups[id].end--;
+
+    if (pos + 1 < g->players_count
+        && g->groups[g->players[g->ranking[pos + 1]].rank_group]
+               .fields == fields) {
+        p->rank_group = g->players[g->ranking[pos + 1]].rank_group;
+        g->groups[p->rank_group].first--;
+    } else {
+        p->rank_group = new_group(g, fields, pos);
+    }
+
+    drop_empty_group(g, id);
+}
+
+
+/** @brief Układa ranking od nowa według liczb pól graczy.
+ * Zaczyna od rankingu nowej gry i przesuwa graczy o kolejne pola,
+ * w czasie proporcjonalnym do liczby graczy i zajętych pól.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ */
+static void build_ranking(gamma_t *g) {
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        g->ranking[i] = i;
+        g->players[i].rank_position = i;
+        g->players[i].rank_group = 0;
+    }
+
+    g->groups[0] = (rank_group_t) {0, 0, g->players_count};
+    g->free_group = NO_GROUP;
+    for (uint32_t id = g->players_count; id > 0; id--) {
+        g->groups[id].first = g->free_group;
+        g->free_group = id;
+    }
+
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        while (g->groups[g->players[i].rank_group].fields
+               < g->players[i].fields_count)
+            rank_up(g, i);
+    }
+}
+
+
 /** @brief Stawia pionek gracza na danym polu.
  * Zmienia stan gry @p g, stawiając w miejsce (@p x, @p y) pionek
  * gracza @p player.
@@ -353,48 +868,116 @@ static void afc_dimnish_others(gamma_t *g, uint32_t player,
  */
 static inline void place(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     g->board[x][y].taken = player - 1;
-    g->board[x][y].free = false;
+    g->board[x][y].busy = true;
+    g->hash ^= field_key(player, x, y);
+    record_change(g, x, y);
     g->players[player - 1].fields_count++;
+    rank_up(g, player - 1);
+    update_perimeter(g, player, x, y, true);
+    touch_golden(g, player, x, y);
     afc_expand(g, player, x, y);
     afc_dimnish_others(g, player, x, y);
     g->free_fields_count--;
 }
 
 
-/** @brief Ustawia parametr lowest_free_id.
+/** @brief Podaje przedział histogramu wielkości obszarów.
+ * @param[in] size    – liczba pól obszaru, liczba dodatnia.
+ * @return Numer przedziału jak w @ref gamma_player_stats_t.
+ */
+static inline uint32_t size_bucket(uint64_t size) {
+    uint32_t bucket = 63 - (uint32_t) __builtin_clzll(size);
+
+    return bucket < GAMMA_AREA_SIZE_BUCKETS ? bucket
+                                            : GAMMA_AREA_SIZE_BUCKETS - 1;
+}
+
+
+/** @brief Dolicza obszar do statystyk gracza.
+ * @param[in,out] p   – wskaźnik na gracza, @ref player_t,
+ * @param[in] size    – liczba pól obszaru, liczba dodatnia.
+ */
+static inline void count_area(player_t *p, uint64_t size) {
+    p->area_sizes[size_bucket(size)]++;
+    if (size > p->largest_area)
+        p->largest_area = size;
+}
+
+
+/** @brief Odlicza obszar od histogramu gracza.
+ * Nie zmienia największego obszaru, wyznacza go @ref find_largest_area.
+ * @param[in,out] p   – wskaźnik na gracza, @ref player_t,
+ * @param[in] size    – liczba pól obszaru, liczba dodatnia.
+ */
+static inline void uncount_area(player_t *p, uint64_t size) {
+    p->area_sizes[size_bucket(size)]--;
+}
+
+
+/** @brief Powiększa obszar gracza.
  * @param[in,out] p   – wskaźnik na gracza, @ref player_t,
+ * @param[in] area    – numer niepustego obszaru,
+ * @param[in] by      – liczba dołączanych pól.
  */
-static inline void set_lowest(player_t *p) {
-    while (p->area_fields_count[p->lowest_free_id] != 0) {
-        p->lowest_free_id++;
+static inline void grow_area(player_t *p, uint32_t area, uint64_t by) {
+    uncount_area(p, p->area_fields_count[area]);
+    p->area_fields_count[area] += by;
+    count_area(p, p->area_fields_count[area]);
+}
+
+
+/** @brief Wyznacza od nowa największy obszar gracza.
+ * Przegląda wszystkie kiedykolwiek użyte numery obszarów, więc jest
+ * wywoływana tylko wtedy, gdy największy obszar zniknął.
+ * @param[in,out] p   – wskaźnik na gracza, @ref player_t.
+ */
+static void find_largest_area(player_t *p) {
+    p->largest_area = 0;
+
+    for (uint32_t area = 0; area < p->unused_area; area++) {
+        uint64_t size = p->area_fields_count[area];
+
+        if (!(size & FREE_AREA_TAG) && size > p->largest_area)
+            p->largest_area = size;
     }
 }
 
 
-/** @brief Szuka numeru dla nowego obszaru dla gracza.
- * Korzystając informacji o ilości obszarów gracza @p player, a także
- * wartości pól lowest_free_id, highest_freed_id, ustala
- * wolny numer pola dla gracza oraz aktaulizuje wymienione pola.
+/** @brief Zwalnia numer obszaru gracza.
+ * Wolne numery tworzą listę, której kolejne elementy są zapisane,
+ * z @ref FREE_AREA_TAG, w area_fields_count wolnych numerów. Obszar jest
+ * odliczany od histogramu.
+ * @param[in,out] p   – wskaźnik na gracza, @ref player_t,
+ * @param[in] area    – zwalniany numer obszaru.
+ */
+static inline void release_area(player_t *p, uint32_t area) {
+    uncount_area(p, p->area_fields_count[area]);
+    p->area_fields_count[area] = FREE_AREA_TAG | p->free_area;
+    p->free_area = area;
+    p->areas_count--;
+}
+
+
+/** @brief Przydziela numer nowemu obszarowi gracza.
+ * Bierze ostatnio zwolniony numer, a jeżeli żadnego nie ma, najmniejszy
+ * nigdy nieużyty. Zwiększa liczbę obszarów gracza.
  * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
  * @param[in] player  – numer gracza, liczba dodatnia.
- * @return Najmniejszy numer wolnego obszaru gracza @p player.
+ * @return Numer wolnego obszaru gracza @p player, z liczbą pól równą 0.
  */
 static uint32_t get_next_area(gamma_t *g, uint32_t player) {
-    player_t *tmp_p = &(g->players[player - 1]);
-    uint32_t area = 0;
-
-    if (tmp_p->lowest_free_id == tmp_p->highest_freed_id) {
-        area = tmp_p->lowest_free_id;
-        tmp_p->highest_freed_id = 0;
-        tmp_p->lowest_free_id = UINT32_MAX;
-    } else if (tmp_p->lowest_free_id > tmp_p->highest_freed_id) {
-        area = tmp_p->areas_count - 1;
+    player_t *p = &(g->players[player - 1]);
+    uint32_t area;
+
+    if (p->free_area != NO_AREA) {
+        area = p->free_area;
+        p->free_area = (uint32_t) p->area_fields_count[area];
+        p->area_fields_count[area] = 0;
     } else {
-        area = tmp_p->lowest_free_id;
-        set_lowest(tmp_p);
+        area = p->unused_area++;
     }
 
-    g->players[player - 1].areas_count++;
+    p->areas_count++;
 
     return area;
 }
@@ -410,11 +993,9 @@ static uint32_t get_next_area(gamma_t *g, uint32_t player) {
  */
 static inline void new_area(gamma_t *g, uint32_t player,
                             uint32_t x, uint32_t y) {
-
-    g->players[player - 1].areas_count++;
     g->board[x][y].area = get_next_area(g, player);
-    g->players[player - 1].areas_count--;
     g->players[player - 1].area_fields_count[g->board[x][y].area]++;
+    count_area(&g->players[player - 1], 1);
 }
 
 
@@ -673,10 +1254,8 @@ static void transfer_area(gamma_t *g, uint32_t player,
  * Wykorzystując numer nowego obszaru, zakodowany w polu (@p x, @p y),
  * do którego obszar @p from należący go @p player ma zostać dołączony,
  * wywołuje @ref transfer_area.
- * Kontroluje następujace pola z @ref player_t
- * lowest_free_id
- * highest_freed_id
- * areas_count oraz area_fields_count.
+ * Kontroluje następujace pola z @ref player_t:
+ * areas_count, area_fields_count oraz listę wolnych numerów obszarów.
  * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
  * @param[in] player  – numer gracza, liczba dodatnia,
  * @param[in] x       – odcięta bieżącego pola, liczba nieujemna,
@@ -688,16 +1267,12 @@ static void set_area_id(gamma_t *g, uint32_t player, uint32_t x,
     uint32_t to = g->board[x][y].area;
     player_t *tmp_p = &(g->players[player - 1]);
 
-    if (tmp_p->lowest_free_id > from)
-        tmp_p->lowest_free_id = from;
-
-    if (tmp_p->highest_freed_id < from)
-        tmp_p->highest_freed_id = from;
-
     transfer_area(g, player, x, y, from, to);
-    tmp_p->area_fields_count[to] += tmp_p->area_fields_count[from];
-    tmp_p->area_fields_count[from] = 0;
-    tmp_p->areas_count--;
+    grow_area(tmp_p, to, tmp_p->area_fields_count[from]);
+    release_area(tmp_p, from);
+
+    if (g->observer.merged != NULL)
+        g->observer.merged(g->observer_ctx, player, x, y);
 }
 
 /** @brief Dołącza pole do istniejących obszarów.
@@ -714,6 +1289,7 @@ static void no_new_areas(gamma_t *g, uint32_t player,
                          uint32_t x, uint32_t y) {
     uint32_t biggest_area = biggest_neighbouring_area(g, player, x, y);
     g->board[x][y].area = biggest_area;
+    grow_area(&g->players[player - 1], biggest_area, 1);
 
     if (!is_right_area_biggest_area(g, player, x, y))
         set_area_id(g, player, x, y, g->board[x + 1][y].area);
@@ -816,7 +1392,7 @@ static void check_areas(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     if (how_many == 0) {
         new_area(g, player, x, y);
     } else if (how_many == 1) {
-        g->players[player - 1].area_fields_count[area]++;
+        grow_area(&g->players[player - 1], area, 1);
         g->board[x][y].area = area;
     } else {
         no_new_areas(g, player, x, y);
@@ -835,6 +1411,10 @@ static void check_areas(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
  */
 static bool place_pawn(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     place(g, player, x, y);
+
+    if (g->observer.placed != NULL)
+        g->observer.placed(g->observer_ctx, player, x, y);
+
     check_areas(g, player, x, y);
 
     return true;
@@ -1011,34 +1591,63 @@ static void rec_repaint(gamma_t *g, uint32_t player, uint32_t area,
 }
 
 
+/** @brief Maluje jedną część obszaru dla @ref repaint.
+ * Przydziela części nowy numer i dolicza ją do statystyk gracza.
+ * @param[in,out] g  – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia,
+ * @param[in] xi     – odcięta pola części, liczba nieujemna,
+ * @param[in] yi     – rzędna pola części, liczba nieujemna.
+ */
+static void repaint_part(gamma_t *g, uint32_t player,
+                         uint32_t xi, uint32_t yi) {
+    player_t *p = &g->players[player - 1];
+    uint32_t area = get_next_area(g, player);
+
+    rec_repaint(g, player, area, xi, yi);
+    count_area(p, p->area_fields_count[area]);
+}
+
+
 /** @brief Przyznaje obszarom nowe id dla @ref manage_areas.
+ * Jeżeli obszar rozpadł się na kilka, powiadamia o tym obserwatora.
  * @param[in,out] g  – wskaźnik na grę, @ref gamma_t,
  * @param[in] x      – odcięta startowego pola, liczba nieujemna,
  * @param[in] y      – rzędna startowego pola, liczba nieujemna.
  */
 static void repaint(gamma_t *g, uint32_t x, uint32_t y) {
     uint32_t player = g->board[x][y].taken + 1;
+    uint32_t parts = 0;
 
     if (left_is_players(g, player, x, y)) {
-        if (!(g->board[x - 1][y].visited))
-            rec_repaint(g, player, get_next_area(g, player), x - 1, y);
+        if (!(g->board[x - 1][y].visited)) {
+            repaint_part(g, player, x - 1, y);
+            parts++;
+        }
     }
 
     if (up_is_players(g, player, x, y)) {
-        if (!(g->board[x][y + 1].visited))
-            rec_repaint(g, player, get_next_area(g, player), x, y + 1);
+        if (!(g->board[x][y + 1].visited)) {
+            repaint_part(g, player, x, y + 1);
+            parts++;
+        }
     }
 
     if (right_is_players(g, player, x, y)) {
-        if (!(g->board[x + 1][y].visited))
-            rec_repaint(g, player, get_next_area(g, player), x + 1, y);
+        if (!(g->board[x + 1][y].visited)) {
+            repaint_part(g, player, x + 1, y);
+            parts++;
+        }
     }
 
     if (down_is_players(g, player, x, y)) {
-        if (!(g->board[x][y - 1].visited))
-            rec_repaint(g, player, get_next_area(g, player), x, y - 1);
+        if (!(g->board[x][y - 1].visited)) {
+            repaint_part(g, player, x, y - 1);
+            parts++;
+        }
     }
 
+    if (parts > 1 && g->observer.split != NULL)
+        g->observer.split(g->observer_ctx, player, x, y, parts);
 }
 
 
@@ -1050,14 +1659,7 @@ static void repaint(gamma_t *g, uint32_t x, uint32_t y) {
 static inline void delete_area(gamma_t *g, uint32_t x, uint32_t y) {
     field_t field = g->board[x][y];
 
-    g->players[field.taken].area_fields_count[field.area] = 0;
-    g->players[field.taken].areas_count--;
-    if (g->players[field.taken].lowest_free_id > field.area)
-        g->players[field.taken].lowest_free_id = field.area;
-
-    if (g->players[field.taken].highest_freed_id < field.area)
-        g->players[field.taken].highest_freed_id = field.area;
-
+    release_area(&g->players[field.taken], field.area);
 }
 
 
@@ -1069,8 +1671,14 @@ static inline void delete_area(gamma_t *g, uint32_t x, uint32_t y) {
  * @param[in] y      – rzędna rozważanego pola, liczba nieujemna.
  */
 static void manage_areas(gamma_t *g, uint32_t x, uint32_t y) {
+    player_t *p = &g->players[g->board[x][y].taken];
+    bool largest = p->area_fields_count[g->board[x][y].area]
+                   == p->largest_area;
+
     delete_area(g, x, y);
     repaint(g, x, y);
+    if (largest)
+        find_largest_area(p);
     g->board[x][y].visited = true;
     devisit(g, x, y);
 }
@@ -1089,21 +1697,21 @@ static void afc_expand_others(gamma_t *g, uint32_t x, uint32_t y) {
     uint32_t p3 = UINT32_MAX;
 
     if (x > 0) {
-        if (!(g->board[x - 1][y].free)) {
+        if (g->board[x - 1][y].busy) {
             p1 = g->board[x - 1][y].taken;
             g->players[p1].adjacent_free_count++;
         }
     }
 
     if (x < g->width - 1) {
-        if (!(g->board[x + 1][y].free) && g->board[x + 1][y].taken != p1) {
+        if (g->board[x + 1][y].busy && g->board[x + 1][y].taken != p1) {
             p2 = g->board[x + 1][y].taken;
             g->players[p2].adjacent_free_count++;
         }
     }
 
     if (y > 0) {
-        if (!(g->board[x][y - 1].free) && g->board[x][y - 1].taken != p1
+        if (g->board[x][y - 1].busy && g->board[x][y - 1].taken != p1
             && g->board[x][y - 1].taken != p2) {
             p3 = g->board[x][y - 1].taken;
             g->players[p3].adjacent_free_count++;
@@ -1111,7 +1719,7 @@ static void afc_expand_others(gamma_t *g, uint32_t x, uint32_t y) {
     }
 
     if (y < g->height - 1) {
-        if (!(g->board[x][y + 1].free) && g->board[x][y + 1].taken != p1
+        if (g->board[x][y + 1].busy && g->board[x][y + 1].taken != p1
             && g->board[x][y + 1].taken != p2 && g->board[x][y + 1].taken != p3) {
             g->players[g->board[x][y + 1].taken].adjacent_free_count++;
         }
@@ -1130,22 +1738,22 @@ static inline void afc_dimnish(gamma_t *g, uint32_t x, uint32_t y) {
     uint32_t p = g->board[x][y].taken + 1;
 
     if (x > 0) {
-        if (g->board[x - 1][y].free && how_many_neighbours_owns(g, p, x - 1, y) < 1)
+        if (!g->board[x - 1][y].busy && how_many_neighbours_owns(g, p, x - 1, y) < 1)
             how_many++;
     }
 
     if (y > 0) {
-        if (g->board[x][y - 1].free && how_many_neighbours_owns(g, p, x, y - 1) < 1)
+        if (!g->board[x][y - 1].busy && how_many_neighbours_owns(g, p, x, y - 1) < 1)
             how_many++;
     }
 
     if (x < g->width - 1) {
-        if (g->board[x + 1][y].free && how_many_neighbours_owns(g, p, x + 1, y) < 1)
+        if (!g->board[x + 1][y].busy && how_many_neighbours_owns(g, p, x + 1, y) < 1)
             how_many++;
     }
 
     if (y < g->height - 1) {
-        if (g->board[x][y + 1].free && how_many_neighbours_owns(g, p, x, y + 1) < 1)
+        if (!g->board[x][y + 1].busy && how_many_neighbours_owns(g, p, x, y + 1) < 1)
             how_many++;
     }
 
@@ -1162,9 +1770,17 @@ static inline void afc_dimnish(gamma_t *g, uint32_t x, uint32_t y) {
 static inline void delete_pawn(gamma_t *g, uint32_t x, uint32_t y) {
     g->free_fields_count++;
     g->players[g->board[x][y].taken].fields_count--;
-    g->board[x][y].free = true;
+    rank_down(g, g->board[x][y].taken);
+    update_perimeter(g, g->board[x][y].taken + 1, x, y, false);
+    g->board[x][y].busy = false;
+    g->hash ^= field_key(g->board[x][y].taken + 1, x, y);
+    record_change(g, x, y);
+    g->golden_epoch++;
     afc_dimnish(g, x, y);
     afc_expand_others(g, x, y);
+
+    if (g->observer.removed != NULL)
+        g->observer.removed(g->observer_ctx, g->board[x][y].taken + 1, x, y);
 }
 
 
@@ -1187,6 +1803,7 @@ static bool switch_pawns(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
         return false;
     } else {
         g->players[player - 1].golden_move = false;
+        g->hash ^= golden_key(player);
         delete_pawn(g, x, y);
         manage_areas(g, x, y);
         return place_pawn(g, player, x, y);
@@ -1194,17 +1811,87 @@ static bool switch_pawns(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
 }
 
 
-/** @brief Sprawdza czy jakikolwiek inny gracz zajmuje pole.
- * Bada czy gracz inny od @p player zajmuje jakiekolwiek pole w @p g.
+/** @brief Liczy wolne pola, z którymi gracz przestałby sąsiadować.
+ * Odpowiada @ref afc_dimnish wywołanej po zabraniu pionka z pola
+ * (@p x, @p y), ale nie zmienia planszy.
  * @param[in] g      – wskaźnik na grę, @ref gamma_t,
- * @param[in] player – numer gracza, liczba dodatnia.
- * @return Wartość @p true jeżeli w @p g istnieje pole zajmowane przez gracza
- * różnego od @p player, w przeciwnym wypadku @p false.
+ * @param[in] x      – odcięta zajętego pola, liczba nieujemna,
+ * @param[in] y      – rzędna zajętego pola, liczba nieujemna.
+ * @return Liczba wolnych sąsiadów pola (@p x, @p y), z którymi gracz
+ * zajmujący to pole sąsiaduje jedynie przez nie; liczba z przedziału [0, 4].
  */
-static bool another_player_has_a_field(gamma_t *g, uint32_t player) {
-    return (g->players[player - 1].fields_count
-            + g->free_fields_count < g->width * g->height);
-}
+static uint64_t afc_loss(gamma_t *g, uint32_t x, uint32_t y) {
+    uint64_t how_many = 0;
+    uint32_t p = g->board[x][y].taken + 1;
+
+    /* Samo pole (x, y) jest jeszcze zajęte przez gracza p */
+    if (x > 0) {
+        if (!g->board[x - 1][y].busy && how_many_neighbours_owns(g, p, x - 1, y) < 2)
+            how_many++;
+    }
+
+    if (y > 0) {
+        if (!g->board[x][y - 1].busy && how_many_neighbours_owns(g, p, x, y - 1) < 2)
+            how_many++;
+    }
+
+    if (x < g->width - 1) {
+        if (!g->board[x + 1][y].busy && how_many_neighbours_owns(g, p, x + 1, y) < 2)
+            how_many++;
+    }
+
+    if (y < g->height - 1) {
+        if (!g->board[x][y + 1].busy && how_many_neighbours_owns(g, p, x, y + 1) < 2)
+            how_many++;
+    }
+
+    return how_many;
+}
+
+
+/** @brief Liczy części obszaru po zabraniu pola.
+ * @param[in] g      – wskaźnik na grę, @ref gamma_t,
+ * @param[in] x      – odcięta zajętego pola, liczba nieujemna,
+ * @param[in] y      – rzędna zajętego pola, liczba nieujemna.
+ * @return Liczba części, na które rozpadłby się obszar zawierający pole
+ * (@p x, @p y) po zabraniu z niego pionka; liczba z przedziału [0, 4].
+ */
+static uint32_t split_parts(gamma_t *g, uint32_t x, uint32_t y) {
+    uint32_t player = g->board[x][y].taken + 1;
+    uint32_t many = how_many_neighbours_owns(g, player, x, y);
+
+    if (many <= 1)
+        return many; /* jeden sąsiad nie może się rozdzielić */
+    else
+        return explore_neighbouring_area(g, player, x, y) + 1
+               - g->players[player - 1].areas_count;
+}
+
+
+/** @brief Podaje wynik @ref gamma_free_fields dla zadanego stanu gracza.
+ * @param[in] g          – wskaźnik na grę, @ref gamma_t,
+ * @param[in] areas      – liczba obszarów gracza,
+ * @param[in] adjacent   – liczba wolnych pól sąsiadujących z graczem,
+ * @param[in] free_count – liczba wolnych pól planszy.
+ * @return Liczba pól, które gracz mógłby zająć zwykłym ruchem.
+ */
+static inline uint64_t free_fields_of(gamma_t *g, uint32_t areas,
+                                      uint64_t adjacent, uint64_t free_count) {
+    return areas >= g->max_areas ? adjacent : free_count;
+}
+
+
+/** @brief Sprawdza czy jakikolwiek inny gracz zajmuje pole.
+ * Bada czy gracz inny od @p player zajmuje jakiekolwiek pole w @p g.
+ * @param[in] g      – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Wartość @p true jeżeli w @p g istnieje pole zajmowane przez gracza
+ * różnego od @p player, w przeciwnym wypadku @p false.
+ */
+static bool another_player_has_a_field(gamma_t *g, uint32_t player) {
+    return (g->players[player - 1].fields_count
+            + g->free_fields_count < g->width * g->height);
+}
 
 
 /** @brief Sprawdza poprawność danych game i player.
@@ -1289,10 +1976,53 @@ static inline void free_players(player_t **p, uint32_t pc) {
 }
 
 
+/** @brief Alokuje wyzerowane pola planszy.
+ * Małe plansze są alokowane przez calloc. Większe są mapowane
+ * anonimowo, z prośbą o duże strony; strony są wtedy zerowane przez system
+ * dopiero przy pierwszym dostępie.
+ * @param[in] fields   – liczba pól, liczba dodatnia,
+ * @param[out] mapped  – rozmiar mapowania lub @p 0 dla calloc.
+ * @return Wskaźnik na pola lub NULL, gdy zabrakło pamięci.
+ */
+static field_t *allocate_fields(uint64_t fields, size_t *mapped) {
+    uint64_t size = fields * sizeof(field_t);
+    void *block;
+
+    *mapped = 0;
+    if (size < HUGE_PAGE_SIZE)
+        return calloc(fields, sizeof(field_t));
+
+    size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    block = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED)
+        return NULL;
+
+    /* Bez przezroczystych dużych stron mapowanie działa na zwykłych */
+    madvise(block, size, MADV_HUGEPAGE);
+    *mapped = size;
+
+    return block;
+}
+
+
+/** @brief Zwalnia pola planszy zaalokowane przez @ref allocate_fields.
+ * @param[in] fields  – wskaźnik na pola lub NULL,
+ * @param[in] mapped  – rozmiar mapowania lub @p 0 dla calloc.
+ */
+static void release_fields(field_t *fields, size_t mapped) {
+    if (mapped != 0)
+        munmap(fields, mapped);
+    else
+        free(fields);
+}
+
+
 /** @brief Alokuje pamięć na planszę.
- * Alokuje pamięć potrzebną na tablicę 2D o wymiarach @p width x @p height
- * Jeżeli alokacja się nie powiedzie, zwalnia również pamięć zalokowaną przez
- * @ref allocate_game_and_players.
+ * Alokuje pamięć potrzebną na tablicę 2D o wymiarach @p width x @p height.
+ * Pola leżą w jednym wyzerowanym bloku kolumna po kolumnie, a @p *board
+ * wskazuje początki kolumn. Jeżeli alokacja się nie powiedzie, zwalnia
+ * również pamięć zalokowaną przez @ref allocate_game_and_players.
  * @param[in,out] board   – wskaźnik na planszę,
  *                          wskaźnik na wskaźnik na @ref field_t,
  * @param[in,out] game    – wskaźnik do tworzonej gry, @ref gamma_t,
@@ -1300,54 +2030,30 @@ static inline void free_players(player_t **p, uint32_t pc) {
  * @param[in] width       – szerokość planszy, liczba dodatnia,
  * @param[in] height      – wysokość planszy, liczba dodatnia.
  * @param[in] pc 		  – liczba graczy w tworzonej grze, liczba dodatnia,
+ * @param[out] mapped     – rozmiar mapowania pól, @ref allocate_fields.
  * @return Wartość @p true jeśli alokacja przebiegła pomyślnie, natomiast
  * @p false jeżeli zabrakło pamięci.
  */
 static bool allocate_board(field_t ***board, gamma_t **game,
                            player_t **players, uint32_t width,
-                           uint32_t height, uint32_t pc) {
+                           uint32_t height, uint32_t pc, size_t *mapped) {
+    field_t *fields = allocate_fields((uint64_t) width * height, mapped);
+
     *board = malloc(width * sizeof(field_t *));
-    if (*board == NULL) {
+    if (*board == NULL || fields == NULL) {
+        free(*board);
+        release_fields(fields, *mapped);
         free_players(players, pc);
         free(*game);
         return false;
     }
-    for (uint32_t i = 0; i < width; i++) {
-        (*board)[i] = malloc(height * sizeof(field_t));
-        if ((*board)[i] == NULL) {
-            while (i >= 1) {
-                free((*board)[i - 1]);
-                i--;
-            }
-            free_players(players, pc);
-            free(*game);
-            return false;
-        }
-    }
+    for (uint32_t i = 0; i < width; i++)
+        (*board)[i] = fields + (uint64_t) i * height;
 
     return true;
 }
 
 
-/** @brief Inicjalizuje planszę.
- * Ustawia pola planszy utworzonej w @ref gamma_new na startowe;
- * takie jak w @ref field_t.
- * @param[in,out] board  – plansza, tablica 2D typu @ref field_t,
- * @param[in] width      – szerokość planszy, liczba dodatnia,
- * @param[in] height     – wysokość planszy, liczba dodatnia.
- */
-static void init_board(field_t **board, uint32_t width, uint32_t height) {
-    for (uint32_t x = 0; x < width; x++) {
-        for (uint32_t y = 0; y < height; y++) {
-            board[x][y].taken = 0;
-            board[x][y].area = 0;
-            board[x][y].free = true;
-            board[x][y].visited = false;
-        }
-    }
-}
-
-
 /** @brief Inicjalizuje tablicę graczy.
  * Ustawia wartości pól tablicy graczy nowo utworzonej w @ref gamma_new
  * na startowe; takie jak w @ref player_t.
@@ -1364,11 +2070,22 @@ static void init_players(player_t *players_arr, uint32_t n_players,
         for (uint32_t j = 0; j < max_areas; j++) {
             players_arr[i].area_fields_count[j] = 0;
         }
-        players_arr[i].lowest_free_id = UINT32_MAX;
-        players_arr[i].highest_freed_id = 0;
+        players_arr[i].free_area = NO_AREA;
+        players_arr[i].unused_area = 0;
         players_arr[i].adjacent_free_count = 0;
         players_arr[i].fields_count = 0;
         players_arr[i].areas_count = 0;
+        players_arr[i].golden_version = UINT64_MAX;
+        players_arr[i].golden_possible = false;
+        players_arr[i].golden_epoch = 0;
+        players_arr[i].golden_stamp = UINT64_MAX;
+        players_arr[i].loose_stamp = 0;
+        players_arr[i].witness_x = UINT32_MAX;
+        players_arr[i].witness_y = UINT32_MAX;
+        players_arr[i].perimeter = 0;
+        players_arr[i].largest_area = 0;
+        memset(players_arr[i].area_sizes, 0,
+               sizeof(players_arr[i].area_sizes));
     }
 }
 
@@ -1396,6 +2113,25 @@ static void init_game(gamma_t *game, field_t **board,
     game->width = width;
     game->height = height;
     game->max_areas = areas;
+    game->version = 0;
+    game->changes = NULL;
+    game->changes_count = 0;
+    game->changes_capacity = 0;
+    game->tracked_from = 0;
+    game->diff_version = 0;
+    game->hash = 0;
+    game->locks = NULL;
+    game->observer = (gamma_observer_t) {NULL};
+    game->observer_ctx = NULL;
+    game->shared = NULL;
+    game->shared_size = 0;
+    game->shared_name = NULL;
+    game->board_mapped = 0;
+    game->ranking = NULL;
+    game->groups = NULL;
+    game->free_group = NO_GROUP;
+    game->golden_epoch = 0;
+    game->loose_epoch = 0;
 }
 
 
@@ -1448,7 +2184,7 @@ static inline void fill_next_field(char *p, uint128_t *i, gamma_t *g,
     uint32_t digit = 0;
     uint32_t j = 0;
 
-    if (g->board[x][y].free) {
+    if (!g->board[x][y].busy) {
         for (j = 1; j < m; j++) {
             p[*i] = ' ';
             (*i)++;
@@ -1513,142 +2249,2164 @@ static bool golden_field_possible(gamma_t *g, uint32_t player,
 }
 
 
-gamma_t *gamma_new(uint32_t width, uint32_t height,
-                   uint32_t players, uint32_t areas) {
-    if (players == 0 || areas == 0 || width == 0 || height == 0)
-        return NULL;
+/** @brief Sprawdza, czy któryś z innych graczy może oddać dowolne pole.
+ * Zabranie pola dzieli obszar na co najwyżej cztery części, więc gracz
+ * mający o trzy obszary mniej niż wynosi limit może oddać każde swoje pole.
+ * @param[in] g      – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Wartość @p true jeżeli istnieje taki gracz różny od @p player
+ * zajmujący jakieś pole, @p false w przeciwnym wypadku.
+ */
+static bool another_player_can_lose_any_field(gamma_t *g, uint32_t player) {
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        if (i != player - 1 && g->players[i].fields_count > 0
+            && (uint64_t) g->players[i].areas_count + 3 <= g->max_areas)
+            return true;
+    }
 
-    trim_number_of_areas(width, height, &areas);
+    return false;
+}
 
-    gamma_t *new_game;
-    player_t *players_ar;
-    field_t **board;
 
-    if (!allocate_game_and_players(&new_game, &players_ar, players, areas))
-        return NULL;
+/** @brief Szuka pola, na które gracz może wykonać złoty ruch.
+ * Najpierw sprawdza pole znalezione poprzednio, potem przypadek, w którym
+ * pasuje dowolne pole innego gracza, a dopiero na końcu przegląda planszę.
+ * Znalezione pole zapamiętuje do następnego wywołania.
+ * @param[in,out] g  – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Wartość @p true jeżeli takie pole istnieje, @p false w przeciwnym
+ * wypadku.
+ */
+static bool find_golden_field(gamma_t *g, uint32_t player) {
+    player_t *p = &g->players[player - 1];
+    uint32_t wx = p->witness_x, wy = p->witness_y;
 
-    if (!allocate_board(&board, &new_game, &players_ar, width, height, players))
-        return NULL;
+    if (wx < g->width && wy < g->height && g->board[wx][wy].busy
+        && g->board[wx][wy].taken != player - 1
+        && golden_field_possible(g, player, wx, wy))
+        return true;
 
-    init_board(board, width, height);
-    init_players(players_ar, players, areas);
-    init_game(new_game, board, players_ar, width, height, players, areas);
+    if (!player_has_max_areas(g, player)
+        && another_player_can_lose_any_field(g, player))
+        return true;
 
-    return new_game;
+    for (uint32_t x = 0; x < g->width; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            if (g->board[x][y].busy && g->board[x][y].taken != player - 1
+                && golden_field_possible(g, player, x, y)) {
+                p->witness_x = x;
+                p->witness_y = y;
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
 
-void gamma_delete(gamma_t *g) {
-    if (g == NULL)
-        return;
+/** @brief Sprawdza, czy zapamiętany wynik złotego ruchu jest aktualny.
+ * Dodatni wynik trzeba sprawdzić po każdej zmianie planszy, ale zwykle
+ * wystarcza do tego zapamiętane pole. Brak pola pozostaje aktualny, dopóki
+ * nie było złotego ruchu, ruchu gracza @p player, ruchu obok jego pola ani
+ * ruchu na pole z co najmniej dwoma sąsiadami stawiającego, który mógłby
+ * zmniejszyć liczbę jego obszarów lub zamknąć cykl. Pozostałe ruchy dają
+ * pole z co najwyżej jednym sąsiadem właściciela, które jest celem tylko
+ * dla gracza bez maksymalnej liczby obszarów.
+ * @param[in] g      – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player – numer gracza, liczba dodatnia.
+ * @return Wartość @p true jeżeli @p golden_possible gracza jest aktualne,
+ * @p false w przeciwnym wypadku.
+ */
+static bool golden_answer_current(gamma_t *g, uint32_t player) {
+    player_t *p = &g->players[player - 1];
+
+    if (p->golden_version == g->version)
+        return true;
+    else if (p->golden_possible
+             || p->golden_stamp != g->golden_epoch + p->golden_epoch)
+        return false;
+    else
+        return player_has_max_areas(g, player)
+               || p->loose_stamp == g->loose_epoch;
+}
+
+
+/** @brief Wylicza skrót Zobrista pozycji od nowa.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ */
+static void compute_hash(gamma_t *g) {
+    g->hash = 0;
 
-    for (uint32_t i = 0; i < g->width; i++) {
-        free(g->board[i]);
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        if (!(g->players[i].golden_move))
+            g->hash ^= golden_key(i + 1);
     }
 
-    free(g->board);
-    free_players(&(g->players), g->players_count);
-    free(g);
+    for (uint32_t x = 0; x < g->width; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            if (g->board[x][y].busy)
+                g->hash ^= field_key(g->board[x][y].taken + 1, x, y);
+        }
+    }
 }
 
 
-bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    if (!correct_game_and_player(g, player)) {
-        return false;
-    } else if (!coordinates_correct(g, x, y)) {
-        return false;
-    } else if (!(g->board[x][y].free)) {
-        return false;
-    } else if (player_has_max_areas(g, player)
-               && how_many_neighbours_owns(g, player, x, y) == 0) {
-        return false;
-    } else {
-        return place_pawn(g, player, x, y);
+/** @brief Zaczyna prowadzić dziennik zmian.
+ * Jeżeli zabraknie pamięci, dziennik nie jest prowadzony.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ */
+static void start_tracking(gamma_t *g) {
+    g->changes = malloc(CHANGES_INITIAL_CAPACITY * sizeof(change_t));
+    if (g->changes == NULL)
+        return;
+
+    g->changes_count = 0;
+    g->changes_capacity = CHANGES_INITIAL_CAPACITY;
+    g->tracked_from = g->version;
+}
+
+
+/** @brief Kopiuje właścicieli pól prostokąta planszy wierszami.
+ * Plansza jest przechowywana kolumnami, więc prostokąt jest kopiowany
+ * kwadratami o boku @ref EXPORT_TILE, żeby zapisywane wiersze kwadratu
+ * mieściły się w pamięci podręcznej.
+ * @param[in] g      – wskaźnik na grę, @ref gamma_t,
+ * @param[in] x      – odcięta lewego dolnego pola prostokąta,
+ * @param[in] y      – rzędna lewego dolnego pola prostokąta,
+ * @param[in] w      – szerokość prostokąta,
+ * @param[in] h      – wysokość prostokąta,
+ * @param[out] out   – tablica, element o indeksie @p j * @p stride + @p i
+ *                     dostaje właściciela pola (@p x + @p i, @p y + @p j),
+ * @param[in] stride – odległość między początkami wierszy w @p out,
+ * @param[in] size   – rozmiar elementu @p out w bajtach: 1, 2 lub 4.
+ */
+static void export_block(gamma_t *g, uint32_t x, uint32_t y,
+                         uint32_t w, uint32_t h, void *out,
+                         size_t stride, size_t size) {
+    for (uint32_t ty = 0; ty < h; ty += EXPORT_TILE) {
+        uint32_t th = h - ty < EXPORT_TILE ? h - ty : EXPORT_TILE;
+
+        for (uint32_t tx = 0; tx < w; tx += EXPORT_TILE) {
+            uint32_t tw = w - tx < EXPORT_TILE ? w - tx : EXPORT_TILE;
+
+            for (uint32_t i = tx; i < tx + tw; i++) {
+                const field_t *column = g->board[x + i] + y;
+
+                switch (size) {
+                    case 1:
+                        for (uint32_t j = ty; j < ty + th; j++)
+                            ((uint8_t *) out)[j * stride + i] = (uint8_t)
+                                (column[j].busy ? column[j].taken + 1 : 0);
+                        break;
+                    case 2:
+                        for (uint32_t j = ty; j < ty + th; j++)
+                            ((uint16_t *) out)[j * stride + i] = (uint16_t)
+                                (column[j].busy ? column[j].taken + 1 : 0);
+                        break;
+                    default:
+                        for (uint32_t j = ty; j < ty + th; j++)
+                            ((uint32_t *) out)[j * stride + i] =
+                                column[j].busy ? column[j].taken + 1 : 0;
+                        break;
+                }
+            }
+        }
     }
 }
 
 
-bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    if (!correct_game_and_player(g, player))
-        return false;
-    else if (!coordinates_correct(g, x, y))
+/** @brief Kopiuje właścicieli wszystkich pól planszy wierszami.
+ * @param[in] g         – wskaźnik na grę, @ref gamma_t,
+ * @param[out] out      – tablica jak w @ref gamma_export_owners,
+ * @param[in] stride    – odległość między początkami wierszy w @p out,
+ * @param[in] size      – rozmiar elementu @p out w bajtach: 1, 2 lub 4,
+ * @param[in] max_owner – największy numer gracza mieszczący się
+ *                        w elemencie @p out.
+ * @return Wartość @p true, jeśli plansza została skopiowana, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+static bool export_owners(gamma_t *g, void *out, size_t stride,
+                          size_t size, uint32_t max_owner) {
+    if (g == NULL || out == NULL || stride < g->width
+        || g->players_count > max_owner)
         return false;
-    else if (!(g->players[player - 1].golden_move) || g->board[x][y].free)
+
+    export_block(g, 0, 0, g->width, g->height, out, stride, size);
+
+    return true;
+}
+
+
+/** @brief Wypisuje wszystkie zajęte pola planszy.
+ * @param[in] g        – wskaźnik na grę, @ref gamma_t,
+ * @param[out] changes – zaalokowana tablica zajętych pól,
+ * @param[out] count   – długość tablicy @p changes.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+static bool list_taken_fields(gamma_t *g, gamma_change_t **changes,
+                              uint64_t *count) {
+    uint64_t n = (uint64_t) g->width * g->height - g->free_fields_count;
+    uint64_t i = 0;
+
+    *changes = malloc((n > 0 ? n : 1) * sizeof(gamma_change_t));
+    if (*changes == NULL)
         return false;
-    else if (g->board[x][y].taken == player - 1)
+
+    for (uint32_t x = 0; x < g->width; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            if (g->board[x][y].busy) {
+                (*changes)[i].x = x;
+                (*changes)[i].y = y;
+                (*changes)[i].owner = g->board[x][y].taken + 1;
+                i++;
+            }
+        }
+    }
+
+    *count = i;
+
+    return true;
+}
+
+
+/** @brief Wypisuje pola zmienione po danej wersji na podstawie dziennika.
+ * Każde pole występuje co najwyżej raz, w kolejności ostatniej zmiany.
+ * @param[in] g        – wskaźnik na grę, @ref gamma_t,
+ * @param[in] version  – wersja, od której szukamy zmian,
+ *                       nie mniejsza od początku dziennika,
+ * @param[out] changes – zaalokowana tablica zmienionych pól,
+ * @param[out] count   – długość tablicy @p changes.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+static bool list_changes(gamma_t *g, uint64_t version,
+                         gamma_change_t **changes, uint64_t *count) {
+    uint64_t low = 0, high = g->changes_count, n = 0;
+
+    /* Wersje wpisów w dzienniku są rosnące */
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (g->changes[mid].version <= version)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    *changes = malloc((g->changes_count - low > 0 ? g->changes_count - low : 1)
+                      * sizeof(gamma_change_t));
+    if (*changes == NULL)
         return false;
-    else
-        return switch_pawns(g, player, x, y);
+
+    for (uint64_t i = g->changes_count; i > low; i--) {
+        field_t *field = &g->board[g->changes[i - 1].x][g->changes[i - 1].y];
+        if (!field->visited) {
+            field->visited = true;
+            (*changes)[n].x = g->changes[i - 1].x;
+            (*changes)[n].y = g->changes[i - 1].y;
+            (*changes)[n].owner = field->busy ? field->taken + 1 : 0;
+            n++;
+        }
+    }
+
+    for (uint64_t i = 0; i < n; i++) {
+        g->board[(*changes)[i].x][(*changes)[i].y].visited = false;
+    }
+
+    /* Pola były zbierane od końca dziennika */
+    for (uint64_t i = 0; i < n / 2; i++) {
+        gamma_change_t c = (*changes)[i];
+        (*changes)[i] = (*changes)[n - 1 - i];
+        (*changes)[n - 1 - i] = c;
+    }
+
+    *count = n;
+
+    return true;
 }
 
 
-uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
-    if (!correct_game_and_player(g, player))
-        return 0;
-    else
-        return g->players[player - 1].fields_count;
+/** @brief Zapisuje wartość do pliku.
+ * @param[in] f    – plik, do którego zapisujemy,
+ * @param[in] v    – wskaźnik na zapisywaną wartość,
+ * @param[in] size – rozmiar wartości w bajtach.
+ * @return Wartość @p true jeżeli zapis się powiódł, @p false w przeciwnym
+ * wypadku.
+ */
+static inline bool save_value(FILE *f, const void *v, size_t size) {
+    return fwrite(v, size, 1, f) == 1;
 }
 
 
-uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
-    if (!correct_game_and_player(g, player))
-        return 0;
-    else if (player_has_max_areas(g, player))
-        return g->players[player - 1].adjacent_free_count;
-    else
-        return g->free_fields_count;
+/** @brief Wczytuje wartość z pliku.
+ * @param[in] f    – plik, z którego czytamy,
+ * @param[out] v   – wskaźnik na wczytywaną wartość,
+ * @param[in] size – rozmiar wartości w bajtach.
+ * @return Wartość @p true jeżeli odczyt się powiódł, @p false w przeciwnym
+ * wypadku.
+ */
+static inline bool load_value(FILE *f, void *v, size_t size) {
+    return fread(v, size, 1, f) == 1;
 }
 
 
-bool gamma_golden_possible(gamma_t *g, uint32_t player) {
-    if (!correct_game_and_player(g, player)) {
+/** @brief Zapisuje stan gracza.
+ * @param[in] f         – plik, do którego zapisujemy,
+ * @param[in] p         – zapisywany gracz, @ref player_t,
+ * @param[in] max_areas – maksymalna liczba obszarów gracza.
+ * @return Wartość @p true jeżeli zapis się powiódł, @p false w przeciwnym
+ * wypadku.
+ */
+static bool save_player(FILE *f, const player_t *p, uint32_t max_areas) {
+    uint8_t golden = p->golden_move;
+
+    return (save_value(f, &golden, sizeof(golden))
+            && save_value(f, &p->free_area, sizeof(uint32_t))
+            && save_value(f, &p->unused_area, sizeof(uint32_t))
+            && save_value(f, &p->adjacent_free_count, sizeof(uint64_t))
+            && save_value(f, &p->fields_count, sizeof(uint32_t))
+            && save_value(f, &p->areas_count, sizeof(uint32_t))
+            && fwrite(p->area_fields_count, sizeof(uint64_t),
+                      max_areas, f) == max_areas);
+}
+
+
+/** @brief Sprawdza listę wolnych numerów obszarów wczytanego gracza.
+ * @param[in] p         – wczytany gracz, @ref player_t,
+ * @param[in] max_areas – maksymalna liczba obszarów gracza.
+ * @return Wartość @p true jeżeli lista kończy się po co najwyżej
+ * @p unused_area - @p areas_count krokach i zawiera jedynie numery mniejsze
+ * od @p unused_area, @p false w przeciwnym wypadku.
+ */
+static bool free_areas_correct(const player_t *p, uint32_t max_areas) {
+    uint32_t area = p->free_area;
+    uint32_t steps = 0;
+
+    if (p->unused_area > max_areas || p->areas_count > p->unused_area)
         return false;
-    } else if (!(g->players[player - 1].golden_move
-                 && another_player_has_a_field(g, player))) {
+
+    while (area != NO_AREA) {
+        if (area >= p->unused_area || steps == p->unused_area - p->areas_count)
+            return false;
+        area = (uint32_t) p->area_fields_count[area];
+        steps++;
+    }
+
+    return true;
+}
+
+
+/** @brief Wczytuje stan gracza zapisany przez @ref save_player.
+ * @param[in] f         – plik, z którego czytamy,
+ * @param[in,out] p     – wczytywany gracz z zaalokowaną tablicą obszarów,
+ * @param[in] max_areas – maksymalna liczba obszarów gracza,
+ * @param[in] version   – wersja formatu zapisu.
+ * @return Wartość @p true jeżeli odczyt się powiódł i dane są spójne,
+ * @p false w przeciwnym wypadku.
+ */
+static bool load_player(FILE *f, player_t *p, uint32_t max_areas,
+                        uint32_t version) {
+    uint8_t golden;
+
+    if (!(load_value(f, &golden, sizeof(golden))
+          && load_value(f, &p->free_area, sizeof(uint32_t))
+          && load_value(f, &p->unused_area, sizeof(uint32_t))
+          && load_value(f, &p->adjacent_free_count, sizeof(uint64_t))
+          && load_value(f, &p->fields_count, sizeof(uint32_t))
+          && load_value(f, &p->areas_count, sizeof(uint32_t))
+          && fread(p->area_fields_count, sizeof(uint64_t),
+                   max_areas, f) == max_areas))
         return false;
-    } else {
-        for (uint32_t x = 0; x < g->width; x++) {
-            for (uint32_t y = 0; y < g->height; y++) {
-                if (!(g->board[x][y].free)
-                    && g->board[x][y].taken != player - 1) {
-                    if (golden_field_possible(g, player, x, y))
-                        return true;
-                }
-            }
-        }
+
+    p->golden_move = golden != 0;
+
+    if (golden > 1 || p->areas_count > max_areas)
         return false;
+
+    /* Obszary z zapisu w starszej wersji są wyznaczane od nowa */
+    return version == GAMMA_SAVE_VERSION_SCAN
+           || free_areas_correct(p, max_areas);
+}
+
+
+/** @brief Wyznacza statystyki graczy od nowa.
+ * Obwód jest liczony z planszy, a histogram i największy obszar z liczb pól
+ * używanych obszarów.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ */
+static void compute_stats(gamma_t *g) {
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        player_t *p = &g->players[i];
+
+        p->perimeter = 0;
+        p->largest_area = 0;
+        memset(p->area_sizes, 0, sizeof(p->area_sizes));
+
+        for (uint32_t area = 0; area < p->unused_area; area++) {
+            if (!(p->area_fields_count[area] & FREE_AREA_TAG))
+                count_area(p, p->area_fields_count[area]);
+        }
+    }
+
+    for (uint32_t x = 0; x < g->width; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            uint32_t player = g->board[x][y].taken + 1;
+
+            if (g->board[x][y].busy)
+                g->players[player - 1].perimeter +=
+                    4 - (uint64_t) how_many_neighbours_owns(g, player, x, y);
+        }
     }
 }
 
 
-char *gamma_board(gamma_t *g) {
-    if (g == NULL)
-        return NULL;
+/** @brief Przelicza pola obszarów wczytanej gry.
+ * Oznacza listę wolnych numerów, sprawdzanej już przez
+ * @ref free_areas_correct, i liczy pola używanych obszarów z planszy,
+ * po czym wyznacza statystyki graczy i ranking.
+ * @param[in,out] g   – wskaźnik na wczytaną grę, @ref gamma_t.
+ * @return Wartość @p true jeżeli każde zajęte pole należy do używanego
+ * obszaru, a każdy z @p areas_count używanych obszarów ma pola, razem
+ * @p fields_count, @p false w przeciwnym wypadku.
+ */
+static bool recount_areas(gamma_t *g) {
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        player_t *p = &g->players[i];
+        uint32_t area = p->free_area;
 
-    uint32_t multip = get_number_of_digits(g->players_count);
-    uint128_t i = (multip * (g->width) + 1) * (g->height);
+        while (area != NO_AREA) {
+            uint32_t next = (uint32_t) p->area_fields_count[area];
 
-    char *p = malloc((i + 1) * sizeof(char));
-    if (p == NULL)
-        return NULL;
+            p->area_fields_count[area] = FREE_AREA_TAG | next;
+            area = next;
+        }
 
-    i = 0;
-    for (uint32_t y = g->height; y >= 1; y--) {
-        for (uint32_t x = 0; x < g->width; x++) {
-            fill_next_field(p, &i, g, x, y - 1, multip);
+        for (area = 0; area < p->unused_area; area++) {
+            if (!(p->area_fields_count[area] & FREE_AREA_TAG))
+                p->area_fields_count[area] = 0;
         }
-        p[i] = '\n';
-        i++;
     }
-    p[i] = '\0';
 
-    return p;
-}
+    for (uint32_t x = 0; x < g->width; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            field_t *field = &g->board[x][y];
+            player_t *p = &g->players[field->taken];
 
+            if (!field->busy)
+                continue;
 
-uint32_t gamma_whose_field(gamma_t *g, uint32_t x, uint32_t y) {
-    if (g == NULL || x >= g->width || y >= g->height || g->board[x][y].free)
-        return 0;
-    else
-        return g->board[x][y].taken + 1;
+            if (field->area >= p->unused_area
+                || (p->area_fields_count[field->area] & FREE_AREA_TAG))
+                return false;
+
+            p->area_fields_count[field->area]++;
+        }
+    }
+
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        player_t *p = &g->players[i];
+        uint32_t live = 0;
+        uint64_t fields = 0;
+
+        for (uint32_t area = 0; area < p->unused_area; area++) {
+            if (p->area_fields_count[area] == 0)
+                return false;
+            if (!(p->area_fields_count[area] & FREE_AREA_TAG)) {
+                live++;
+                fields += p->area_fields_count[area];
+            }
+        }
+
+        if (live != p->areas_count || fields != p->fields_count)
+            return false;
+    }
+
+    compute_stats(g);
+    build_ranking(g);
+
+    return true;
+}
+
+
+/** @brief Zapisuje kolumnę planszy.
+ * Dla każdego pola zapisuje numer gracza - 1, numer obszaru i bajt
+ * wolności pola. Znacznik odwiedzenia nie jest zapisywany, bo poza
+ * funkcjami modyfikującymi planszę zawsze ma wartość @p false.
+ * @param[in] f      – plik, do którego zapisujemy,
+ * @param[in] column – zapisywana kolumna planszy,
+ * @param[in] height – wysokość planszy, liczba dodatnia.
+ * @return Wartość @p true jeżeli zapis się powiódł, @p false w przeciwnym
+ * wypadku.
+ */
+static bool save_column(FILE *f, const field_t *column, uint32_t height) {
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t free_field = !column[y].busy;
+
+        if (!(save_value(f, &column[y].taken, sizeof(uint32_t))
+              && save_value(f, &column[y].area, sizeof(uint32_t))
+              && save_value(f, &free_field, sizeof(free_field))))
+            return false;
+    }
+
+    return true;
+}
+
+
+/** @brief Wczytuje kolumnę planszy zapisaną przez @ref save_column.
+ * @param[in] f         – plik, z którego czytamy,
+ * @param[out] column   – wczytywana kolumna planszy,
+ * @param[in] g         – wskaźnik na grę, @ref gamma_t.
+ * @return Wartość @p true jeżeli odczyt się powiódł i dane są spójne,
+ * @p false w przeciwnym wypadku.
+ */
+static bool load_column(FILE *f, field_t *column, gamma_t *g) {
+    for (uint32_t y = 0; y < g->height; y++) {
+        uint8_t free_field;
+
+        if (!(load_value(f, &column[y].taken, sizeof(uint32_t))
+              && load_value(f, &column[y].area, sizeof(uint32_t))
+              && load_value(f, &free_field, sizeof(free_field))))
+            return false;
+
+        if (free_field > 1 || column[y].taken >= g->players_count
+            || column[y].area >= g->max_areas)
+            return false;
+
+        column[y].busy = free_field == 0;
+        column[y].visited = false;
+    }
+
+    return true;
+}
+
+
+/** @brief Zapisuje wersję gry i zmiany od ostatniego @ref gamma_diff.
+ * Zapisuje wersję gry, wersję z ostatniego @ref gamma_diff, bajt mówiący,
+ * czy dziennik zmian ją obejmuje, a jeżeli tak, to liczbę i wpisy
+ * dziennika nowsze od niej. Dziennik jest najpierw zagęszczany, więc
+ * wpisów jest najwyżej tyle, co pól planszy.
+ * @param[in] f       – plik, do którego zapisujemy,
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ * @return Wartość @p true jeżeli zapis się powiódł, @p false w przeciwnym
+ * wypadku.
+ */
+static bool save_log(FILE *f, gamma_t *g) {
+    uint8_t tracked = g->changes != NULL && g->diff_version >= g->tracked_from;
+    uint64_t first, count;
+
+    if (!(save_value(f, &g->version, sizeof(uint64_t))
+          && save_value(f, &g->diff_version, sizeof(uint64_t))
+          && save_value(f, &tracked, sizeof(tracked))))
+        return false;
+
+    if (!tracked)
+        return true;
+
+    compact_changes(g);
+    first = g->changes_count;
+    while (first > 0 && g->changes[first - 1].version > g->diff_version)
+        first--;
+
+    count = g->changes_count - first;
+    if (!save_value(f, &count, sizeof(count)))
+        return false;
+
+    for (uint64_t i = first; i < g->changes_count; i++) {
+        if (!(save_value(f, &g->changes[i].x, sizeof(uint32_t))
+              && save_value(f, &g->changes[i].y, sizeof(uint32_t))
+              && save_value(f, &g->changes[i].version, sizeof(uint64_t))))
+            return false;
+    }
+
+    return true;
+}
+
+
+/** @brief Wczytuje zapis @ref save_log.
+ * Dziennik wczytanej gry jest prowadzony od wersji z ostatniego
+ * @ref gamma_diff.
+ * @param[in] f       – plik, z którego czytamy,
+ * @param[in,out] g   – wskaźnik na wczytywaną grę, @ref gamma_t.
+ * @return Wartość @p true jeżeli odczyt się powiódł i dane są spójne,
+ * @p false w przeciwnym wypadku.
+ */
+static bool load_log(FILE *f, gamma_t *g) {
+    uint8_t tracked;
+    uint64_t count, capacity = CHANGES_INITIAL_CAPACITY;
+
+    if (!(load_value(f, &g->version, sizeof(uint64_t))
+          && load_value(f, &g->diff_version, sizeof(uint64_t))
+          && load_value(f, &tracked, sizeof(tracked)))
+        || g->diff_version > g->version || tracked > 1)
+        return false;
+
+    g->tracked_from = g->version;
+    if (!tracked)
+        return true;
+
+    if (!load_value(f, &count, sizeof(count))
+        || count > (uint64_t) g->width * g->height)
+        return false;
+
+    while (capacity < count)
+        capacity *= 2;
+
+    g->changes = malloc(capacity * sizeof(change_t));
+    if (g->changes == NULL)
+        return false;
+    g->changes_capacity = capacity;
+    g->changes_count = 0;
+    g->tracked_from = g->diff_version;
+
+    for (uint64_t i = 0; i < count; i++) {
+        change_t *c = &g->changes[i];
+
+        if (!(load_value(f, &c->x, sizeof(uint32_t))
+              && load_value(f, &c->y, sizeof(uint32_t))
+              && load_value(f, &c->version, sizeof(uint64_t)))
+            || c->x >= g->width || c->y >= g->height
+            || c->version <= (i > 0 ? c[-1].version : g->diff_version)
+            || c->version > g->version)
+            return false;
+
+        g->changes_count++;
+    }
+
+    return true;
+}
+
+
+/** @brief Szuka korzenia drzewa pola, skracając ścieżkę.
+ * Wolno ją wywołać jedynie dla pól, których drzew nie zmienia w tym
+ * samym czasie inny wątek.
+ * @param[in,out] parent – las Find-Union,
+ * @param[in] i          – indeks pola.
+ * @return Indeks korzenia drzewa pola @p i.
+ */
+static inline uint64_t find_root(uint64_t *parent, uint64_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+
+    return i;
+}
+
+
+/** @brief Łączy drzewa dwóch pól.
+ * Korzeniem połączonego drzewa zostaje mniejszy z korzeni, więc korzeń
+ * jest zawsze pierwszym polem obszaru w kolejności indeksów.
+ * @param[in,out] parent – las Find-Union,
+ * @param[in] i          – indeks pierwszego pola,
+ * @param[in] j          – indeks drugiego pola.
+ */
+static inline void union_fields(uint64_t *parent, uint64_t i, uint64_t j) {
+    uint64_t ri = find_root(parent, i), rj = find_root(parent, j);
+
+    if (ri < rj)
+        parent[rj] = ri;
+    else if (rj < ri)
+        parent[ri] = rj;
+}
+
+
+/** @brief Wypełnia pas planszy i łączy sąsiednie pola tego samego gracza.
+ * Pierwszy przebieg etykietowania, pola sąsiadujące z innymi pasami
+ * nie są łączone.
+ * @param[in,out] arg – wskaźnik na pas, @ref stripe_t.
+ * @return Wartość NULL.
+ */
+static void *label_stripe(void *arg) {
+    stripe_t *s = arg;
+    gamma_t *g = s->g;
+
+    s->correct = true;
+
+    for (uint32_t x = s->from; x < s->to; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            uint32_t owner = s->owners[(uint64_t) y * g->width + x];
+            uint64_t i = (uint64_t) x * g->height + y;
+
+            s->parent[i] = i;
+            if (owner == 0)
+                continue;
+
+            if (owner > g->players_count) {
+                s->correct = false;
+                return NULL;
+            }
+
+            g->board[x][y].busy = true;
+            g->board[x][y].taken = owner - 1;
+
+            if (y > 0 && g->board[x][y - 1].busy
+                && g->board[x][y - 1].taken == owner - 1)
+                union_fields(s->parent, i, i - 1);
+
+            if (x > s->from && g->board[x - 1][y].busy
+                && g->board[x - 1][y].taken == owner - 1)
+                union_fields(s->parent, i, i - g->height);
+        }
+    }
+
+    return NULL;
+}
+
+
+/** @brief Wyznacza korzenie drzew pól pasa.
+ * Drugi przebieg etykietowania, las nie jest już zmieniany.
+ * @param[in,out] arg – wskaźnik na pas, @ref stripe_t.
+ * @return Wartość NULL.
+ */
+static void *resolve_stripe(void *arg) {
+    stripe_t *s = arg;
+    uint64_t height = s->g->height;
+
+    for (uint64_t i = s->from * height; i < s->to * height; i++) {
+        uint64_t r = i;
+
+        while (s->parent[r] != r)
+            r = s->parent[r];
+        s->root[i] = r;
+    }
+
+    return NULL;
+}
+
+
+/** @brief Wywołuje funkcję dla każdego pasa w osobnym wątku.
+ * Pierwszy pas, a także pasy, dla których nie udało się utworzyć wątku,
+ * są przetwarzane przez wątek wywołujący.
+ * @param[in,out] stripes – tablica pasów, @ref stripe_t,
+ * @param[in] count       – liczba pasów, liczba dodatnia,
+ * @param[in] work        – funkcja przetwarzająca pas.
+ */
+static void run_stripes(stripe_t *stripes, uint32_t count,
+                        void *(*work)(void *)) {
+    for (uint32_t i = 1; i < count; i++) {
+        stripes[i].started = pthread_create(&stripes[i].thread, NULL, work,
+                                            &stripes[i]) == 0;
+    }
+
+    work(&stripes[0]);
+
+    for (uint32_t i = 1; i < count; i++) {
+        if (stripes[i].started)
+            pthread_join(stripes[i].thread, NULL);
+        else
+            work(&stripes[i]);
+    }
+}
+
+
+/** @brief Przydziela obszary i liczniki graczy na podstawie korzeni pól.
+ * Pola są przeglądane w kolejności indeksów, więc korzeń obszaru dostaje
+ * numer przed pozostałymi polami obszaru.
+ * @param[in,out] g  – wskaźnik na grę, @ref gamma_t,
+ * @param[in] root   – korzenie drzew pól o indeksach x * height + y.
+ * @return Wartość @p true, jeżeli żaden gracz nie przekroczył maksymalnej
+ * liczby obszarów, @p false w przeciwnym wypadku.
+ */
+static bool count_imported(gamma_t *g, const uint64_t *root) {
+    for (uint32_t x = 0; x < g->width; x++) {
+        for (uint32_t y = 0; y < g->height; y++) {
+            uint64_t i = (uint64_t) x * g->height + y;
+            field_t *field = &g->board[x][y];
+            player_t *p;
+
+            if (!field->busy) {
+                afc_expand_others(g, x, y);
+                continue;
+            }
+
+            p = &g->players[field->taken];
+            g->free_fields_count--;
+            p->fields_count++;
+
+            if (root[i] == i) {
+                if (p->areas_count == g->max_areas)
+                    return false;
+                field->area = get_next_area(g, field->taken + 1);
+            } else {
+                field->area = g->board[root[i] / g->height]
+                                      [root[i] % g->height].area;
+            }
+
+            p->area_fields_count[field->area]++;
+        }
+    }
+
+    return true;
+}
+
+
+gamma_t *gamma_new(uint32_t width, uint32_t height,
+                   uint32_t players, uint32_t areas) {
+    if (players == 0 || areas == 0 || width == 0 || height == 0)
+        return NULL;
+
+    trim_number_of_areas(width, height, &areas);
+
+    gamma_t *new_game;
+    player_t *players_ar;
+    field_t **board;
+    size_t mapped;
+
+    if (!allocate_game_and_players(&new_game, &players_ar, players, areas))
+        return NULL;
+
+    if (!allocate_board(&board, &new_game, &players_ar, width, height, players,
+                        &mapped))
+        return NULL;
+
+    init_players(players_ar, players, areas);
+    init_game(new_game, board, players_ar, width, height, players, areas);
+    new_game->board_mapped = mapped;
+
+    new_game->ranking = malloc(players * sizeof(uint32_t));
+    new_game->groups = malloc(((uint64_t) players + 1) * sizeof(rank_group_t));
+    if (new_game->ranking == NULL || new_game->groups == NULL) {
+        gamma_delete(new_game);
+        return NULL;
+    }
+    build_ranking(new_game);
+
+    return new_game;
+}
+
+
+gamma_t *gamma_new_from_owners(uint32_t width, uint32_t height,
+                               uint32_t players, uint32_t areas,
+                               const uint32_t *owners) {
+    uint64_t fields = (uint64_t) width * height;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t count = fields / IMPORT_FIELDS_PER_THREAD;
+    gamma_t *g;
+    stripe_t *stripes;
+    uint64_t *parent, *root;
+    bool correct = true;
+
+    if (owners == NULL)
+        return NULL;
+
+    g = gamma_new(width, height, players, areas);
+    if (g == NULL)
+        return NULL;
+
+    /* Duże plansze mają co najmniej dwa pasy na każdej maszynie, a pasy
+     * muszą mieć co najmniej jedną kolumnę */
+    if (count > (uint64_t) (cpus > 2 ? cpus : 2))
+        count = cpus > 2 ? (uint64_t) cpus : 2;
+    if (count > width)
+        count = width;
+    if (count == 0)
+        count = 1;
+
+    stripes = malloc(count * sizeof(stripe_t));
+    parent = malloc(fields * sizeof(uint64_t));
+    root = malloc(fields * sizeof(uint64_t));
+    if (stripes == NULL || parent == NULL || root == NULL) {
+        free(stripes);
+        free(parent);
+        free(root);
+        gamma_delete(g);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        stripes[i].g = g;
+        stripes[i].owners = owners;
+        stripes[i].parent = parent;
+        stripes[i].root = root;
+        stripes[i].from = (uint32_t) ((uint64_t) width * i / count);
+        stripes[i].to = (uint32_t) ((uint64_t) width * (i + 1) / count);
+    }
+
+    run_stripes(stripes, (uint32_t) count, label_stripe);
+
+    for (uint32_t i = 0; i < count; i++)
+        correct = correct && stripes[i].correct;
+
+    if (correct) {
+        /* Łączymy obszary przecinające granice pasów */
+        for (uint32_t i = 1; i < count; i++) {
+            uint32_t x = stripes[i].from;
+
+            for (uint32_t y = 0; y < height; y++) {
+                if (g->board[x][y].busy && g->board[x - 1][y].busy
+                    && g->board[x][y].taken == g->board[x - 1][y].taken)
+                    union_fields(parent, (uint64_t) x * height + y,
+                                 (uint64_t) (x - 1) * height + y);
+            }
+        }
+
+        run_stripes(stripes, (uint32_t) count, resolve_stripe);
+        correct = count_imported(g, root);
+    }
+
+    if (correct) {
+        compute_stats(g);
+        build_ranking(g);
+    }
+
+    free(stripes);
+    free(parent);
+    free(root);
+
+    if (!correct) {
+        gamma_delete(g);
+        return NULL;
+    }
+
+    compute_hash(g);
+
+    return g;
+}
+
+
+/** @brief Zwalnia blokady trybu współbieżnego.
+ * @param[in,out] l       – blokady, @ref locks_t,
+ * @param[in] tiles       – liczba zainicjowanych blokad fragmentów,
+ * @param[in] players     – liczba zainicjowanych blokad graczy.
+ */
+static void destroy_locks(locks_t *l, uint64_t tiles, uint32_t players) {
+    for (uint64_t i = 0; i < tiles; i++)
+        pthread_mutex_destroy(&l->tiles[i]);
+
+    for (uint32_t i = 0; i < players; i++)
+        pthread_mutex_destroy(&l->players[i]);
+
+    pthread_mutex_destroy(&l->shared);
+    pthread_rwlock_destroy(&l->board);
+    free(l->tiles);
+    free(l->players);
+    free(l);
+}
+
+
+/** @brief Tworzy blokady trybu współbieżnego.
+ * @param[in] g       – wskaźnik na grę, @ref gamma_t.
+ * @return Wskaźnik na blokady lub NULL, gdy nie udało się zaalokować
+ * pamięci lub zainicjować którejś blokady.
+ */
+static locks_t *create_locks(gamma_t *g) {
+    uint64_t columns = (g->width + CONCURRENT_TILE - 1) / CONCURRENT_TILE;
+    locks_t *l = malloc(sizeof(locks_t));
+    uint64_t tiles = 0;
+    uint32_t players = 0;
+
+    if (l == NULL)
+        return NULL;
+
+    l->tiles_height = (g->height + CONCURRENT_TILE - 1) / CONCURRENT_TILE;
+    l->tiles_count = columns * l->tiles_height;
+    l->tiles = malloc(l->tiles_count * sizeof(pthread_mutex_t));
+    l->players = malloc(g->players_count * sizeof(pthread_mutex_t));
+
+    if (l->tiles == NULL || l->players == NULL
+        || pthread_rwlock_init(&l->board, NULL) != 0) {
+        free(l->tiles);
+        free(l->players);
+        free(l);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&l->shared, NULL) != 0) {
+        pthread_rwlock_destroy(&l->board);
+        free(l->tiles);
+        free(l->players);
+        free(l);
+        return NULL;
+    }
+
+    while (tiles < l->tiles_count
+           && pthread_mutex_init(&l->tiles[tiles], NULL) == 0)
+        tiles++;
+
+    while (tiles == l->tiles_count && players < g->players_count
+           && pthread_mutex_init(&l->players[players], NULL) == 0)
+        players++;
+
+    if (players < g->players_count) {
+        destroy_locks(l, tiles, players);
+        return NULL;
+    }
+
+    return l;
+}
+
+
+/** @brief Blokuje fragmenty planszy, które może czytać ruch na pole.
+ * Ruch na pole (@p x, @p y) czyta pola odległe od niego o co najwyżej 2,
+ * więc blokowane są fragmenty przecinające kwadrat 5 x 5 wokół pola,
+ * w kolejności rosnących numerów.
+ * @param[in] g       – wskaźnik na grę, @ref gamma_t,
+ * @param[in] x       – odcięta pola, liczba nieujemna,
+ * @param[in] y       – rzędna pola, liczba nieujemna,
+ * @param[out] tiles  – numery zablokowanych fragmentów.
+ * @return Liczba zablokowanych fragmentów, od 1 do 4.
+ */
+static uint32_t lock_tiles(gamma_t *g, uint32_t x, uint32_t y,
+                           uint64_t tiles[4]) {
+    uint32_t left = (x < 2 ? 0 : x - 2) / CONCURRENT_TILE;
+    uint32_t right = (x + 2 >= g->width ? g->width - 1 : x + 2)
+                     / CONCURRENT_TILE;
+    uint32_t bottom = (y < 2 ? 0 : y - 2) / CONCURRENT_TILE;
+    uint32_t top = (y + 2 >= g->height ? g->height - 1 : y + 2)
+                   / CONCURRENT_TILE;
+    uint32_t count = 0;
+
+    for (uint32_t tx = left; tx <= right; tx++) {
+        for (uint32_t ty = bottom; ty <= top; ty++) {
+            tiles[count] = (uint64_t) tx * g->locks->tiles_height + ty;
+            pthread_mutex_lock(&g->locks->tiles[tiles[count]]);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+
+/** @brief Blokuje graczy, których liczniki może zmienić ruch na pole.
+ * Są to gracz wykonujący ruch i właściciele sąsiednich pól, blokowani
+ * w kolejności rosnących numerów.
+ * @param[in] g       – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] x       – odcięta pola, liczba nieujemna,
+ * @param[in] y       – rzędna pola, liczba nieujemna,
+ * @param[out] ids    – numery zablokowanych graczy - 1.
+ * @return Liczba zablokowanych graczy, od 1 do 5.
+ */
+static uint32_t lock_players(gamma_t *g, uint32_t player, uint32_t x,
+                             uint32_t y, uint32_t ids[5]) {
+    const field_t *n[4] = {
+        x > 0 ? &g->board[x - 1][y] : NULL,
+        x + 1 < g->width ? &g->board[x + 1][y] : NULL,
+        y > 0 ? &g->board[x][y - 1] : NULL,
+        y + 1 < g->height ? &g->board[x][y + 1] : NULL,
+    };
+    uint32_t count = 1;
+
+    ids[0] = player - 1;
+    for (int i = 0; i < 4; i++) {
+        uint32_t j = count;
+
+        if (n[i] == NULL || !n[i]->busy)
+            continue;
+
+        /* Sortowanie przez wstawianie z pominięciem powtórzeń */
+        while (j > 0 && ids[j - 1] > n[i]->taken)
+            j--;
+        if (j > 0 && ids[j - 1] == n[i]->taken)
+            continue;
+        memmove(ids + j + 1, ids + j, (count - j) * sizeof(uint32_t));
+        ids[j] = n[i]->taken;
+        count++;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        pthread_mutex_lock(&g->locks->players[ids[i]]);
+
+    return count;
+}
+
+
+/** @brief Stawia pionek gracza w trybie współbieżnym.
+ * Działa jak @ref place, ale liczniki całej gry, skrót, dziennik zmian,
+ * ranking i liczniki z @ref touch_golden zmienia pod blokadą @p shared. Wymaga zablokowania fragmentów
+ * z @ref lock_tiles i graczy z @ref lock_players.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] x       – odcięta bieżącego pola, liczba nieujemna,
+ * @param[in] y       – rzędna bieżącego pola, liczba nieujemna.
+ */
+static void place_shared(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    uint64_t key = field_key(player, x, y);
+
+    g->board[x][y].taken = player - 1;
+    g->board[x][y].busy = true;
+    g->players[player - 1].fields_count++;
+    update_perimeter(g, player, x, y, true);
+    afc_expand(g, player, x, y);
+    afc_dimnish_others(g, player, x, y);
+
+    pthread_mutex_lock(&g->locks->shared);
+    g->hash ^= key;
+    record_change(g, x, y);
+    g->free_fields_count--;
+    rank_up(g, player - 1);
+    touch_golden(g, player, x, y);
+    pthread_mutex_unlock(&g->locks->shared);
+
+    if (g->observer.placed != NULL)
+        g->observer.placed(g->observer_ctx, player, x, y);
+}
+
+
+/** @brief Wykonuje ruch, zakładając poprawność gry, gracza i pola.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] x       – odcięta bieżącego pola, liczba nieujemna,
+ * @param[in] y       – rzędna bieżącego pola, liczba nieujemna.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
+ * gdy jest nielegalny.
+ */
+static bool move_on_board(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    if (g->board[x][y].busy)
+        return false;
+    else if (player_has_max_areas(g, player)
+             && how_many_neighbours_owns(g, player, x, y) == 0)
+        return false;
+    else
+        return place_pawn(g, player, x, y);
+}
+
+
+/** @brief Wykonuje ruch w trybie współbieżnym.
+ * Ruch, który nie łączy obszarów, zmienia tylko pola blisko (@p x, @p y)
+ * i liczniki sąsiednich graczy, więc wystarczy mu wspólna blokada planszy
+ * oraz blokady z @ref lock_tiles i @ref lock_players. Łączenie obszarów
+ * może przenumerować pola na całej planszy, dlatego wtedy ruch jest
+ * powtarzany pod wyłączną blokadą planszy.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t,
+ * @param[in] player  – numer gracza, liczba dodatnia,
+ * @param[in] x       – odcięta bieżącego pola, liczba nieujemna,
+ * @param[in] y       – rzędna bieżącego pola, liczba nieujemna.
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false,
+ * gdy jest nielegalny.
+ */
+static bool concurrent_move(gamma_t *g, uint32_t player,
+                            uint32_t x, uint32_t y) {
+    locks_t *l = g->locks;
+    uint64_t tiles[4];
+    uint32_t ids[5];
+    uint32_t tiles_count, players_count = 0;
+    bool done = true, moved = false;
+
+    pthread_rwlock_rdlock(&l->board);
+    tiles_count = lock_tiles(g, x, y, tiles);
+
+    if (!g->board[x][y].busy) {
+        players_count = lock_players(g, player, x, y, ids);
+
+        if (player_has_max_areas(g, player)
+            && how_many_neighbours_owns(g, player, x, y) == 0) {
+            moved = false;
+        } else if (how_many_adjacent_areas(g, player, x, y) < 2) {
+            place_shared(g, player, x, y);
+            check_areas(g, player, x, y);
+            moved = true;
+        } else {
+            done = false;
+        }
+    }
+
+    while (players_count > 0)
+        pthread_mutex_unlock(&l->players[ids[--players_count]]);
+    while (tiles_count > 0)
+        pthread_mutex_unlock(&l->tiles[tiles[--tiles_count]]);
+    pthread_rwlock_unlock(&l->board);
+
+    if (done)
+        return moved;
+
+    pthread_rwlock_wrlock(&l->board);
+    moved = move_on_board(g, player, x, y);
+    pthread_rwlock_unlock(&l->board);
+
+    return moved;
+}
+
+
+/** @brief Zaczyna zmianę planszy widocznej w pamięci współdzielonej.
+ * Ustawia nieparzysty licznik zmian segmentu, więc widoki,
+ * @ref gamma_view_open, czekają z odczytem do @ref share_end.
+ * @param[in,out] g   – wskaźnik na grę, @ref gamma_t.
+ * @return Licznik zmian sprzed zmiany lub zero, gdy plansza nie jest
+ * współdzielona.
+ */
+static inline uint64_t share_begin(gamma_t *g) {
+    uint64_t sequence;
+
+    if (g->shared == NULL)
+        return 0;
+
+    sequence = atomic_load_explicit(&g->shared->sequence,
+                                    memory_order_relaxed);
+    atomic_store_explicit(&g->shared->sequence, sequence + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    return sequence;
+}
+
+
+/** @brief Kończy zmianę planszy zaczętą przez @ref share_begin.
+ * @param[in,out] g    – wskaźnik na grę, @ref gamma_t,
+ * @param[in] sequence – wynik @ref share_begin,
+ * @param[in] changed  – czy plansza się zmieniła; jeżeli nie, licznik
+ *                       wraca do poprzedniej wartości.
+ */
+static inline void share_end(gamma_t *g, uint64_t sequence, bool changed) {
+    if (g->shared != NULL)
+        atomic_store_explicit(&g->shared->sequence,
+                              changed ? sequence + 2 : sequence,
+                              memory_order_release);
+}
+
+
+/** @brief Czeka, aż plansza widoku nie będzie w trakcie zmiany.
+ * @param[in] v   – wskaźnik na widok, @ref gamma_view_t.
+ * @return Parzysty licznik zmian segmentu.
+ */
+static uint64_t view_begin(gamma_view_t *v) {
+    uint64_t sequence;
+
+    while ((sequence = atomic_load_explicit(&v->shared->sequence,
+                                            memory_order_acquire)) % 2 != 0)
+        sched_yield();
+
+    return sequence;
+}
+
+
+/** @brief Sprawdza, czy plansza widoku zmieniła się od @ref view_begin.
+ * @param[in] v        – wskaźnik na widok, @ref gamma_view_t,
+ * @param[in] sequence – wynik @ref view_begin.
+ * @return Wartość @p true, jeżeli odczyt trzeba powtórzyć, @p false
+ * w przeciwnym wypadku.
+ */
+static bool view_changed(gamma_view_t *v, uint64_t sequence) {
+    atomic_thread_fence(memory_order_acquire);
+
+    return atomic_load_explicit(&v->shared->sequence,
+                                memory_order_relaxed) != sequence;
+}
+
+
+void gamma_delete(gamma_t *g) {
+    if (g == NULL)
+        return;
+
+    if (g->shared != NULL) {
+        munmap(g->shared, g->shared_size);
+        shm_unlink(g->shared_name);
+        free(g->shared_name);
+    } else {
+        release_fields(g->board[0], g->board_mapped);
+    }
+
+    free(g->board);
+    free_players(&(g->players), g->players_count);
+    free(g->changes);
+    free(g->ranking);
+    free(g->groups);
+    if (g->locks != NULL)
+        destroy_locks(g->locks, g->locks->tiles_count, g->players_count);
+    free(g);
+}
+
+
+bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    uint64_t sequence;
+    bool moved;
+
+    if (!correct_game_and_player(g, player))
+        return false;
+    else if (!coordinates_correct(g, x, y))
+        return false;
+    else if (g->locks != NULL)
+        return concurrent_move(g, player, x, y);
+
+    sequence = share_begin(g);
+    moved = move_on_board(g, player, x, y);
+    share_end(g, sequence, moved);
+
+    return moved;
+}
+
+
+bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    uint64_t sequence;
+    bool moved;
+
+    if (!correct_game_and_player(g, player))
+        return false;
+    else if (!coordinates_correct(g, x, y))
+        return false;
+
+    if (g->locks != NULL)
+        pthread_rwlock_wrlock(&g->locks->board);
+
+    sequence = share_begin(g);
+
+    if (!(g->players[player - 1].golden_move) || !g->board[x][y].busy)
+        moved = false;
+    else if (g->board[x][y].taken == player - 1)
+        moved = false;
+    else
+        moved = switch_pawns(g, player, x, y);
+
+    share_end(g, sequence, moved);
+
+    if (g->locks != NULL)
+        pthread_rwlock_unlock(&g->locks->board);
+
+    return moved;
+}
+
+
+void gamma_set_observer(gamma_t *g, const gamma_observer_t *obs, void *ctx) {
+    if (g == NULL)
+        return;
+
+    g->observer = obs != NULL ? *obs : (gamma_observer_t) {NULL};
+    g->observer_ctx = ctx;
+}
+
+
+bool gamma_set_concurrent(gamma_t *g, bool concurrent) {
+    if (g == NULL)
+        return false;
+
+    if (concurrent && g->locks == NULL) {
+        /* Licznik zmian segmentu zakłada jednego piszącego */
+        if (g->shared != NULL)
+            return false;
+        g->locks = create_locks(g);
+        return g->locks != NULL;
+    }
+
+    if (!concurrent && g->locks != NULL) {
+        destroy_locks(g->locks, g->locks->tiles_count, g->players_count);
+        g->locks = NULL;
+    }
+
+    return true;
+}
+
+
+bool gamma_share(gamma_t *g, const char *name) {
+    uint64_t fields;
+    size_t size;
+    shared_board_t *shared;
+    field_t *board;
+    char *copy;
+    int fd;
+
+    if (g == NULL || name == NULL || g->shared != NULL || g->locks != NULL)
+        return false;
+
+    fields = (uint64_t) g->width * g->height;
+    size = sizeof(shared_board_t) + fields * sizeof(field_t);
+
+    copy = strdup(name);
+    if (copy == NULL)
+        return false;
+
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        free(copy);
+        return false;
+    }
+
+    shared = ftruncate(fd, (off_t) size) == 0
+             ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+             : MAP_FAILED;
+    close(fd);
+    if (shared == MAP_FAILED) {
+        shm_unlink(name);
+        free(copy);
+        return false;
+    }
+
+    memcpy(shared->magic, GAMMA_SHARE_MAGIC, 4);
+    shared->width = g->width;
+    shared->height = g->height;
+    shared->players_count = g->players_count;
+    atomic_init(&shared->sequence, 0);
+
+    board = (field_t *) (shared + 1);
+    memcpy(board, g->board[0], fields * sizeof(field_t));
+    release_fields(g->board[0], g->board_mapped);
+    g->board_mapped = 0;
+    for (uint32_t x = 0; x < g->width; x++)
+        g->board[x] = board + (uint64_t) x * g->height;
+
+    g->shared = shared;
+    g->shared_size = size;
+    g->shared_name = copy;
+
+    return true;
+}
+
+
+bool gamma_try_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
+                    gamma_effect_t *out) {
+    player_t *p;
+    uint64_t adjacent;
+
+    if (out == NULL)
+        return false;
+
+    *out = (gamma_effect_t) {0};
+
+    if (!correct_game_and_player(g, player))
+        return false;
+    else if (!coordinates_correct(g, x, y))
+        return false;
+    else if (g->board[x][y].busy)
+        return false;
+    else if (player_has_max_areas(g, player)
+             && how_many_neighbours_owns(g, player, x, y) == 0)
+        return false;
+
+    p = &g->players[player - 1];
+    adjacent = p->adjacent_free_count + afc_gain(g, player, x, y);
+    if (was_adjacent(g, player, x, y))
+        adjacent--;
+
+    out->areas = p->areas_count + 1
+                 - (uint32_t) how_many_adjacent_areas(g, player, x, y);
+    out->busy_delta = 1;
+    out->free_delta = (int64_t) free_fields_of(g, out->areas, adjacent,
+                                               g->free_fields_count - 1)
+                      - (int64_t) gamma_free_fields(g, player);
+
+    return true;
+}
+
+
+bool gamma_try_golden_move(gamma_t *g, uint32_t player, uint32_t x,
+                           uint32_t y, gamma_effect_t *out) {
+    player_t *p, *v;
+    uint32_t victim;
+
+    if (out == NULL)
+        return false;
+
+    *out = (gamma_effect_t) {0};
+
+    if (!correct_game_and_player(g, player))
+        return false;
+    else if (!coordinates_correct(g, x, y))
+        return false;
+    else if (!(g->players[player - 1].golden_move) || !g->board[x][y].busy)
+        return false;
+    else if (g->board[x][y].taken == player - 1)
+        return false;
+    else if (player_has_max_areas(g, player)
+             && how_many_neighbours_owns(g, player, x, y) == 0)
+        return false;
+
+    victim = g->board[x][y].taken + 1;
+    p = &g->players[player - 1];
+    v = &g->players[victim - 1];
+
+    out->victim_parts = split_parts(g, x, y);
+    /* Tak jak w other_player_would_exceed_area_limit, samotne pole
+     * nie zmniejsza liczby obszarów przy sprawdzaniu limitu */
+    if ((out->victim_parts == 0 ? v->areas_count
+                                : v->areas_count - 1 + out->victim_parts)
+        > g->max_areas) {
+        out->victim_parts = 0;
+        return false;
+    }
+
+    out->areas = p->areas_count + 1
+                 - (uint32_t) how_many_adjacent_areas(g, player, x, y);
+    out->busy_delta = 1;
+    out->free_delta = (int64_t) free_fields_of(g, out->areas,
+                                               p->adjacent_free_count
+                                               + afc_gain(g, player, x, y),
+                                               g->free_fields_count)
+                      - (int64_t) gamma_free_fields(g, player);
+    out->victim = victim;
+    out->victim_areas = v->areas_count - 1 + out->victim_parts;
+    out->victim_free_delta = (int64_t) free_fields_of(g, out->victim_areas,
+                                                      v->adjacent_free_count
+                                                      - afc_loss(g, x, y),
+                                                      g->free_fields_count)
+                             - (int64_t) gamma_free_fields(g, victim);
+
+    return true;
+}
+
+
+uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
+    if (!correct_game_and_player(g, player))
+        return 0;
+    else
+        return g->players[player - 1].fields_count;
+}
+
+
+uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
+    if (!correct_game_and_player(g, player))
+        return 0;
+    else if (player_has_max_areas(g, player))
+        return g->players[player - 1].adjacent_free_count;
+    else
+        return g->free_fields_count;
+}
+
+
+bool gamma_golden_possible(gamma_t *g, uint32_t player) {
+    if (!correct_game_and_player(g, player)) {
+        return false;
+    } else if (!(g->players[player - 1].golden_move
+                 && another_player_has_a_field(g, player))) {
+        return false;
+    } else {
+        player_t *p = &g->players[player - 1];
+
+        if (!golden_answer_current(g, player)) {
+            p->golden_possible = find_golden_field(g, player);
+            p->golden_stamp = g->golden_epoch + p->golden_epoch;
+            p->loose_stamp = g->loose_epoch;
+        }
+        p->golden_version = g->version;
+
+        return p->golden_possible;
+    }
+}
+
+
+bool gamma_golden_used(gamma_t *g, uint32_t player) {
+    return correct_game_and_player(g, player)
+           && !(g->players[player - 1].golden_move);
+}
+
+
+bool gamma_player_stats(gamma_t *g, uint32_t player,
+                        gamma_player_stats_t *out) {
+    player_t *p;
+
+    if (!correct_game_and_player(g, player) || out == NULL)
+        return false;
+
+    p = &g->players[player - 1];
+    out->perimeter = p->perimeter;
+    out->largest_area = p->largest_area;
+    out->areas = p->areas_count;
+    memcpy(out->area_sizes, p->area_sizes, sizeof(out->area_sizes));
+
+    return true;
+}
+
+
+uint32_t gamma_leader(gamma_t *g) {
+    uint32_t top;
+
+    if (g == NULL || g->ranking == NULL)
+        return 0;
+
+    top = g->players[g->ranking[0]].rank_group;
+
+    return g->groups[top].end == 1 ? g->ranking[0] + 1 : 0;
+}
+
+
+uint32_t gamma_rank(gamma_t *g, uint32_t player) {
+    if (!correct_game_and_player(g, player) || g->ranking == NULL)
+        return 0;
+
+    return g->groups[g->players[player - 1].rank_group].first + 1;
+}
+
+
+bool gamma_can_move(gamma_t *g, uint32_t player) {
+    return gamma_free_fields(g, player) > 0
+           || gamma_golden_possible(g, player);
+}
+
+
+char *gamma_board(gamma_t *g) {
+    if (g == NULL)
+        return NULL;
+
+    uint32_t multip = get_number_of_digits(g->players_count);
+    uint128_t i = (multip * (g->width) + 1) * (g->height);
+
+    char *p = malloc((i + 1) * sizeof(char));
+    if (p == NULL)
+        return NULL;
+
+    i = 0;
+    for (uint32_t y = g->height; y >= 1; y--) {
+        for (uint32_t x = 0; x < g->width; x++) {
+            fill_next_field(p, &i, g, x, y - 1, multip);
+        }
+        p[i] = '\n';
+        i++;
+    }
+    p[i] = '\0';
+
+    return p;
+}
+
+
+uint32_t gamma_whose_field(gamma_t *g, uint32_t x, uint32_t y) {
+    if (g == NULL || x >= g->width || y >= g->height || !g->board[x][y].busy)
+        return 0;
+    else
+        return g->board[x][y].taken + 1;
+}
+
+
+bool gamma_owners_window(gamma_t *g, uint32_t x, uint32_t y,
+                         uint32_t w, uint32_t h, uint32_t *owners) {
+    if (g == NULL || owners == NULL || x >= g->width || y >= g->height
+        || w > g->width - x || h > g->height - y)
+        return false;
+
+    export_block(g, x, y, w, h, owners, w, sizeof(uint32_t));
+
+    return true;
+}
+
+
+bool gamma_export_owners(gamma_t *g, uint32_t *out, size_t stride) {
+    return export_owners(g, out, stride, sizeof(uint32_t), UINT32_MAX);
+}
+
+
+bool gamma_export_owners8(gamma_t *g, uint8_t *out, size_t stride) {
+    return export_owners(g, out, stride, sizeof(uint8_t), UINT8_MAX);
+}
+
+
+bool gamma_export_owners16(gamma_t *g, uint16_t *out, size_t stride) {
+    return export_owners(g, out, stride, sizeof(uint16_t), UINT16_MAX);
+}
+
+
+uint64_t gamma_version(gamma_t *g) {
+    if (g == NULL)
+        return 0;
+    else
+        return g->version;
+}
+
+
+bool gamma_changes(gamma_t *g, uint64_t version,
+                   gamma_change_t **changes, uint64_t *count) {
+    if (g == NULL || changes == NULL || count == NULL)
+        return false;
+
+    if (g->changes != NULL && version >= g->tracked_from)
+        return list_changes(g, version, changes, count);
+
+    if (!list_taken_fields(g, changes, count))
+        return false;
+
+    if (g->changes == NULL)
+        start_tracking(g);
+
+    return true;
+}
+
+
+bool gamma_diff(gamma_t *g, gamma_change_t **changes, uint64_t *count) {
+    if (!gamma_changes(g, g == NULL ? 0 : g->diff_version, changes, count))
+        return false;
+
+    g->diff_version = g->version;
+
+    return true;
+}
+
+
+uint64_t gamma_hash(gamma_t *g) {
+    return g == NULL ? 0 : g->hash;
+}
+
+
+bool gamma_save(gamma_t *g, FILE *f) {
+    uint32_t version = GAMMA_SAVE_VERSION;
+
+    if (g == NULL || f == NULL)
+        return false;
+
+    if (!(fwrite(GAMMA_SAVE_MAGIC, 1, 4, f) == 4
+          && save_value(f, &version, sizeof(version))
+          && save_value(f, &g->width, sizeof(uint32_t))
+          && save_value(f, &g->height, sizeof(uint32_t))
+          && save_value(f, &g->players_count, sizeof(uint32_t))
+          && save_value(f, &g->max_areas, sizeof(uint32_t))
+          && save_value(f, &g->free_fields_count, sizeof(uint64_t))))
+        return false;
+
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        if (!save_player(f, &g->players[i], g->max_areas))
+            return false;
+    }
+
+    for (uint32_t x = 0; x < g->width; x++) {
+        if (!save_column(f, g->board[x], g->height))
+            return false;
+    }
+
+    return save_log(f, g);
+}
+
+
+/** @brief Dopisuje liczbę w kodowaniu LEB128.
+ * Bajty spoza bufora są tylko liczone.
+ * @param[out] buf    – bufor zapisu,
+ * @param[in] cap     – rozmiar bufora @p buf w bajtach,
+ * @param[in] pos     – pozycja zapisu w @p buf,
+ * @param[in] value   – zapisywana liczba.
+ * @return Pozycja za zapisaną liczbą.
+ */
+static inline size_t put_varint(uint8_t *buf, size_t cap, size_t pos,
+                                uint64_t value) {
+    while (value >= 0x80) {
+        if (pos < cap)
+            buf[pos] = (uint8_t) (value | 0x80);
+        pos++;
+        value >>= 7;
+    }
+
+    if (pos < cap)
+        buf[pos] = (uint8_t) value;
+
+    return pos + 1;
+}
+
+
+/** @brief Czyta liczbę w kodowaniu LEB128.
+ * @param[in] buf      – czytany bufor,
+ * @param[in] size     – rozmiar bufora @p buf w bajtach,
+ * @param[in,out] pos  – pozycja odczytu w @p buf,
+ * @param[out] value   – przeczytana liczba.
+ * @return Wartość @p true, jeżeli liczba była poprawna, a @p false, jeżeli
+ * bufor się skończył lub liczba ma więcej niż 64 bity.
+ */
+static inline bool get_varint(const uint8_t *buf, size_t size, size_t *pos,
+                              uint64_t *value) {
+    *value = 0;
+
+    for (uint32_t shift = 0; shift < 64 && *pos < size; shift += 7) {
+        uint8_t byte = buf[(*pos)++];
+
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return shift < 63 || byte <= 1;
+    }
+
+    return false;
+}
+
+
+/** @brief Wyznacza od nowa obszary gry wczytanej ze starszego zapisu.
+ * W zapisach w wersji @ref GAMMA_SAVE_VERSION_SCAN numery obszarów mogły
+ * się powtarzać, więc gra jest tworzona od nowa z rozmieszczenia pionków
+ * przez @ref gamma_new_from_owners. Zachowywane są jedynie złote ruchy.
+ * @param[in] g   – wskaźnik na wczytaną grę, @ref gamma_t, zwalniany.
+ * @return Wskaźnik na nową grę lub NULL, gdy nie udało się zaalokować
+ * pamięci lub któryś z graczy ma za dużo obszarów.
+ */
+static gamma_t *relabel_areas(gamma_t *g) {
+    uint32_t *owners = malloc((uint64_t) g->width * g->height
+                              * sizeof(uint32_t));
+    gamma_t *fresh = NULL;
+
+    if (owners != NULL && gamma_export_owners(g, owners, g->width))
+        fresh = gamma_new_from_owners(g->width, g->height, g->players_count,
+                                      g->max_areas, owners);
+
+    if (fresh != NULL) {
+        for (uint32_t i = 0; i < g->players_count; i++)
+            fresh->players[i].golden_move = g->players[i].golden_move;
+        compute_hash(fresh);
+    }
+
+    free(owners);
+    gamma_delete(g);
+
+    return fresh;
+}
+
+
+gamma_t *gamma_load(FILE *f) {
+    char magic[4];
+    uint32_t version, width, height, players, areas;
+    uint64_t free_fields;
+    gamma_t *g;
+    bool correct = true;
+
+    if (f == NULL
+        || fread(magic, 1, 4, f) != 4
+        || memcmp(magic, GAMMA_SAVE_MAGIC, 4) != 0
+        || !load_value(f, &version, sizeof(version))
+        || (version != GAMMA_SAVE_VERSION
+            && version != GAMMA_SAVE_VERSION_NO_LOG
+            && version != GAMMA_SAVE_VERSION_SCAN)
+        || !load_value(f, &width, sizeof(width))
+        || !load_value(f, &height, sizeof(height))
+        || !load_value(f, &players, sizeof(players))
+        || !load_value(f, &areas, sizeof(areas))
+        || !load_value(f, &free_fields, sizeof(free_fields)))
+        return NULL;
+
+    g = gamma_new(width, height, players, areas);
+    if (g == NULL)
+        return NULL;
+
+    /* Zapis z inną liczbą obszarów nie pochodzi z gamma_save */
+    if (g->max_areas != areas
+        || free_fields > (uint64_t) width * (uint64_t) height) {
+        gamma_delete(g);
+        return NULL;
+    }
+
+    g->free_fields_count = free_fields;
+
+    for (uint32_t i = 0; i < players && correct; i++)
+        correct = load_player(f, &g->players[i], areas, version);
+
+    for (uint32_t x = 0; x < width && correct; x++)
+        correct = load_column(f, g->board[x], g);
+
+    if (correct && version == GAMMA_SAVE_VERSION)
+        correct = load_log(f, g);
+
+    if (!correct) {
+        gamma_delete(g);
+        return NULL;
+    }
+
+    if (version == GAMMA_SAVE_VERSION_SCAN)
+        return relabel_areas(g);
+
+    if (!recount_areas(g)) {
+        gamma_delete(g);
+        return NULL;
+    }
+
+    compute_hash(g);
+
+    return g;
+}
+
+
+gamma_t *gamma_copy(gamma_t *g) {
+    gamma_t *copy;
+
+    if (g == NULL)
+        return NULL;
+
+    copy = gamma_new(g->width, g->height, g->players_count, g->max_areas);
+    if (copy == NULL)
+        return NULL;
+
+    memcpy(copy->board[0], g->board[0],
+           (uint64_t) g->width * g->height * sizeof(field_t));
+
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        uint64_t *areas = copy->players[i].area_fields_count;
+
+        memcpy(areas, g->players[i].area_fields_count,
+               g->max_areas * sizeof(uint64_t));
+        copy->players[i] = g->players[i];
+        copy->players[i].area_fields_count = areas;
+    }
+
+    copy->free_fields_count = g->free_fields_count;
+    copy->version = g->version;
+    copy->tracked_from = g->version;
+    copy->diff_version = g->diff_version;
+    copy->hash = g->hash;
+    memcpy(copy->ranking, g->ranking, g->players_count * sizeof(uint32_t));
+    memcpy(copy->groups, g->groups,
+           ((uint64_t) g->players_count + 1) * sizeof(rank_group_t));
+    copy->free_group = g->free_group;
+    copy->golden_epoch = g->golden_epoch;
+    copy->loose_epoch = g->loose_epoch;
+
+    return copy;
+}
+
+
+/** @brief Dopisuje ciąg pól do zapisu z @ref gamma_snapshot_rle.
+ * Ciągi dłuższe niż mieści jedna liczba są dzielone na kilka.
+ * @param[out] buf    – bufor zapisu,
+ * @param[in] cap     – rozmiar bufora @p buf w bajtach,
+ * @param[in] pos     – pozycja zapisu w @p buf,
+ * @param[in] owners  – liczba graczy powiększona o 1,
+ * @param[in] owner   – właściciel pól ciągu, 0 dla wolnych pól,
+ * @param[in] run     – długość ciągu, liczba dodatnia.
+ * @return Pozycja za zapisanym ciągiem.
+ */
+static size_t put_run(uint8_t *buf, size_t cap, size_t pos, uint64_t owners,
+                      uint32_t owner, uint64_t run) {
+    uint64_t longest = (UINT64_MAX - owner) / owners + 1;
+
+    for (; run > longest; run -= longest)
+        pos = put_varint(buf, cap, pos, (longest - 1) * owners + owner);
+
+    return put_varint(buf, cap, pos, (run - 1) * owners + owner);
+}
+
+
+size_t gamma_snapshot_rle(gamma_t *g, uint8_t *buf, size_t cap) {
+    uint32_t rows, owner = 0, *band;
+    uint64_t run = 0, owners;
+    size_t pos = 0;
+
+    if (g == NULL || (buf == NULL && cap > 0))
+        return 0;
+
+    /* Pasy wierszy przepisane przez export_block czyta się po kolei */
+    rows = g->height < EXPORT_TILE ? g->height : EXPORT_TILE;
+    band = malloc((uint64_t) g->width * rows * sizeof(uint32_t));
+    if (band == NULL)
+        return 0;
+
+    owners = (uint64_t) g->players_count + 1;
+
+    pos = put_varint(buf, cap, pos, g->width);
+    pos = put_varint(buf, cap, pos, g->height);
+    pos = put_varint(buf, cap, pos, g->players_count);
+    pos = put_varint(buf, cap, pos, g->max_areas);
+
+    for (uint32_t i = 0; i < g->players_count; i += 8) {
+        uint8_t used = 0;
+
+        for (uint32_t j = i; j < i + 8 && j < g->players_count; j++) {
+            if (!(g->players[j].golden_move))
+                used |= (uint8_t) (1u << (j - i));
+        }
+        if (pos < cap)
+            buf[pos] = used;
+        pos++;
+    }
+
+    for (uint32_t y = 0; y < g->height; y += rows) {
+        uint32_t h = g->height - y < rows ? g->height - y : rows;
+        uint64_t fields = (uint64_t) g->width * h;
+
+        export_block(g, 0, y, g->width, h, band, g->width, sizeof(uint32_t));
+
+        for (uint64_t i = 0; i < fields; i++) {
+            if (band[i] == owner) {
+                run++;
+            } else {
+                if (run > 0)
+                    pos = put_run(buf, cap, pos, owners, owner, run);
+                owner = band[i];
+                run = 1;
+            }
+        }
+    }
+
+    pos = put_run(buf, cap, pos, owners, owner, run);
+
+    free(band);
+
+    return pos;
+}
+
+
+gamma_t *gamma_from_snapshot_rle(const uint8_t *buf, size_t size) {
+    uint64_t width, height, players, areas, value, owner, run, fields;
+    uint64_t filled = 0;
+    size_t pos = 0, used;
+    uint32_t *owners;
+    gamma_t *g;
+
+    if (buf == NULL
+        || !get_varint(buf, size, &pos, &width)
+        || !get_varint(buf, size, &pos, &height)
+        || !get_varint(buf, size, &pos, &players)
+        || !get_varint(buf, size, &pos, &areas)
+        || width == 0 || width > UINT32_MAX || height == 0
+        || height > UINT32_MAX || players == 0 || players > UINT32_MAX
+        || areas == 0 || areas > UINT32_MAX
+        || size - pos < (players + 7) / 8)
+        return NULL;
+
+    used = pos;
+    pos += (players + 7) / 8;
+    /* Bity za ostatnim graczem muszą być zerami */
+    if (players % 8 != 0 && buf[pos - 1] >> (players % 8) != 0)
+        return NULL;
+
+    fields = width * height;
+    if (fields > SIZE_MAX / sizeof(uint32_t))
+        return NULL;
+    owners = malloc(fields * sizeof(uint32_t));
+    if (owners == NULL)
+        return NULL;
+
+    while (filled < fields) {
+        if (!get_varint(buf, size, &pos, &value)) {
+            free(owners);
+            return NULL;
+        }
+
+        owner = value % (players + 1);
+        run = value / (players + 1);
+        if (run >= fields - filled) {
+            free(owners);
+            return NULL;
+        }
+
+        for (uint64_t end = filled + run + 1; filled < end; filled++)
+            owners[filled] = (uint32_t) owner;
+    }
+
+    g = pos == size
+        ? gamma_new_from_owners((uint32_t) width, (uint32_t) height,
+                                (uint32_t) players, (uint32_t) areas, owners)
+        : NULL;
+    free(owners);
+
+    /* Zapis z inną liczbą obszarów nie pochodzi z gamma_snapshot_rle */
+    if (g == NULL || g->max_areas != areas) {
+        gamma_delete(g);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < g->players_count; i++) {
+        if (buf[used + i / 8] & (1u << (i % 8)))
+            g->players[i].golden_move = false;
+    }
+    compute_hash(g);
+
+    return g;
+}
+
+
+gamma_view_t *gamma_view_open(const char *name) {
+    struct stat st;
+    shared_board_t *shared;
+    gamma_view_t *v;
+    field_t **board;
+    uint64_t fields;
+    int fd;
+
+    if (name == NULL)
+        return NULL;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0
+        || (uint64_t) st.st_size < sizeof(shared_board_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    shared = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED)
+        return NULL;
+
+    /* Rozmiar segmentu musi odpowiadać wymiarom z nagłówka */
+    fields = (uint64_t) shared->width * shared->height;
+    if (memcmp(shared->magic, GAMMA_SHARE_MAGIC, 4) != 0 || fields == 0
+        || shared->players_count == 0
+        || ((uint64_t) st.st_size - sizeof(shared_board_t)) % sizeof(field_t)
+        || ((uint64_t) st.st_size - sizeof(shared_board_t))
+           / sizeof(field_t) != fields) {
+        munmap(shared, (size_t) st.st_size);
+        return NULL;
+    }
+
+    v = malloc(sizeof(gamma_view_t));
+    board = malloc(shared->width * sizeof(field_t *));
+    if (v == NULL || board == NULL) {
+        free(v);
+        free(board);
+        munmap(shared, (size_t) st.st_size);
+        return NULL;
+    }
+
+    for (uint32_t x = 0; x < shared->width; x++)
+        board[x] = (field_t *) (shared + 1) + (uint64_t) x * shared->height;
+
+    init_game(&v->game, board, NULL, shared->width, shared->height,
+              shared->players_count, 0);
+    v->shared = shared;
+    v->size = (size_t) st.st_size;
+
+    return v;
+}
+
+
+void gamma_view_close(gamma_view_t *v) {
+    if (v == NULL)
+        return;
+
+    munmap(v->shared, v->size);
+    free(v->game.board);
+    free(v);
+}
+
+
+uint32_t gamma_view_width(gamma_view_t *v) {
+    return v == NULL ? 0 : v->game.width;
+}
+
+
+uint32_t gamma_view_height(gamma_view_t *v) {
+    return v == NULL ? 0 : v->game.height;
+}
+
+
+uint64_t gamma_view_sequence(gamma_view_t *v) {
+    return v == NULL ? 0 : view_begin(v);
+}
+
+
+char *gamma_view_board(gamma_view_t *v) {
+    uint64_t sequence;
+    char *p;
+
+    if (v == NULL)
+        return NULL;
+
+    for (;;) {
+        sequence = view_begin(v);
+        p = gamma_board(&v->game);
+        if (p == NULL || !view_changed(v, sequence))
+            return p;
+        free(p);
+    }
+}
+
+
+uint32_t gamma_view_whose_field(gamma_view_t *v, uint32_t x, uint32_t y) {
+    uint64_t sequence;
+    uint32_t owner;
+
+    if (v == NULL)
+        return 0;
+
+    do {
+        sequence = view_begin(v);
+        owner = gamma_whose_field(&v->game, x, y);
+    } while (view_changed(v, sequence));
+
+    return owner;
+}
+
+
+bool gamma_view_export_owners(gamma_view_t *v, uint32_t *out,
+                              size_t stride) {
+    uint64_t sequence;
+    bool exported;
+
+    if (v == NULL)
+        return false;
+
+    do {
+        sequence = view_begin(v);
+        exported = gamma_export_owners(&v->game, out, stride);
+    } while (exported && view_changed(v, sequence));
+
+    return exported;
 }
@@ -12,12 +12,88 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 /**
  * Struktura przechowująca stan gry.
  */
 typedef struct gamma gamma_t;
 
+/**
+ * Widok planszy gry udostępnionej przez @ref gamma_share, do odczytu
+ * w innym procesie.
+ */
+typedef struct gamma_view gamma_view_t;
+
+/**
+ * Pole planszy zmienione od danej wersji gry.
+ */
+typedef struct gamma_change {
+    uint32_t x;       /**< numer kolumny pola */
+    uint32_t y;       /**< numer wiersza pola */
+    uint32_t owner;   /**< numer gracza zajmującego pole, 0 dla wolnego */
+} gamma_change_t;
+
+/**
+ * Skutki ruchu, podawane przez @ref gamma_try_move
+ * i @ref gamma_try_golden_move.
+ */
+typedef struct gamma_effect {
+    uint32_t areas;             /**< liczba obszarów gracza po ruchu */
+    int64_t busy_delta;         /**< zmiana wyniku @ref gamma_busy_fields
+                                     dla gracza */
+    int64_t free_delta;         /**< zmiana wyniku @ref gamma_free_fields
+                                     dla gracza */
+    uint32_t victim;            /**< gracz tracący pole, 0 dla zwykłego ruchu */
+    uint32_t victim_areas;      /**< liczba obszarów gracza @p victim
+                                     po ruchu */
+    uint32_t victim_parts;      /**< liczba części, na które rozpada się
+                                     obszar zabranego pola, 0 jeżeli było
+                                     to jedyne pole obszaru */
+    int64_t victim_free_delta;  /**< zmiana wyniku @ref gamma_free_fields
+                                     dla gracza @p victim */
+} gamma_effect_t;
+
+/**
+ * Liczba przedziałów histogramu wielkości obszarów gracza.
+ */
+#define GAMMA_AREA_SIZE_BUCKETS 32
+
+/**
+ * Statystyki gracza, podawane przez @ref gamma_player_stats.
+ */
+typedef struct gamma_player_stats {
+    uint64_t perimeter;     /**< liczba boków pól gracza niestykających się
+                                 z innym jego polem, także na brzegu
+                                 planszy */
+    uint64_t largest_area;  /**< liczba pól największego obszaru gracza,
+                                 0 jeżeli gracz nie ma pól */
+    uint32_t areas;         /**< liczba obszarów gracza */
+    uint32_t area_sizes[GAMMA_AREA_SIZE_BUCKETS];
+    /**< element @p k to liczba obszarów o liczbie pól od 2^k do 2^(k+1) - 1,
+         ostatni zawiera też wszystkie większe obszary */
+} gamma_player_stats_t;
+
+/**
+ * Funkcje obserwatora zmian w grze, ustawiane przez @ref gamma_set_observer.
+ * Każda z nich może być NULL. Pierwszym argumentem każdej funkcji jest
+ * kontekst podany przy ustawianiu obserwatora.
+ */
+typedef struct gamma_observer {
+    void (*placed)(void *ctx, uint32_t player, uint32_t x, uint32_t y);
+    /**< pionek gracza @p player stanął na polu (@p x, @p y) */
+    void (*removed)(void *ctx, uint32_t player, uint32_t x, uint32_t y);
+    /**< pionek gracza @p player został zabrany z pola (@p x, @p y)
+         złotym ruchem */
+    void (*merged)(void *ctx, uint32_t player, uint32_t x, uint32_t y);
+    /**< jeden z obszarów gracza @p player został dołączony do obszaru
+         pola (@p x, @p y) */
+    void (*split)(void *ctx, uint32_t player, uint32_t x, uint32_t y,
+                  uint32_t parts);
+    /**< obszar gracza @p player po zabraniu pola (@p x, @p y) rozpadł
+         się na @p parts > 1 obszarów */
+} gamma_observer_t;
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -32,6 +108,26 @@ typedef struct gamma gamma_t;
 gamma_t *gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
+/** @brief Tworzy grę z zadanym rozmieszczeniem pionków.
+ * Obszary graczy są wyznaczane jednym przebiegiem po planszy, bez
+ * wykonywania ruchów. Duże plansze są dzielone na pasy kolumn etykietowane
+ * równolegle. Żaden gracz nie wykonał jeszcze złotego ruchu.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz, liczba dodatnia,
+ * @param[in] owners  – tablica @p width * @p height numerów graczy; element
+ *                      o indeksie @p y * @p width + @p x opisuje pole
+ *                      (@p x, @p y), 0 oznacza pole wolne.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci, któryś z parametrów jest niepoprawny lub któryś
+ * z graczy miałby więcej niż @p areas obszarów.
+ */
+gamma_t *gamma_new_from_owners(uint32_t width, uint32_t height,
+                               uint32_t players, uint32_t areas,
+                               const uint32_t *owners);
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
@@ -53,6 +149,53 @@ void gamma_delete(gamma_t *g);
  */
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
+/** @brief Ustawia obserwatora zmian w grze.
+ * Funkcje obserwatora są wywoływane w trakcie ruchu, w kolejności zmian:
+ * złoty ruch daje kolejno @p removed, ewentualnie @p split, @p placed
+ * i ewentualnie @p merged. Nie mogą one wywoływać funkcji na grze @p g.
+ * W trybie współbieżnym, @ref gamma_set_concurrent, mogą być wywoływane
+ * jednocześnie z wielu wątków. Bez obserwatora ruchy nie ponoszą żadnego
+ * dodatkowego kosztu poza sprawdzeniem wskaźnika. Kopie i wczytane gry
+ * nie mają obserwatora.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] obs     – funkcje obserwatora, kopiowane, lub NULL, aby
+ *                      usunąć obserwatora,
+ * @param[in] ctx     – kontekst przekazywany funkcjom obserwatora.
+ */
+void gamma_set_observer(gamma_t *g, const gamma_observer_t *obs, void *ctx);
+
+/** @brief Włącza lub wyłącza tryb współbieżny.
+ * W trybie współbieżnym @ref gamma_move i @ref gamma_golden_move mogą być
+ * wywoływane jednocześnie z wielu wątków. Ruchy, które nie łączą obszarów,
+ * blokują tylko fragmenty planszy w pobliżu pola i liczniki dotkniętych
+ * graczy, więc ruchy na odległych fragmentach wykonują się równolegle.
+ * Ruchy łączące obszary i złote ruchy blokują całą planszę. Pozostałych
+ * funkcji nie wolno wywoływać w trakcie ruchów. Kopie i wczytane gry
+ * zaczynają poza trybem współbieżnym.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] concurrent – czy włączyć tryb współbieżny.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli @p g to NULL,
+ * plansza jest udostępniona przez @ref gamma_share lub nie udało się
+ * zaalokować pamięci na blokady.
+ */
+bool gamma_set_concurrent(gamma_t *g, bool concurrent);
+
+/** @brief Przenosi planszę do segmentu pamięci współdzielonej.
+ * Tworzy segment POSIX o nazwie @p name i od tej pory trzyma w nim pola
+ * planszy. Inne procesy mogą go czytać przez @ref gamma_view_open.
+ * Segment ma licznik zmian, nieparzysty w trakcie ruchu, więc widoki
+ * zawsze widzą planszę sprzed lub po całym ruchu. Ruchy kosztują
+ * dodatkowo dwa zapisy licznika. Segment jest usuwany przez
+ * @ref gamma_delete. Kopie i wczytane gry mają planszę w pamięci procesu.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] name    – nazwa segmentu jak w @p shm_open, np. "/gamma".
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli któryś
+ * z parametrów to NULL, plansza jest już udostępniona, gra jest w trybie
+ * współbieżnym, segment o tej nazwie istnieje lub nie udało się go
+ * utworzyć.
+ */
+bool gamma_share(gamma_t *g, const char *name);
+
 /** @brief Wykonuje złoty ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
  * gracza, usuwając pionek innego gracza.
@@ -69,6 +212,44 @@ bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
  */
 bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
+/** @brief Sprawdza skutki ruchu bez jego wykonania.
+ * Podaje, czy @ref gamma_move gracza @p player na pole (@p x, @p y) byłby
+ * wykonany i jak zmieniłby stan gracza. Stan gry się nie zmienia.
+ * Wynik @ref gamma_free_fields każdego innego gracza zmniejsza się o jeden,
+ * jeżeli nie ma on maksymalnej liczby obszarów albo sąsiaduje z tym polem.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new,
+ * @param[out] out    – skutki ruchu, wyzerowane dla ruchu nielegalnego.
+ * @return Wartość @p true, jeśli ruch zostałby wykonany, a @p false,
+ * gdy ruch jest nielegalny lub któryś z parametrów jest niepoprawny.
+ */
+bool gamma_try_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
+                    gamma_effect_t *out);
+
+/** @brief Sprawdza skutki złotego ruchu bez jego wykonania.
+ * Podaje, czy @ref gamma_golden_move gracza @p player na pole (@p x, @p y)
+ * byłby wykonany i jak zmieniłby stan gracza oraz gracza tracącego pole.
+ * Wyniki @ref gamma_free_fields pozostałych graczy się nie zmieniają.
+ * Stan gry się nie zmienia.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
+ *                      @p width z funkcji @ref gamma_new,
+ * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
+ *                      @p height z funkcji @ref gamma_new,
+ * @param[out] out    – skutki ruchu, wyzerowane dla ruchu nielegalnego.
+ * @return Wartość @p true, jeśli złoty ruch zostałby wykonany, a @p false
+ * w przypadkach, w których @ref gamma_golden_move zwraca @p false.
+ */
+bool gamma_try_golden_move(gamma_t *g, uint32_t player, uint32_t x,
+                           uint32_t y, gamma_effect_t *out);
+
 /** @brief Podaje liczbę pól zajętych przez gracza.
  * Podaje liczbę pól zajętych przez gracza @p player.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
@@ -104,6 +285,60 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Sprawdza, czy gracz wykonał już złoty ruch.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli gracz wykonał już w tej rozgrywce złoty
+ * ruch, a @p false w przeciwnym przypadku lub gdy parametry są niepoprawne.
+ */
+bool gamma_golden_used(gamma_t *g, uint32_t player);
+
+/** @brief Podaje statystyki gracza.
+ * Statystyki są uaktualniane przy każdym ruchu, więc funkcja nie przegląda
+ * planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] out    – wskaźnik na miejsce na statystyki.
+ * @return Wartość @p true, jeśli statystyki zostały podane, a @p false,
+ * gdy parametry są niepoprawne.
+ */
+bool gamma_player_stats(gamma_t *g, uint32_t player,
+                        gamma_player_stats_t *out);
+
+/** @brief Podaje gracza zajmującego najwięcej pól.
+ * Ranking graczy jest uaktualniany przy każdej zmianie pola w czasie
+ * stałym, więc funkcja działa w czasie stałym.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Numer jedynego gracza zajmującego najwięcej pól lub 0, jeżeli
+ * najwięcej pól zajmuje kilku graczy lub parametr jest niepoprawny.
+ */
+uint32_t gamma_leader(gamma_t *g);
+
+/** @brief Podaje miejsce gracza w rankingu.
+ * Działa w czasie stałym, jak @ref gamma_leader.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Jeden więcej niż liczba graczy zajmujących więcej pól niż gracz
+ * @p player, a 0, gdy parametry są niepoprawne.
+ */
+uint32_t gamma_rank(gamma_t *g, uint32_t player);
+
+/** @brief Sprawdza, czy gracz może wykonać jakikolwiek ruch.
+ * Gracz może wykonać ruch, jeżeli ma pole, które może zająć, lub może
+ * wykonać złoty ruch. Wynik @ref gamma_golden_possible jest pamiętany
+ * do następnej zmiany planszy, więc kolejne zapytania o tego samego gracza
+ * w niezmienionej grze nie przeglądają planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli gracz może wykonać zwykły lub złoty ruch,
+ * a @p false w przeciwnym przypadku lub gdy parametry są niepoprawne.
+ */
+bool gamma_can_move(gamma_t *g, uint32_t player);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Przykład znajduje się w pliku gamma_test.c.
@@ -125,4 +360,232 @@ char *gamma_board(gamma_t *g);
  */
 uint32_t gamma_whose_field(gamma_t *g, uint32_t x, uint32_t y);
 
+/** @brief Podaje właścicieli pól prostokątnego fragmentu planszy.
+ * Koszt jest proporcjonalny do rozmiaru fragmentu, a nie całej planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny lewego dolnego pola fragmentu,
+ * @param[in] y       – numer wiersza lewego dolnego pola fragmentu,
+ * @param[in] w       – szerokość fragmentu,
+ * @param[in] h       – wysokość fragmentu,
+ * @param[out] owners – tablica o co najmniej @p w * @p h elementach;
+ *                      element o indeksie @p j * @p w + @p i dostaje numer
+ *                      gracza zajmującego pole (@p x + @p i, @p y + @p j)
+ *                      lub 0, jeśli pole jest wolne.
+ * @return Wartość @p true, jeśli fragment mieści się w planszy,
+ * a @p false, jeśli nie lub któryś z parametrów jest niepoprawny.
+ */
+bool gamma_owners_window(gamma_t *g, uint32_t x, uint32_t y,
+                         uint32_t w, uint32_t h, uint32_t *owners);
+
+/** @brief Podaje właścicieli wszystkich pól planszy.
+ * Kopiuje planszę wiersz po wierszu, zaczynając od wiersza 0, w takim
+ * układzie, jakiego oczekuje @ref gamma_new_from_owners, gdy @p stride
+ * jest równy szerokości planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – tablica o co najmniej (@p height - 1) * @p stride
+ *                      + @p width elementach; element o indeksie
+ *                      @p y * @p stride + @p x dostaje numer gracza
+ *                      zajmującego pole (@p x, @p y) lub 0, jeśli pole
+ *                      jest wolne,
+ * @param[in] stride  – odległość między początkami kolejnych wierszy
+ *                      w @p out, liczba nie mniejsza od szerokości planszy.
+ * @return Wartość @p true, jeśli plansza została skopiowana, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_export_owners(gamma_t *g, uint32_t *out, size_t stride);
+
+/** @brief Podaje właścicieli wszystkich pól planszy w bajtach.
+ * Działa jak @ref gamma_export_owners dla gier co najwyżej 255 graczy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – tablica jak w @ref gamma_export_owners,
+ * @param[in] stride  – odległość między początkami kolejnych wierszy.
+ * @return Wartość @p true, jeśli plansza została skopiowana, a @p false,
+ * jeśli graczy jest więcej niż 255 lub któryś z parametrów jest
+ * niepoprawny.
+ */
+bool gamma_export_owners8(gamma_t *g, uint8_t *out, size_t stride);
+
+/** @brief Podaje właścicieli wszystkich pól planszy w liczbach 16-bitowych.
+ * Działa jak @ref gamma_export_owners dla gier co najwyżej 65535 graczy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – tablica jak w @ref gamma_export_owners,
+ * @param[in] stride  – odległość między początkami kolejnych wierszy.
+ * @return Wartość @p true, jeśli plansza została skopiowana, a @p false,
+ * jeśli graczy jest więcej niż 65535 lub któryś z parametrów jest
+ * niepoprawny.
+ */
+bool gamma_export_owners16(gamma_t *g, uint16_t *out, size_t stride);
+
+/** @brief Podaje wersję stanu planszy.
+ * Wersja zwiększa się przy każdej zmianie pola planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Bieżąca wersja lub 0, jeśli @p g ma wartość NULL.
+ */
+uint64_t gamma_version(gamma_t *g);
+
+/** @brief Daje pola zmienione od danej wersji.
+ * Alokuje w pamięci tablicę pól planszy zmienionych po wersji @p version,
+ * każde z aktualnym właścicielem i co najwyżej raz. Silnik zaczyna prowadzić
+ * dziennik zmian przy pierwszym wywołaniu; dla wersji sprzed tego momentu
+ * wynikiem są wszystkie zajęte pola. Funkcja wywołująca musi zwolnić
+ * tablicę.
+ * @param[in] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] version  – wersja otrzymana z @ref gamma_version,
+ * @param[out] changes – wskaźnik na zaalokowaną tablicę zmienionych pól,
+ * @param[out] count   – długość tablicy @p changes.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli któryś
+ * z parametrów jest niepoprawny lub nie udało się zaalokować pamięci.
+ */
+bool gamma_changes(gamma_t *g, uint64_t version,
+                   gamma_change_t **changes, uint64_t *count);
+
+/** @brief Daje pola zmienione od poprzedniego wywołania tej funkcji.
+ * Działa jak @ref gamma_changes z wersją zapamiętaną przy poprzednim
+ * udanym wywołaniu; pierwsze wywołanie daje wszystkie zajęte pola.
+ * @param[in] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] changes – wskaźnik na zaalokowaną tablicę zmienionych pól,
+ * @param[out] count   – długość tablicy @p changes.
+ * @return Wartość @p true, jeśli się udało, a @p false, jeśli któryś
+ * z parametrów jest niepoprawny lub nie udało się zaalokować pamięci.
+ */
+bool gamma_diff(gamma_t *g, gamma_change_t **changes, uint64_t *count);
+
+/** @brief Podaje skrót Zobrista pozycji.
+ * Skrót zależy od właścicieli wszystkich pól i od tego, którzy gracze
+ * wykonali już złoty ruch. Jest aktualizowany przy każdej zmianie pola,
+ * więc odczyt nie przegląda planszy. Te same pozycje mają ten sam skrót
+ * niezależnie od kolejności ruchów, które do nich doprowadziły.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Skrót pozycji lub zero, gdy @p g to NULL.
+ */
+uint64_t gamma_hash(gamma_t *g);
+
+/** @brief Zapisuje pełny stan gry do pliku.
+ * Zapisuje planszę, tablice obszarów i liczniki wszystkich graczy
+ * w kolejności bajtów bieżącej maszyny, a także wersję gry i zmiany pól
+ * od ostatniego @ref gamma_diff, więc pierwsze @ref gamma_diff po
+ * wczytaniu zwraca to samo, co zwróciłoby w zapisanej grze. Zapis można
+ * odtworzyć funkcją @ref gamma_load.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] f       – plik otwarty do zapisu.
+ * @return Wartość @p true, jeśli zapis się powiódł,
+ * a @p false w przeciwnym przypadku.
+ */
+bool gamma_save(gamma_t *g, FILE *f);
+
+/** @brief Odtwarza stan gry zapisany przez @ref gamma_save.
+ * Alokuje pamięć na nową strukturę przechowującą stan gry i wczytuje
+ * do niej zapis z bieżącej pozycji pliku.
+ * @param[in] f       – plik otwarty do odczytu.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci albo zapis jest niepoprawny lub ucięty.
+ */
+gamma_t *gamma_load(FILE *f);
+
+/** @brief Tworzy kopię stanu gry.
+ * Kopia jest niezależna od oryginału: ruchy w jednej z gier nie zmieniają
+ * drugiej. Dziennik zmian nie jest kopiowany, ale numer wersji gry tak.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci albo @p g to NULL.
+ */
+gamma_t *gamma_copy(gamma_t *g);
+
+/** @brief Zapisuje stan gry w zwartej postaci.
+ * Zapis zaczyna się od szerokości i wysokości planszy, liczby graczy
+ * i maksymalnej liczby obszarów, po nich są bity złotych ruchów graczy
+ * (bit @p i % 8 bajtu @p i / 8 dla gracza @p i + 1, ustawiony po złotym
+ * ruchu), a dalej ciągi pól o tym samym właścicielu, wiersz po wierszu,
+ * zaczynając od wiersza 0. Ciąg pól gracza @p p (0 dla wolnych pól)
+ * o długości @p n to jedna liczba (@p n - 1) * (@p players + 1) + @p p,
+ * więc przy kilku graczach krótkie ciągi zajmują jeden bajt. Liczby są
+ * zapisane w kodowaniu LEB128.
+ * Liczniki graczy i numery obszarów nie są zapisywane,
+ * @ref gamma_from_snapshot_rle wylicza je od nowa.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] buf    – bufor na zapis, może być NULL, gdy @p cap to 0,
+ * @param[in] cap     – rozmiar bufora @p buf w bajtach.
+ * @return Długość całego zapisu w bajtach lub 0, gdy któryś z parametrów
+ * jest niepoprawny lub nie udało się zaalokować pamięci. Jeżeli wynik jest
+ * większy od @p cap, w @p buf jest tylko początek zapisu, tak jak
+ * w @p snprintf.
+ */
+size_t gamma_snapshot_rle(gamma_t *g, uint8_t *buf, size_t cap);
+
+/** @brief Odtwarza stan gry zapisany przez @ref gamma_snapshot_rle.
+ * Obszary są wyznaczane jednym przebiegiem po planszy, tak jak
+ * w @ref gamma_new_from_owners.
+ * @param[in] buf     – zapis stanu gry,
+ * @param[in] size    – długość zapisu w bajtach.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci albo zapis jest niepoprawny, ucięty lub ma nadmiarowe
+ * bajty.
+ */
+gamma_t *gamma_from_snapshot_rle(const uint8_t *buf, size_t size);
+
+/** @brief Otwiera widok planszy udostępnionej przez @ref gamma_share.
+ * Mapuje segment tylko do odczytu. Widok nie zna liczników graczy,
+ * a jedynie rozmieszczenie pionków. Odczyty trwające w trakcie ruchu
+ * czekają na jego koniec.
+ * @param[in] name    – nazwa segmentu podana w @ref gamma_share.
+ * @return Wskaźnik na widok lub NULL, gdy segment nie istnieje, nie
+ * pochodzi z @ref gamma_share lub nie udało się zaalokować pamięci.
+ */
+gamma_view_t *gamma_view_open(const char *name);
+
+/** @brief Zamyka widok planszy.
+ * @param[in] v       – wskaźnik na widok lub NULL.
+ */
+void gamma_view_close(gamma_view_t *v);
+
+/** @brief Podaje szerokość planszy widoku.
+ * @param[in] v       – wskaźnik na widok.
+ * @return Szerokość planszy lub 0, gdy @p v to NULL.
+ */
+uint32_t gamma_view_width(gamma_view_t *v);
+
+/** @brief Podaje wysokość planszy widoku.
+ * @param[in] v       – wskaźnik na widok.
+ * @return Wysokość planszy lub 0, gdy @p v to NULL.
+ */
+uint32_t gamma_view_height(gamma_view_t *v);
+
+/** @brief Podaje licznik zmian planszy widoku.
+ * Licznik jest parzysty i rośnie przy każdym ruchu, więc wystarczy go
+ * porównać z poprzednim odczytem, żeby wiedzieć, czy plansza się zmieniła.
+ * @param[in] v       – wskaźnik na widok.
+ * @return Licznik zmian lub 0, gdy @p v to NULL.
+ */
+uint64_t gamma_view_sequence(gamma_view_t *v);
+
+/** @brief Daje napis opisujący planszę widoku.
+ * Działa jak @ref gamma_board dla gry udostępniającej planszę.
+ * @param[in] v       – wskaźnik na widok.
+ * @return Wskaźnik na zaalokowany bufor zawierający napis opisujący planszę
+ * lub NULL, jeśli nie udało się zaalokować pamięci lub @p v to NULL.
+ */
+char *gamma_view_board(gamma_view_t *v);
+
+/** @brief Podaje właściciela pola planszy widoku.
+ * Działa jak @ref gamma_whose_field dla gry udostępniającej planszę.
+ * @param[in] v       – wskaźnik na widok,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Numer gracza zajmującego pole lub 0, gdy pole jest wolne
+ * lub któryś z parametrów jest niepoprawny.
+ */
+uint32_t gamma_view_whose_field(gamma_view_t *v, uint32_t x, uint32_t y);
+
+/** @brief Podaje właścicieli wszystkich pól planszy widoku.
+ * Działa jak @ref gamma_export_owners dla gry udostępniającej planszę.
+ * @param[in] v       – wskaźnik na widok,
+ * @param[out] out    – tablica jak w @ref gamma_export_owners,
+ * @param[in] stride  – odległość między początkami kolejnych wierszy
+ *                      w @p out, liczba nie mniejsza od szerokości planszy.
+ * @return Wartość @p true, jeśli plansza została skopiowana, a @p false,
+ * jeśli któryś z parametrów jest niepoprawny.
+ */
+bool gamma_view_export_owners(gamma_view_t *v, uint32_t *out,
+                              size_t stride);
+
 #endif /* GAMMA_H */
@@ -0,0 +1,387 @@
+/** @file
+ * Klient serwera gry gamma
+ *
+ * Program łączy się z serwerem uruchomionym opcją @p --server i działa
+ * w jednym z dwóch trybów:
+ * - @p gamma_client @p PATH – przesyła standardowe wejście do serwera,
+ *   a jego odpowiedzi wypisuje na standardowe wyjście,
+ * - @p gamma_client @p PATH @p -n @p N @p -c @p C – otwiera @p N połączeń
+ *   naraz, w każdym rozgrywa grę z @p C losowymi poleceniami i wypisuje
+ *   przepustowość serwera.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "output_buffer.h"
+
+
+/**
+ * Wymiary planszy i parametry gier rozgrywanych przez generator obciążenia.
+ */
+#define LOAD_GAME "B 100 100 8 10\n"
+
+
+/**
+ * Rozmiar bufora na odpowiedzi serwera.
+ */
+#define CLIENT_READ_SIZE (1 << 16)
+
+
+/**
+ * Połączenie generatora obciążenia.
+ */
+typedef struct load {
+    const char *path; /**< ścieżka gniazda serwera */
+    uint32_t commands; /**< liczba poleceń do wysłania */
+    uint64_t seed; /**< ziarno generatora liczb losowych */
+    uint64_t lines; /**< liczba otrzymanych linii odpowiedzi */
+    bool ok; /**< czy wymiana danych się powiodła */
+} load_t;
+
+
+/** @brief Łączy się z serwerem.
+ * @param[in] path – ścieżka gniazda serwera.
+ * @return Deskryptor gniazda lub -1, jeżeli się nie udało.
+ */
+static int connect_to(const char *path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/** @brief Wysyła dane do serwera i odbiera wszystkie odpowiedzi.
+ * Wysyłanie i odbieranie przeplatają się, więc serwer nie zablokuje się
+ * na pełnym gnieździe. Po wysłaniu danych zamyka stronę zapisu.
+ * @param[in] fd     – gniazdo połączone z serwerem,
+ * @param[in] data   – wysyłane dane,
+ * @param[in] len    – długość wysyłanych danych,
+ * @param[in] out    – bufor na odpowiedzi lub NULL, aby je pominąć,
+ * @param[out] lines – liczba otrzymanych linii.
+ * @return Wartość @p true jeżeli serwer zamknął połączenie po wysłaniu
+ * wszystkich danych, @p false jeżeli wystąpił błąd.
+ */
+static bool exchange(int fd, const char *data, size_t len,
+                     output_t *out, uint64_t *lines) {
+    char *buf = malloc(CLIENT_READ_SIZE);
+    struct pollfd pfd;
+    bool sending = true;
+    bool ok = buf != NULL;
+
+    *lines = 0;
+    if (len == 0) {
+        shutdown(fd, SHUT_WR);
+        sending = false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    while (ok) {
+        pfd.fd = fd;
+        pfd.events = POLLIN | (sending ? POLLOUT : 0);
+        if (poll(&pfd, 1, -1) < 0) {
+            ok = errno == EINTR;
+            continue;
+        }
+
+        if (sending && (pfd.revents & POLLOUT)) {
+            ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+            if (n > 0) {
+                data += n;
+                len -= (size_t) n;
+                if (len == 0) {
+                    shutdown(fd, SHUT_WR);
+                    sending = false;
+                }
+            } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                ok = false;
+            }
+        }
+
+        if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = recv(fd, buf, CLIENT_READ_SIZE, 0);
+            if (n == 0)
+                break;
+            if (n < 0) {
+                ok = errno == EAGAIN || errno == EINTR;
+                continue;
+            }
+
+            for (const char *p = buf; (p = memchr(p, '\n', buf + n - p));
+                 p++)
+                (*lines)++;
+            if (out != NULL)
+                output_write(out, buf, (size_t) n);
+        }
+    }
+
+    free(buf);
+
+    return ok && !sending;
+}
+
+
+/** @brief Losuje kolejną liczbę generatorem xorshift.
+ * @param[in, out] state – stan generatora, liczba niezerowa.
+ * @return Wylosowana liczba.
+ */
+static inline uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+
+/** @brief Generuje grę z losowymi poleceniami.
+ * @param[in] commands – liczba poleceń po poleceniu @p B,
+ * @param[in] seed     – ziarno generatora liczb losowych,
+ * @param[out] len     – długość wygenerowanych danych.
+ * @return Zaalokowane dane do wysłania lub NULL, jeżeli zabrakło pamięci.
+ */
+static char *generate_game(uint32_t commands, uint64_t seed, size_t *len) {
+    char *data = malloc(sizeof(LOAD_GAME) + (size_t) commands * 64);
+    uint64_t state = seed | 1;
+    char *p;
+
+    if (data == NULL)
+        return NULL;
+
+    memcpy(data, LOAD_GAME, sizeof(LOAD_GAME) - 1);
+    p = data + sizeof(LOAD_GAME) - 1;
+
+    for (uint32_t i = 0; i < commands; i++) {
+        uint64_t r = next_random(&state);
+        uint32_t player = 1 + (uint32_t) (r % 8);
+        uint32_t x = (uint32_t) ((r >> 8) % 100);
+        uint32_t y = (uint32_t) ((r >> 24) % 100);
+
+        switch ((r >> 40) % 16) {
+            case 0:
+                p += sprintf(p, "g %u %u %u\n", player, x, y);
+                break;
+            case 1:
+                p += sprintf(p, "b %u\n", player);
+                break;
+            case 2:
+                p += sprintf(p, "f %u\n", player);
+                break;
+            default:
+                p += sprintf(p, "m %u %u %u\n", player, x, y);
+                break;
+        }
+    }
+
+    *len = (size_t) (p - data);
+
+    return data;
+}
+
+
+/** @brief Wątek jednego połączenia generatora obciążenia.
+ * @param[in, out] arg – wskaźnik na @ref load_t.
+ * @return NULL.
+ */
+static void *load_thread(void *arg) {
+    load_t *l = arg;
+    size_t len;
+    char *data = generate_game(l->commands, l->seed, &len);
+    int fd = data != NULL ? connect_to(l->path) : -1;
+
+    l->ok = fd >= 0 && exchange(fd, data, len, NULL, &l->lines);
+
+    if (fd >= 0)
+        close(fd);
+    free(data);
+
+    return NULL;
+}
+
+
+/** @brief Obciąża serwer równoległymi połączeniami.
+ * @param[in] path        – ścieżka gniazda serwera,
+ * @param[in] connections – liczba połączeń, liczba dodatnia,
+ * @param[in] commands    – liczba poleceń w każdym połączeniu.
+ * @return Zero jeżeli wszystkie połączenia się powiodły, jeden
+ * w przeciwnym wypadku.
+ */
+static int run_load(const char *path, uint32_t connections,
+                    uint32_t commands) {
+    load_t *loads = calloc(connections, sizeof(load_t));
+    pthread_t *threads = calloc(connections, sizeof(pthread_t));
+    struct timespec start, stop;
+    uint32_t started = 0, failed = 0;
+    uint64_t lines = 0;
+    double seconds;
+
+    if (loads == NULL || threads == NULL) {
+        free(loads);
+        free(threads);
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (; started < connections; started++) {
+        loads[started].path = path;
+        loads[started].commands = commands;
+        loads[started].seed = 0x9e3779b97f4a7c15ULL * (started + 1);
+        if (pthread_create(&threads[started], NULL,
+                           load_thread, &loads[started]) != 0)
+            break;
+    }
+
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        lines += loads[i].lines;
+        if (!loads[i].ok)
+            failed++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    seconds = (double) (stop.tv_sec - start.tv_sec)
+              + (double) (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("connections: %u, failed: %u, commands: %llu, responses: %llu, "
+           "seconds: %.3f, commands/s: %.0f\n", started, failed,
+           (unsigned long long) started * (commands + 1),
+           (unsigned long long) lines, seconds,
+           seconds > 0 ? (double) started * (commands + 1) / seconds : 0.0);
+
+    free(loads);
+    free(threads);
+
+    return started == connections && failed == 0 ? 0 : 1;
+}
+
+
+/** @brief Przesyła standardowe wejście do serwera.
+ * @param[in] path – ścieżka gniazda serwera.
+ * @return Zero jeżeli się udało, jeden w przeciwnym wypadku.
+ */
+static int run_forward(const char *path) {
+    size_t len = 0, cap = CLIENT_READ_SIZE;
+    char *data = malloc(cap);
+    uint64_t lines;
+    ssize_t n;
+    int fd, result = 1;
+
+    while (data != NULL
+           && (n = read(STDIN_FILENO, data + len, cap - len)) != 0) {
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            free(data);
+            return 1;
+        }
+
+        len += (size_t) n;
+        if (len == cap) {
+            char *bigger = realloc(data, 2 * cap);
+            if (bigger == NULL) {
+                free(data);
+                return 1;
+            }
+            data = bigger;
+            cap *= 2;
+        }
+    }
+
+    if (data == NULL || !output_open_std()) {
+        free(data);
+        return 1;
+    }
+
+    fd = connect_to(path);
+    if (fd >= 0) {
+        if (exchange(fd, data, len, &std_out, &lines))
+            result = 0;
+        close(fd);
+    }
+
+    output_close_std();
+    free(data);
+
+    return result;
+}
+
+
+/** @brief Wczytuje dodatnią liczbę z argumentu programu.
+ * @param[in] s  – wczytywany argument,
+ * @param[out] n – wczytana liczba.
+ * @return Wartość @p true jeżeli argument był dodatnią liczbą uint32_t,
+ * @p false w przeciwnym wypadku.
+ */
+static bool parse_count(const char *s, uint32_t *n) {
+    char *end;
+    unsigned long value;
+
+    if (s[0] < '0' || s[0] > '9')
+        return false;
+
+    errno = 0;
+    value = strtoul(s, &end, 10);
+    if (errno != 0 || *end != '\0' || value == 0 || value > UINT32_MAX)
+        return false;
+
+    *n = (uint32_t) value;
+
+    return true;
+}
+
+
+/** @brief Uruchamia klienta w trybie wybranym argumentami.
+ * @param[in] argc  – liczba argumentów programu,
+ * @param[in] argv  – argumenty programu.
+ * @return Zero jeżeli się udało, jeden w przeciwnym wypadku.
+ */
+int main(int argc, char *argv[]) {
+    uint32_t connections = 0, commands = 0;
+
+    if (argc == 2)
+        return run_forward(argv[1]);
+
+    if (argc == 6 && strcmp(argv[2], "-n") == 0
+        && strcmp(argv[4], "-c") == 0
+        && parse_count(argv[3], &connections)
+        && parse_count(argv[5], &commands))
+        return run_load(argv[1], connections, commands);
+
+    fprintf(stderr, "Usage: gamma_client PATH [-n CONNECTIONS -c COMMANDS]\n");
+
+    return 1;
+}
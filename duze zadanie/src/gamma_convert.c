@@ -0,0 +1,237 @@
+/** @file
+ * Konwerter między tekstowym a binarnym formatem trybu wsadowego
+ *
+ * Program czyta standardowe wejście i zapisuje wynik konwersji
+ * na standardowe wyjście. Tryb pracy wybiera jedna z opcji:
+ * - @p -b – polecenia tekstowe na strumień binarny,
+ * - @p -t – strumień binarny na polecenia tekstowe,
+ * - @p -r – wyniki binarne na wyniki tekstowe (komunikaty o błędach
+ *   trafiają na standardowe wyjście błędów).
+ *
+ * Każda linia tekstu odpowiada dokładnie jednej ramce, więc numery
+ * w komunikatach o błędach obu formatów są zgodne. Pierwsza linia wejścia
+ * tekstowego musi być poprawnym poleceniem @p B.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "batch_mode.h"
+#include "binary_mode.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+
+
+/** @brief Zapisuje ramkę binarną odpowiadającą operacji.
+ * @param[in] op – zapisywana operacja.
+ */
+static void put_frame(const batch_op_t *op) {
+    if (op->errors > 0) {
+        output_char(&std_out, 2);
+        output_char(&std_out, BINARY_INVALID);
+        output_char(&std_out, (char) op->errors);
+    } else if (op->p == E) {
+        output_char(&std_out, 1);
+        output_char(&std_out, BINARY_NOP);
+    } else {
+        output_char(&std_out, (char) (1 + 4 * op->count));
+        output_char(&std_out, param_to_char(op->p));
+        for (int i = 0; i < op->count; i++)
+            put_u32(&std_out, op->args[i]);
+    }
+}
+
+
+/** @brief Konwertuje polecenia tekstowe na strumień binarny.
+ * @return Zero jeżeli się udało, jeden jeżeli pierwsza linia nie była
+ * poprawnym poleceniem @p B.
+ */
+static int text_to_binary(void) {
+    line_parser_t lp;
+    batch_op_t op;
+    uint32_t line = 1;
+    bool more;
+
+    parser_init(&lp);
+    more = read_op(&lp, &line, &op);
+    if (op.p != B || op.count != 4 || op.errors > 0)
+        return 1;
+
+    for (int i = 0; i < 4; i++) {
+        if (op.args[i] == 0)
+            return 1;
+    }
+
+    output_write(&std_out, BINARY_MAGIC, BINARY_MAGIC_LEN);
+    for (int i = 0; i < 4; i++)
+        put_u32(&std_out, op.args[i]);
+
+    while (more) {
+        more = read_op(&lp, &line, &op);
+        if (!op.end || op.errors > 0)
+            put_frame(&op);
+    }
+
+    return 0;
+}
+
+
+/** @brief Zapisuje linię tekstu odpowiadającą ramce.
+ * @param[in] s   – ramka bez bajtu długości,
+ * @param[in] len – długość ramki.
+ */
+static void put_line(const char *s, uint8_t len) {
+    char code = len > 0 ? s[0] : BINARY_NOP;
+
+    if (code == BINARY_NOP && len == 1) {
+    } else if (code == BINARY_INVALID && len == 2 && s[1] == 2) {
+        /* Jedyna linia tekstowa zgłaszająca dwa błędy */
+        output_str(&std_out, "m 9999999999#");
+    } else if (correct_parameter(code) && len > 0 && (len - 1) % 4 == 0
+               && (len - 1) / 4 <= MAX_INSTRUCTIONS_INDEX + 1) {
+        output_char(&std_out, code);
+        for (int i = 0; i < (len - 1) / 4; i++) {
+            output_char(&std_out, ' ');
+            output_uint(&std_out, get_u32(s + 1 + 4 * i));
+        }
+    } else {
+        output_char(&std_out, '?');
+    }
+
+    output_char(&std_out, '\n');
+}
+
+
+/** @brief Konwertuje strumień binarny na polecenia tekstowe.
+ * @return Zero jeżeli się udało, jeden jeżeli brakuje nagłówka.
+ */
+static int binary_to_text(void) {
+    const char *s;
+    size_t n;
+
+    if (!binary_input()
+        || input_peek(&s, BINARY_HEADER_LEN) < BINARY_HEADER_LEN)
+        return 1;
+
+    output_char(&std_out, 'B');
+    for (int i = 0; i < 4; i++) {
+        output_char(&std_out, ' ');
+        output_uint(&std_out, get_u32(s + BINARY_MAGIC_LEN + 4 * i));
+    }
+    output_char(&std_out, '\n');
+    input_skip(BINARY_HEADER_LEN);
+
+    while (input_peek(&s, 1) > 0) {
+        uint8_t len = (uint8_t) s[0];
+        n = input_peek(&s, 1 + (size_t) len);
+        if (n < 1 + (size_t) len) {
+            /* Ucięta ramka to niezakończona linia */
+            output_char(&std_out, '?');
+            break;
+        }
+
+        put_line(s + 1, len);
+        input_skip(1 + (size_t) len);
+    }
+
+    return 0;
+}
+
+
+/** @brief Konwertuje wyniki binarne na wyniki tekstowe.
+ * @return Zero jeżeli się udało, jeden jeżeli wyniki były niepoprawne.
+ */
+static int results_to_text(void) {
+    const char *s;
+    size_t n;
+
+    while ((n = input_peek(&s, 9)) > 0) {
+        char kind = s[0];
+
+        if ((kind == BINARY_OK || kind == BINARY_ERROR) && n >= 5) {
+            output_t *o = kind == BINARY_OK ? &std_out : &std_err;
+            output_str(o, kind == BINARY_OK ? "OK " : "ERROR ");
+            output_uint(o, get_u32(s + 1));
+            output_char(o, '\n');
+            input_skip(5);
+        } else if (kind == BINARY_VALUE && n >= 9) {
+            output_uint(&std_out, get_u64(s + 1));
+            output_char(&std_out, '\n');
+            input_skip(9);
+        } else if (kind == BINARY_BOARD && n >= 9) {
+            uint64_t len = get_u64(s + 1);
+            input_skip(9);
+            while (len > 0 && (n = input_peek(&s, 1)) > 0) {
+                if (n > len)
+                    n = (size_t) len;
+                output_write(&std_out, s, n);
+                input_skip(n);
+                len -= n;
+            }
+            if (len > 0)
+                return 1;
+        } else if (kind == BINARY_DIFF && n >= 9) {
+            uint64_t count = get_u64(s + 1);
+            input_skip(9);
+            output_uint(&std_out, count);
+            output_char(&std_out, '\n');
+            for (; count > 0; count--) {
+                if (input_peek(&s, 12) < 12)
+                    return 1;
+                output_uint(&std_out, get_u32(s));
+                output_char(&std_out, ' ');
+                output_uint(&std_out, get_u32(s + 4));
+                output_char(&std_out, ' ');
+                output_uint(&std_out, get_u32(s + 8));
+                output_char(&std_out, '\n');
+                input_skip(12);
+            }
+        } else {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/** @brief Uruchamia konwersję wybraną opcją.
+ * @param[in] argc  – liczba argumentów programu,
+ * @param[in] argv  – argumenty programu.
+ * @return Zero jeżeli konwersja się udała, jeden w przeciwnym wypadku.
+ */
+int main(int argc, char *argv[]) {
+    static const char usage[] = "Usage: gamma_convert -b | -t | -r\n";
+    int result = 1;
+
+    if (argc != 2 || strlen(argv[1]) != 2 || argv[1][0] != '-'
+        || strchr("btr", argv[1][1]) == NULL) {
+        if (write(STDERR_FILENO, usage, sizeof(usage) - 1) < 0)
+            return 1;
+        return 1;
+    }
+
+    if (!input_open(STDIN_FILENO))
+        return 1;
+
+    if (!output_open_std()) {
+        input_close();
+        return 1;
+    }
+
+    if (argv[1][1] == 'b')
+        result = text_to_binary();
+    else if (argv[1][1] == 't')
+        result = binary_to_text();
+    else
+        result = results_to_text();
+
+    output_close_std();
+    input_close();
+
+    return result;
+}
@@ -6,46 +6,437 @@
  * @date 08.05.2020
  */
 
+#include <errno.h>
 #include <stdint.h>
-#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "gamma.h"
 #include "batch_mode.h"
+#include "batch_pipeline.h"
+#include "binary_mode.h"
 #include "interactive_mode.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "batch_aux.h"
+#include "checkpoint.h"
+#include "server.h"
+#include "replication.h"
+
+
+/**
+ * Opcje programu podane w linii poleceń.
+ */
+typedef struct options {
+    bool pipeline; /**< czy tryb wsadowy ma działać potokowo */
+    const char *resume; /**< punkt kontrolny do wznowienia lub NULL */
+    checkpoint_config_t checkpoint; /**< zapisywanie punktów kontrolnych */
+    const char *server; /**< gniazdo serwera lub NULL */
+    uint32_t workers; /**< liczba wątków roboczych serwera */
+    const char *replicate; /**< gniazdo lidera replikacji lub NULL */
+    const char *follow; /**< gniazdo lidera, którego gra jest powielana,
+                             lub NULL */
+    const char *share; /**< segment pamięci współdzielonej z planszą
+                            lub NULL */
+    uint32_t *bots; /**< gracze sterowani przez komputer lub NULL */
+    uint32_t bots_count; /**< liczba graczy sterowanych przez komputer */
+} options_t;
+
+
+/** @brief Wczytuje dodatnią liczbę uint32_t z argumentu programu.
+ * @param[in] s  – wczytywany argument,
+ * @param[out] n – wczytana liczba.
+ * @return Wartość @p true jeżeli argument był dodatnią liczbą uint32_t,
+ * @p false w przeciwnym wypadku.
+ */
+static bool parse_positive(const char *s, uint32_t *n) {
+    char *end;
+    unsigned long long value;
+
+    if (s[0] < '0' || s[0] > '9')
+        return false;
+
+    errno = 0;
+    value = strtoull(s, &end, 10);
+    if (errno != 0 || *end != '\0' || value == 0 || value > UINT32_MAX)
+        return false;
+
+    *n = (uint32_t) value;
+
+    return true;
+}
+
+
+/** @brief Wczytuje listę numerów graczy oddzielonych przecinkami.
+ * @param[in] s      – wczytywany argument,
+ * @param[out] list  – zaalokowana tablica wczytanych numerów,
+ * @param[out] count – liczba wczytanych numerów.
+ * @return Wartość @p true jeżeli argument był niepustą listą dodatnich
+ * liczb uint32_t i udało się zaalokować pamięć, @p false w przeciwnym
+ * wypadku.
+ */
+static bool parse_players(const char *s, uint32_t **list, uint32_t *count) {
+    size_t len = strlen(s);
+    char *copy = malloc(len + 1);
+    char *token, *rest;
+
+    /* Numerów jest co najwyżej tyle, ile przecinków, plus jeden */
+    *list = malloc((len / 2 + 1) * sizeof(uint32_t));
+    *count = 0;
+    if (copy == NULL || *list == NULL || len == 0 || s[len - 1] == ',') {
+        free(copy);
+        return false;
+    }
+
+    memcpy(copy, s, len + 1);
+    for (token = copy; token != NULL; token = rest) {
+        rest = strchr(token, ',');
+        if (rest != NULL)
+            *(rest++) = '\0';
+
+        if (!parse_positive(token, &(*list)[*count])) {
+            free(copy);
+            return false;
+        }
+        (*count)++;
+    }
+
+    free(copy);
+
+    return true;
+}
+
+
+/** @brief Wczytuje opcje z linii poleceń.
+ * @param[in] argc  – liczba argumentów programu,
+ * @param[in] argv  – argumenty programu,
+ * @param[out] opt  – wczytane opcje.
+ * @return Wartość @p true jeżeli wszystkie opcje były poprawne,
+ * @p false w przeciwnym wypadku.
+ */
+static bool parse_options(int argc, char *argv[], options_t *opt) {
+    bool every = false, workers = false;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(opt, 0, sizeof(options_t));
+    opt->checkpoint.every = CHECKPOINT_DEFAULT_EVERY;
+    opt->workers = cpus > 0 ? (uint32_t) cpus : 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pipeline") == 0) {
+            opt->pipeline = true;
+        } else if (i + 1 == argc) {
+            return false;
+        } else if (strcmp(argv[i], "--checkpoint") == 0) {
+            opt->checkpoint.path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0) {
+            if (!parse_positive(argv[++i], &opt->checkpoint.every))
+                return false;
+            every = true;
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            opt->resume = argv[++i];
+        } else if (strcmp(argv[i], "--server") == 0) {
+            opt->server = argv[++i];
+        } else if (strcmp(argv[i], "--replicate") == 0) {
+            opt->replicate = argv[++i];
+        } else if (strcmp(argv[i], "--share") == 0) {
+            opt->share = argv[++i];
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            opt->follow = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0) {
+            if (!parse_positive(argv[++i], &opt->workers))
+                return false;
+            workers = true;
+        } else if (strcmp(argv[i], "--bots") == 0) {
+            free(opt->bots);
+            if (!parse_players(argv[++i], &opt->bots, &opt->bots_count))
+                return false;
+        } else {
+            return false;
+        }
+    }
+
+    /* Serwer nie czyta standardowego wejścia */
+    if (opt->server != NULL)
+        return !(opt->pipeline || every || opt->resume != NULL
+                 || opt->checkpoint.path != NULL || opt->bots != NULL
+                 || opt->replicate != NULL || opt->follow != NULL
+                 || opt->share != NULL);
+    else if (workers)
+        return false;
+
+    /* Replika jedynie odpowiada na zapytania */
+    if (opt->follow != NULL)
+        return !(opt->pipeline || every || opt->resume != NULL
+                 || opt->checkpoint.path != NULL || opt->bots != NULL
+                 || opt->replicate != NULL || opt->share != NULL);
+
+    /* Punkty kontrolne zapisuje tylko jednowątkowy tryb wsadowy */
+    if (opt->checkpoint.path == NULL)
+        return !every;
+    else
+        return !opt->pipeline;
+}
+
+
+/** @brief Wypisuje sposób użycia programu na standardowe wyjście błędów.
+ */
+static void print_usage(void) {
+    static const char usage[] =
+        "Usage: gamma [--pipeline] [--checkpoint FILE"
+        " [--checkpoint-every N]] [--resume FILE] [--bots P1,P2,...]\n"
+        "             [--replicate PATH] [--share NAME]\n"
+        "       gamma --server PATH [--workers N]\n"
+        "       gamma --follow PATH\n"
+        "Binary input takes no options.\n";
+
+    if (write(STDERR_FILENO, usage, sizeof(usage) - 1) < 0)
+        return;
+}
+
+
+/** @brief Zaczyna replikację gry, jeżeli podano gniazdo lidera.
+ * @param[in] opt     – opcje programu,
+ * @param[in,out] g   – wskaźnik na replikowaną grę,
+ * @param[out] leader – lider replikacji lub NULL, gdy gra nie jest
+ *                      replikowana.
+ * @return Wartość @p false jeżeli nie udało się zacząć replikacji,
+ * @p true w przeciwnym wypadku.
+ */
+static bool start_leader(const options_t *opt, gamma_t *g,
+                         leader_t **leader) {
+    static const char msg[] = "Cannot start replication\n";
+
+    *leader = NULL;
+    if (opt->replicate == NULL)
+        return true;
+
+    *leader = leader_start(g, opt->replicate);
+    if (*leader != NULL)
+        return true;
+
+    if (write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0)
+        return false;
+    return false;
+}
+
+
+/** @brief Udostępnia planszę gry, jeżeli podano nazwę segmentu.
+ * @param[in] opt   – opcje programu,
+ * @param[in,out] g – wskaźnik na grę.
+ * @return Wartość @p false jeżeli nie udało się udostępnić planszy,
+ * @p true w przeciwnym wypadku.
+ */
+static bool share_board(const options_t *opt, gamma_t *g) {
+    static const char msg[] = "Cannot share the board\n";
+
+    if (opt->share == NULL || gamma_share(g, opt->share))
+        return true;
+
+    if (write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0)
+        return false;
+    return false;
+}
+
+
+/** @brief Odpowiada na zapytania trybu wsadowego o grę lidera.
+ * Ruchy i złote ruchy są błędami, pozostałe operacje są wykonywane
+ * na bieżącym stanie repliki.
+ * @param[in] path – ścieżka gniazda lidera.
+ * @return Zero jeżeli replika działała, jeden jeżeli nie udało się
+ * połączyć z liderem.
+ */
+static int run_follower_mode(const char *path) {
+    static const char msg[] = "Cannot connect to the leader\n";
+    follower_t *follower = follower_start(path);
+    line_parser_t lp;
+    batch_op_t op;
+    batch_result_t r;
+    uint32_t line = 1;
+    bool more = true;
+
+    if (follower == NULL) {
+        if (write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0)
+            return 1;
+        return 1;
+    }
+
+    parser_init(&lp);
+
+    while (more) {
+        if (!input_buffered()) {
+            output_flush(&std_out);
+            output_flush(&std_err);
+        }
+
+        more = read_op(&lp, &line, &op);
+        if (op.p == m || op.p == g) {
+            r = (batch_result_t) {
+                .line = op.line, .error_line = op.line, .errors = op.errors,
+                .kind = RESULT_ERROR, .end = op.end
+            };
+        } else {
+            execute_op(follower_game(follower), &op, &r);
+            follower_release(follower);
+        }
+        format_result(&r, &std_out, &std_err);
+    }
+
+    follower_stop(follower);
+
+    return 0;
+}
+
+
+/** @brief Wznawia rozgrywkę w trybie wsadowym od punktu kontrolnego.
+ * @param[in] opt – opcje programu.
+ * @return Zero jeżeli rozgrywka się odbyła, jeden jeżeli nie udało się
+ * odczytać punktu kontrolnego, przejść do zapisanej pozycji wejścia,
+ * udostępnić planszy lub zacząć replikacji.
+ */
+static int resume_batch_mode(const options_t *opt) {
+    static const char msg[] = "Cannot resume from checkpoint\n";
+    uint64_t offset;
+    uint32_t line;
+    gamma_t *g = checkpoint_read(opt->resume, &offset, &line);
+    leader_t *leader;
+
+    if (g == NULL || !input_seek(offset)) {
+        gamma_delete(g);
+        if (write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0)
+            return 1;
+        return 1;
+    }
+
+    if (!share_board(opt, g) || !start_leader(opt, g, &leader)) {
+        gamma_delete(g);
+        return 1;
+    }
+
+    if (opt->pipeline)
+        run_pipelined_batch_mode(g, &line);
+    else
+        run_batch_mode(g, &line, opt->checkpoint.path != NULL
+                                 ? &opt->checkpoint : NULL);
+
+    leader_stop(leader);
+    gamma_delete(g);
+
+    return 0;
+}
 
 
 /** @brief Uruchamia i przeprowaddza rozgrywkę w grze gamma.
+ * @param[in] argc  – liczba argumentów programu,
+ * @param[in] argv  – argumenty programu.
  * @return Zero jeżeli program zakończył działanie pomyślnie,
- * jeden jeżeli wystąpił błąd w trybie interaktywnym.
+ * jeden jeżeli wystąpił błąd w trybie interaktywnym
+ * lub opcje programu były niepoprawne.
  */
-int main() {
+int main(int argc, char *argv[]) {
+    options_t opt;
     uint32_t line = 1;
     parameter p;
     /* Odpowiada za przechowywanie (width height players areas) (0 - 3) */
     uint32_t instruct[4];
     gamma_t *g = NULL;
+    leader_t *leader = NULL;
     int i_mode_res = 0; /* Wynik wykonania trybu interaktywnego */
 
+    if (!parse_options(argc, argv, &opt)) {
+        free(opt.bots);
+        print_usage();
+        return 1;
+    }
+
+    if (opt.server != NULL)
+        return run_server(opt.server, opt.workers);
+
+    if (!input_open(STDIN_FILENO)) {
+        free(opt.bots);
+        return 1;
+    }
+
+    if (!output_open_std()) {
+        free(opt.bots);
+        input_close();
+        return 1;
+    }
+
+    if (opt.follow != NULL) {
+        i_mode_res = run_follower_mode(opt.follow);
+        output_close_std();
+        input_close();
+        return i_mode_res;
+    }
+
+    if (opt.resume != NULL) {
+        i_mode_res = resume_batch_mode(&opt);
+        free(opt.bots);
+        output_close_std();
+        input_close();
+        return i_mode_res;
+    }
+
+    if (binary_input()) {
+        /* Strumień binarny obsługuje jedynie sam tryb wsadowy */
+        if (opt.pipeline || opt.checkpoint.path != NULL || opt.bots != NULL
+            || opt.replicate != NULL || opt.share != NULL) {
+            free(opt.bots);
+            output_close_std();
+            input_close();
+            print_usage();
+            return 1;
+        }
+
+        run_binary_mode();
+        free(opt.bots);
+        output_close_std();
+        input_close();
+        return 0;
+    }
+
     do {
         p = get_first_line(&line, instruct);
 
         if (p != E) {
             g = gamma_new(instruct[0], instruct[1], instruct[2], instruct[3]);
             if (g == NULL)
-                fprintf(stderr, "ERROR %d\n", line - 1);
+                print_err(line - 1);
         }
 
     } while (p != E && g == NULL);
 
+    if (g != NULL
+        && (!share_board(&opt, g) || !start_leader(&opt, g, &leader))) {
+        gamma_delete(g);
+        g = NULL;
+        i_mode_res = 1;
+    }
+
     if (g != NULL) {
         if (p == B) {
-            printf("OK %d\n", line - 1);
-            run_batch_mode(g, &line);
+            output_str(&std_out, "OK ");
+            output_uint(&std_out, line - 1);
+            output_char(&std_out, '\n');
+            if (opt.pipeline)
+                run_pipelined_batch_mode(g, &line);
+            else
+                run_batch_mode(g, &line, opt.checkpoint.path != NULL
+                                         ? &opt.checkpoint : NULL);
         } else if (p == I) {
+            output_flush(&std_out);
+            output_flush(&std_err);
             i_mode_res = run_interactive_mode(g, instruct[0],
-                                              instruct[1], instruct[2]);
+                                              instruct[1], instruct[2],
+                                              opt.bots, opt.bots_count);
         }
     }
 
+    free(opt.bots);
+    leader_stop(leader);
     gamma_delete(g);
+    output_close_std();
+    input_close();
     return i_mode_res == 0 ? 0 : 1;
 }
@@ -0,0 +1,211 @@
+/** @file
+ * Generator pozycji rozwiązanych dokładnie
+ *
+ * Program @p gamma_solve @p WIDTH @p HEIGHT @p AREAS rozgrywa losowe
+ * początki gier dwóch graczy, rozwiązuje powstałe pozycje i wypisuje
+ * po jednej linii na pozycję:
+ *
+ *     PLANSZA GRACZ WYNIK RUCH POLA1 POLA2
+ *
+ * PLANSZA to wiersze planszy od górnego, oddzielone znakiem @p /,
+ * GRACZ to gracz wykonujący ruch, WYNIK to różnica pól tego gracza
+ * i przeciwnika przy optymalnej grze, RUCH to pierwszy optymalny ruch
+ * (@p x @p y, z przedrostkiem @p G dla złotego ruchu, albo @p - gdy gracz
+ * nie ma ruchu), a POLA1 i POLA2 to liczby pól graczy na końcu optymalnej
+ * gry. Opcje:
+ * - @p -g @p N – liczba pozycji, domyślnie 10,
+ * - @p -m @p N – liczba losowych ruchów przed rozwiązaniem, domyślnie
+ *   połowa pól planszy,
+ * - @p -t @p N – liczba wątków, domyślnie liczba procesorów,
+ * - @p -s @p N – ziarno generatora liczb losowych, domyślnie 1.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "gamma.h"
+#include "solver.h"
+
+
+/** @brief Losuje kolejną liczbę generatorem xorshift.
+ * @param[in, out] state – stan generatora, liczba niezerowa.
+ * @return Wylosowana liczba.
+ */
+static inline uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+
+/** @brief Wykonuje losowy ruch gracza.
+ * Co ósmy ruch jest w miarę możliwości złotym ruchem.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza,
+ * @param[in] width      – szerokość planszy,
+ * @param[in] height     – wysokość planszy,
+ * @param[in,out] random – stan generatora liczb losowych.
+ */
+static void random_move(gamma_t *g, uint32_t player, uint32_t width,
+                        uint32_t height, uint64_t *random) {
+    uint32_t fields = width * height;
+    uint32_t start = (uint32_t) (next_random(random) % fields);
+    bool golden = next_random(random) % 8 == 0;
+
+    for (int pass = 0; pass < 2; pass++, golden = !golden) {
+        for (uint32_t i = 0; i < fields; i++) {
+            uint32_t f = (start + i) % fields;
+            uint32_t x = f % width, y = f / width;
+
+            if (golden ? gamma_golden_move(g, player, x, y)
+                       : gamma_move(g, player, x, y))
+                return;
+        }
+    }
+}
+
+
+/** @brief Wypisuje linię opisującą rozwiązaną pozycję.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] to_move – gracz wykonujący ruch,
+ * @param[in] r       – wynik rozwiązania.
+ * @return Wartość @p true, jeżeli udało się zaalokować pamięć na planszę,
+ * @p false w przeciwnym przypadku.
+ */
+static bool print_solution(gamma_t *g, uint32_t to_move,
+                           const solver_result_t *r) {
+    char *board = gamma_board(g);
+    char *p;
+
+    if (board == NULL)
+        return false;
+
+    for (p = board; *p != '\0'; p++) {
+        if (*p == '\n')
+            *p = p[1] == '\0' ? '\0' : '/';
+    }
+
+    printf("%s %u %d ", board, to_move, r->value);
+    if (!r->has_move)
+        printf("-");
+    else
+        printf("%s%u %u", r->golden ? "G " : "", r->x, r->y);
+    printf(" %u %u\n", r->score[0], r->score[1]);
+
+    free(board);
+
+    return true;
+}
+
+
+/** @brief Wczytuje dodatnią liczbę z argumentu programu.
+ * @param[in] s  – wczytywany argument,
+ * @param[out] n – wczytana liczba.
+ * @return Wartość @p true jeżeli argument był dodatnią liczbą uint32_t,
+ * @p false w przeciwnym wypadku.
+ */
+static bool parse_count(const char *s, uint32_t *n) {
+    char *end;
+    unsigned long value;
+
+    if (s[0] < '0' || s[0] > '9')
+        return false;
+
+    errno = 0;
+    value = strtoul(s, &end, 10);
+    if (errno != 0 || *end != '\0' || value == 0 || value > UINT32_MAX)
+        return false;
+
+    *n = (uint32_t) value;
+
+    return true;
+}
+
+
+/** @brief Generuje i rozwiązuje pozycje.
+ * @param[in] argc  – liczba argumentów programu,
+ * @param[in] argv  – argumenty programu.
+ * @return Zero jeżeli się udało, jeden w przeciwnym wypadku.
+ */
+int main(int argc, char *argv[]) {
+    uint32_t width, height, areas, games = 10, moves = 0, threads, seed = 1;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    bool correct = argc >= 4 && argc % 2 == 0;
+    struct timespec start, stop;
+    uint64_t nodes = 0;
+
+    threads = cpus > 0 ? (uint32_t) cpus : 1;
+
+    if (correct)
+        correct = parse_count(argv[1], &width) && parse_count(argv[2], &height)
+                  && parse_count(argv[3], &areas)
+                  && (uint64_t) width * height <= SOLVER_MAX_FIELDS;
+
+    for (int i = 4; i < argc && correct; i += 2) {
+        if (strcmp(argv[i], "-g") == 0)
+            correct = parse_count(argv[i + 1], &games);
+        else if (strcmp(argv[i], "-m") == 0)
+            correct = parse_count(argv[i + 1], &moves);
+        else if (strcmp(argv[i], "-t") == 0)
+            correct = parse_count(argv[i + 1], &threads);
+        else if (strcmp(argv[i], "-s") == 0)
+            correct = parse_count(argv[i + 1], &seed);
+        else
+            correct = false;
+    }
+
+    if (!correct) {
+        fprintf(stderr, "Usage: gamma_solve WIDTH HEIGHT AREAS [-g GAMES]"
+                        " [-m MOVES] [-t THREADS] [-s SEED]\n"
+                        "WIDTH * HEIGHT must not exceed %d\n",
+                SOLVER_MAX_FIELDS);
+        return 1;
+    }
+
+    if (moves == 0)
+        moves = width * height / 2;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t i = 0; i < games; i++) {
+        uint64_t random = 0x9e3779b97f4a7c15ULL * (seed + (uint64_t) i) | 1;
+        gamma_t *g = gamma_new(width, height, 2, areas);
+        uint32_t player = 1;
+        solver_position_t pos;
+        solver_result_t r;
+
+        if (g == NULL)
+            return 1;
+
+        for (uint32_t m = 0; m < moves; m++, player = 3 - player)
+            random_move(g, player, width, height, &random);
+
+        if (!solver_position(g, width, height, areas, player, &pos)
+            || !solver_solve(&pos, threads, &r) || !print_solution(g, player, &r)) {
+            gamma_delete(g);
+            return 1;
+        }
+
+        nodes += r.nodes;
+        gamma_delete(g);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    fprintf(stderr, "positions: %u, nodes: %llu, seconds: %.3f\n", games,
+            (unsigned long long) nodes,
+            (double) (stop.tv_sec - start.tv_sec)
+            + (double) (stop.tv_nsec - start.tv_nsec) / 1e9);
+
+    return 0;
+}
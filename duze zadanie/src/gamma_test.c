@@ -32,6 +32,342 @@ static const char board[] =
   "1221......\n"
   "1.........\n";
 
+/** @brief Testuje numery obszarów po podziale i połączeniu.
+ * Złoty ruch dzieli obszar gracza 1 na dwa, a następny jego ruch łączy je
+ * z powrotem. Dawny przydział numerów obszarów liczył wtedy graczowi 1
+ * dwa obszary zamiast jednego i odrzucał jego kolejny ruch.
+ */
+static void test_golden_split_merge(void) {
+  gamma_t *g = gamma_new(2, 3, 2, 2);
+  assert(g != NULL);
+
+  assert(gamma_move(g, 1, 0, 1));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_move(g, 1, 1, 1));
+  assert(gamma_golden_move(g, 2, 1, 1));
+  assert(gamma_busy_fields(g, 1) == 2);
+  assert(gamma_free_fields(g, 1) == 2);
+  assert(gamma_busy_fields(g, 2) == 1);
+  assert(gamma_free_fields(g, 2) == 3);
+
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_busy_fields(g, 1) == 3);
+  assert(gamma_free_fields(g, 1) == 2);
+  assert(gamma_busy_fields(g, 2) == 1);
+  assert(gamma_free_fields(g, 2) == 2);
+
+  assert(gamma_move(g, 1, 1, 2));
+  assert(gamma_busy_fields(g, 1) == 4);
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_free_fields(g, 2) == 1);
+  assert(gamma_move(g, 2, 0, 2));
+  assert(gamma_busy_fields(g, 2) == 2);
+  assert(gamma_free_fields(g, 1) == 0);
+  assert(gamma_free_fields(g, 2) == 0);
+
+  gamma_delete(g);
+}
+
+/** @brief Porównuje dwie gry o tej samej planszy.
+ * @param[in] a       – wskaźnik na pierwszą grę,
+ * @param[in] b       – wskaźnik na drugą grę,
+ * @param[in] players – liczba graczy obu gier.
+ */
+static void assert_same_game(gamma_t *a, gamma_t *b, uint32_t players) {
+  assert(gamma_hash(a) == gamma_hash(b));
+
+  for (uint32_t player = 1; player <= players; player++) {
+    gamma_player_stats_t sa, sb;
+
+    assert(gamma_busy_fields(a, player) == gamma_busy_fields(b, player));
+    assert(gamma_free_fields(a, player) == gamma_free_fields(b, player));
+    assert(gamma_golden_possible(a, player)
+           == gamma_golden_possible(b, player));
+    assert(gamma_player_stats(a, player, &sa));
+    assert(gamma_player_stats(b, player, &sb));
+    assert(sa.areas == sb.areas);
+    assert(sa.perimeter == sb.perimeter);
+    assert(sa.largest_area == sb.largest_area);
+    assert(memcmp(sa.area_sizes, sb.area_sizes, sizeof(sa.area_sizes)) == 0);
+  }
+}
+
+/** @brief Buduje grę ruchami według tablicy właścicieli.
+ * @param[in] width   – szerokość planszy,
+ * @param[in] height  – wysokość planszy,
+ * @param[in] players – liczba graczy,
+ * @param[in] areas   – maksymalna liczba obszarów gracza,
+ * @param[in] owners  – właściciele pól jak w @ref gamma_new_from_owners.
+ * @return Wskaźnik na grę.
+ */
+static gamma_t *play_owners(uint32_t width, uint32_t height, uint32_t players,
+                            uint32_t areas, const uint32_t *owners) {
+  gamma_t *g = gamma_new(width, height, players, areas);
+  assert(g != NULL);
+
+  for (uint32_t y = 0; y < height; y++)
+    for (uint32_t x = 0; x < width; x++)
+      if (owners[y * width + x] != 0)
+        assert(gamma_move(g, owners[y * width + x], x, y));
+
+  return g;
+}
+
+/** @brief Testuje tworzenie gry z tablicy właścicieli.
+ * Gra z @ref gamma_new_from_owners musi mieć te same liczniki i skrót co
+ * gra z tą samą planszą zbudowana ruchami. Plansza 1024 x 160 ma dość pól,
+ * żeby była dzielona na kilka pasów, a obszary przechodzą przez ich granice.
+ */
+static void test_new_from_owners(void) {
+  static const uint32_t small[] = {
+    1, 1, 0, 2, 2,
+    0, 1, 0, 3, 2,
+    3, 1, 1, 0, 2,
+    3, 0, 2, 2, 2,
+  };
+  static const uint32_t too_many[] = {
+    1, 0, 1, 0, 1,
+  };
+  const uint32_t width = 1024, height = 160;
+  uint32_t *owners = malloc(width * height * sizeof(uint32_t));
+  uint64_t random = 1;
+  gamma_t *a, *b;
+
+  a = gamma_new_from_owners(5, 4, 3, 2, small);
+  b = play_owners(5, 4, 3, 2, small);
+  assert(a != NULL);
+  assert_same_game(a, b, 3);
+  assert(gamma_busy_fields(a, 2) == 7);
+  assert(gamma_free_fields(a, 1) == 5);
+  assert(gamma_free_fields(a, 3) == 4);
+  gamma_delete(a);
+  gamma_delete(b);
+
+  assert(owners != NULL);
+  for (uint32_t i = 0; i < width * height; i++) {
+    random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+    owners[i] = (uint32_t) (random >> 61) % 4;
+  }
+  a = gamma_new_from_owners(width, height, 3, width * height, owners);
+  b = play_owners(width, height, 3, width * height, owners);
+  assert(a != NULL);
+  assert_same_game(a, b, 3);
+  gamma_delete(a);
+  gamma_delete(b);
+  free(owners);
+
+  assert(gamma_new_from_owners(5, 1, 1, 2, too_many) == NULL);
+  a = gamma_new_from_owners(5, 1, 1, 3, too_many);
+  assert(a != NULL);
+  assert(gamma_free_fields(a, 1) == 2);
+  gamma_delete(a);
+}
+
+/** @brief Testuje zwarty zapis stanu gry.
+ * Sprawdza odtworzenie gry z zapisu, odrzucanie każdego uciętego zapisu,
+ * zapisu z nadmiarowym bajtem oraz zapisów z niepoprawnymi danymi.
+ */
+static void test_snapshot_rle(void) {
+  static const uint8_t valid[] = {2, 1, 1, 2, 1, 3};
+  static const uint8_t zero_width[] = {0, 1, 1, 1, 0, 0};
+  static const uint8_t unused_bit[] = {1, 1, 1, 1, 2, 0};
+  static const uint8_t long_run[] = {2, 1, 1, 1, 0, 4};
+  static const uint8_t unfinished[] = {2, 1, 1, 1, 0, 0x80, 0x80};
+  static const uint8_t other_areas[] = {2, 1, 1, 9, 0, 3};
+  gamma_t *g = gamma_new(12, 7, 3, 4);
+  gamma_t *copy;
+  uint8_t *buf;
+  size_t size;
+  char *a, *b;
+  uint64_t random = 7;
+
+  assert(g != NULL);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_move(g, 2, 11, 6));
+  assert(gamma_move(g, 3, 5, 3));
+  assert(gamma_move(g, 2, 2, 0));
+  assert(gamma_move(g, 1, 0, 1));
+  assert(gamma_golden_move(g, 3, 1, 0));
+
+  size = gamma_snapshot_rle(g, NULL, 0);
+  assert(size > 0);
+  buf = malloc(size + 1);
+  assert(buf != NULL);
+  assert(gamma_snapshot_rle(g, buf, 3) == size);
+  assert(gamma_snapshot_rle(g, buf, size) == size);
+
+  copy = gamma_from_snapshot_rle(buf, size);
+  assert(copy != NULL);
+  assert_same_game(g, copy, 3);
+  for (uint32_t player = 1; player <= 3; player++)
+    assert(gamma_golden_used(g, player) == gamma_golden_used(copy, player));
+  a = gamma_board(g);
+  b = gamma_board(copy);
+  assert(a != NULL && b != NULL);
+  assert(strcmp(a, b) == 0);
+  free(a);
+  free(b);
+  assert(gamma_move(copy, 1, 6, 6));
+  gamma_delete(copy);
+
+  for (size_t length = 0; length < size; length++)
+    assert(gamma_from_snapshot_rle(buf, length) == NULL);
+  buf[size] = 0;
+  assert(gamma_from_snapshot_rle(buf, size + 1) == NULL);
+  assert(gamma_from_snapshot_rle(NULL, size) == NULL);
+
+  copy = gamma_from_snapshot_rle(valid, sizeof(valid));
+  assert(copy != NULL);
+  assert(gamma_busy_fields(copy, 1) == 2);
+  assert(gamma_golden_used(copy, 1));
+  gamma_delete(copy);
+  assert(gamma_from_snapshot_rle(zero_width, sizeof(zero_width)) == NULL);
+  assert(gamma_from_snapshot_rle(unused_bit, sizeof(unused_bit)) == NULL);
+  assert(gamma_from_snapshot_rle(long_run, sizeof(long_run)) == NULL);
+  assert(gamma_from_snapshot_rle(unfinished, sizeof(unfinished)) == NULL);
+  assert(gamma_from_snapshot_rle(other_areas, sizeof(other_areas)) == NULL);
+
+  /* Zapis z jednym losowo zmienionym bajtem nie może zepsuć odczytu */
+  for (int i = 0; i < 10000; i++) {
+    assert(gamma_snapshot_rle(g, buf, size) == size);
+    random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+    buf[(random >> 32) % size] = (uint8_t) (random >> 56);
+    copy = gamma_from_snapshot_rle(buf, size);
+    if (copy != NULL)
+      assert(gamma_snapshot_rle(copy, NULL, 0) > 0);
+    gamma_delete(copy);
+  }
+
+  free(buf);
+  gamma_delete(g);
+}
+
+/** @brief Porównuje statystyki gracza z oczekiwanymi.
+ * @param[in] g         – wskaźnik na grę,
+ * @param[in] player    – numer gracza,
+ * @param[in] perimeter – oczekiwany obwód,
+ * @param[in] largest   – oczekiwana wielkość największego obszaru,
+ * @param[in] areas     – oczekiwana liczba obszarów,
+ * @param[in] sizes     – oczekiwane trzy pierwsze przedziały histogramu,
+ *                        pozostałe mają być zerami.
+ */
+static void assert_stats(gamma_t *g, uint32_t player, uint64_t perimeter,
+                         uint64_t largest, uint32_t areas,
+                         const uint32_t sizes[3]) {
+  gamma_player_stats_t stats;
+
+  assert(gamma_player_stats(g, player, &stats));
+  assert(stats.perimeter == perimeter);
+  assert(stats.largest_area == largest);
+  assert(stats.areas == areas);
+  for (uint32_t k = 0; k < GAMMA_AREA_SIZE_BUCKETS; k++)
+    assert(stats.area_sizes[k] == (k < 3 ? sizes[k] : 0));
+}
+
+/** @brief Testuje statystyki graczy.
+ * Gracz 1 ma obszar w kształcie litery T i pojedyncze pole. Złoty ruch
+ * gracza 2 na środek T dzieli je na trzy części, a kolejne ruchy gracza 1
+ * łączą dwie z nich z pojedynczym polem. Oczekiwane wartości są policzone
+ * ręcznie; plansza na końcu to @p stats_board.
+ */
+static void test_player_stats(void) {
+  static const char stats_board[] =
+    "..2...1\n"
+    "1121111\n"
+    "..1...2\n";
+  gamma_player_stats_t stats;
+  char *p;
+  gamma_t *g = gamma_new(7, 3, 2, 4);
+  assert(g != NULL);
+
+  assert(!gamma_player_stats(g, 3, &stats));
+  assert(!gamma_player_stats(g, 1, NULL));
+  assert_stats(g, 1, 0, 0, 0, (const uint32_t[3]) {0, 0, 0});
+
+  for (uint32_t x = 0; x < 5; x++)
+    assert(gamma_move(g, 1, x, 1));
+  assert_stats(g, 1, 12, 5, 1, (const uint32_t[3]) {0, 0, 1});
+  assert(gamma_move(g, 1, 2, 0));
+  assert(gamma_move(g, 1, 6, 2));
+  assert(gamma_move(g, 2, 6, 0));
+  assert_stats(g, 1, 18, 6, 2, (const uint32_t[3]) {1, 0, 1});
+  assert_stats(g, 2, 4, 1, 1, (const uint32_t[3]) {1, 0, 0});
+
+  assert(gamma_golden_move(g, 2, 2, 1));
+  assert_stats(g, 1, 20, 2, 4, (const uint32_t[3]) {2, 2, 0});
+  assert_stats(g, 2, 8, 1, 2, (const uint32_t[3]) {2, 0, 0});
+
+  assert(gamma_move(g, 2, 2, 2));
+  assert_stats(g, 2, 10, 2, 2, (const uint32_t[3]) {1, 1, 0});
+  assert(gamma_move(g, 1, 5, 1));
+  assert_stats(g, 1, 22, 3, 4, (const uint32_t[3]) {2, 2, 0});
+  assert(gamma_move(g, 1, 6, 1));
+  assert_stats(g, 1, 22, 5, 3, (const uint32_t[3]) {1, 1, 1});
+
+  p = gamma_board(g);
+  assert(p != NULL);
+  assert(strcmp(p, stats_board) == 0);
+  free(p);
+  gamma_delete(g);
+}
+
+/** @brief Porównuje miejsca graczy w rankingu z oczekiwanymi.
+ * @param[in] g      – wskaźnik na grę z trzema graczami,
+ * @param[in] leader – oczekiwany wynik @ref gamma_leader,
+ * @param[in] ranks  – oczekiwane miejsca graczy 1, 2 i 3.
+ */
+static void assert_ranking(gamma_t *g, uint32_t leader,
+                           const uint32_t ranks[3]) {
+  assert(gamma_leader(g) == leader);
+  for (uint32_t player = 1; player <= 3; player++)
+    assert(gamma_rank(g, player) == ranks[player - 1]);
+}
+
+/** @brief Testuje ranking graczy.
+ * Sprawdza remisy, spadek gracza w rankingu po utracie pola w złotym
+ * ruchu i grę z jednym graczem.
+ */
+static void test_ranking(void) {
+  gamma_t *g = gamma_new(5, 5, 3, 5);
+  assert(g != NULL);
+
+  assert(gamma_leader(NULL) == 0);
+  assert(gamma_rank(g, 0) == 0);
+  assert(gamma_rank(g, 4) == 0);
+  assert_ranking(g, 0, (const uint32_t[3]) {1, 1, 1});
+
+  assert(gamma_move(g, 1, 0, 0));
+  assert_ranking(g, 1, (const uint32_t[3]) {1, 2, 2});
+  assert(gamma_move(g, 2, 4, 4));
+  assert(gamma_move(g, 2, 4, 3));
+  assert_ranking(g, 2, (const uint32_t[3]) {2, 1, 3});
+  assert(gamma_move(g, 1, 1, 0));
+  assert_ranking(g, 0, (const uint32_t[3]) {1, 1, 3});
+
+  assert(gamma_move(g, 3, 2, 2));
+  assert(gamma_move(g, 3, 2, 3));
+  assert(gamma_move(g, 3, 2, 4));
+  assert_ranking(g, 3, (const uint32_t[3]) {2, 2, 1});
+
+  /* Gracz 3 traci pole i spada z pierwszego miejsca na remis z graczem 2 */
+  assert(gamma_golden_move(g, 1, 2, 3));
+  assert_ranking(g, 1, (const uint32_t[3]) {1, 2, 2});
+  assert(gamma_golden_move(g, 2, 0, 0));
+  assert_ranking(g, 2, (const uint32_t[3]) {2, 1, 2});
+  gamma_delete(g);
+
+  g = gamma_new(3, 3, 1, 2);
+  assert(g != NULL);
+  assert(gamma_leader(g) == 1);
+  assert(gamma_rank(g, 1) == 1);
+  assert(gamma_move(g, 1, 1, 1));
+  assert(gamma_leader(g) == 1);
+  assert(gamma_rank(g, 1) == 1);
+  assert(gamma_rank(g, 2) == 0);
+  gamma_delete(g);
+}
+
 /** @brief Testuje silnik gry gamma.
  * Przeprowadza przykładowe testy silnika gry gamma.
  * @return Zero, gdy wszystkie testy przebiegły poprawnie,
@@ -94,5 +430,11 @@ int main() {
   free(p);
 
   gamma_delete(g);
+
+  test_golden_split_merge();
+  test_new_from_owners();
+  test_snapshot_rle();
+  test_player_stats();
+  test_ranking();
   return 0;
 }
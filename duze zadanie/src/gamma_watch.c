@@ -0,0 +1,110 @@
+/** @file
+ * Podgląd planszy gry udostępnionej w pamięci współdzielonej
+ *
+ * Program @p gamma_watch @p NAME wypisuje planszę gry uruchomionej
+ * z opcją @p --share @p NAME, czytając ją prosto z segmentu pamięci
+ * współdzielonej, bez udziału procesu gry. Opcje:
+ * - @p -n @p N – liczba wypisanych plansz, domyślnie 1; kolejna plansza
+ *   jest wypisywana dopiero, gdy się zmieni, a plansze są oddzielone pustą
+ *   linią,
+ * - @p -i @p N – odstęp w milisekundach między sprawdzeniami, czy plansza
+ *   się zmieniła, domyślnie 100.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gamma.h"
+
+
+/** @brief Wczytuje dodatnią liczbę z argumentu programu.
+ * @param[in] s  – wczytywany argument,
+ * @param[out] n – wczytana liczba.
+ * @return Wartość @p true jeżeli argument był dodatnią liczbą uint32_t,
+ * @p false w przeciwnym wypadku.
+ */
+static bool parse_count(const char *s, uint32_t *n) {
+    char *end;
+    unsigned long value;
+
+    if (s[0] < '0' || s[0] > '9')
+        return false;
+
+    errno = 0;
+    value = strtoul(s, &end, 10);
+    if (errno != 0 || *end != '\0' || value == 0 || value > UINT32_MAX)
+        return false;
+
+    *n = (uint32_t) value;
+
+    return true;
+}
+
+
+/** @brief Wypisuje kolejne stany planszy.
+ * @param[in] argc  – liczba argumentów programu,
+ * @param[in] argv  – argumenty programu.
+ * @return Zero jeżeli się udało, jeden w przeciwnym wypadku.
+ */
+int main(int argc, char *argv[]) {
+    uint32_t boards = 1, interval = 100;
+    bool correct = argc >= 2 && argc % 2 == 0;
+    uint64_t shown = 0;
+    gamma_view_t *v;
+    struct timespec pause;
+
+    for (int i = 2; i < argc && correct; i += 2) {
+        if (strcmp(argv[i], "-n") == 0)
+            correct = parse_count(argv[i + 1], &boards);
+        else if (strcmp(argv[i], "-i") == 0)
+            correct = parse_count(argv[i + 1], &interval);
+        else
+            correct = false;
+    }
+
+    if (!correct) {
+        fprintf(stderr, "Usage: gamma_watch NAME [-n BOARDS]"
+                        " [-i MILLISECONDS]\n");
+        return 1;
+    }
+
+    v = gamma_view_open(argv[1]);
+    if (v == NULL) {
+        fprintf(stderr, "Cannot open the shared board %s\n", argv[1]);
+        return 1;
+    }
+
+    pause.tv_sec = interval / 1000;
+    pause.tv_nsec = (long) (interval % 1000) * 1000000;
+
+    for (uint32_t i = 0; i < boards; i++) {
+        char *board;
+
+        /* Ruch w trakcie wypisywania może dać tę samą planszę dwa razy */
+        while (i > 0 && gamma_view_sequence(v) == shown)
+            nanosleep(&pause, NULL);
+
+        shown = gamma_view_sequence(v);
+        board = gamma_view_board(v);
+        if (board == NULL) {
+            gamma_view_close(v);
+            return 1;
+        }
+
+        printf("%s%s", i > 0 ? "\n" : "", board);
+        fflush(stdout);
+        free(board);
+    }
+
+    gamma_view_close(v);
+
+    return 0;
+}
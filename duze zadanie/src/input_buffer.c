@@ -0,0 +1,205 @@
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input_buffer.h"
+
+
+/* Stan czytanego wejścia */
+
+static int input_fd = -1; /* deskryptor wejścia */
+static char *data = NULL; /* bufor lub zmapowany plik */
+static bool mapped = false; /* czy data to zmapowany plik */
+static size_t data_len = 0; /* długość zmapowanego pliku */
+static size_t begin = 0; /* pierwszy nieprzeczytany bajt w data */
+static size_t end = 0; /* koniec poprawnych danych w data */
+static bool finished = false; /* czy natrafiono na koniec wejścia */
+static uint64_t base = 0; /* pozycja data[0] w strumieniu wejścia */
+
+
+/* Mapuje zwykły plik od bieżącej pozycji deskryptora */
+static bool try_to_map(int fd) {
+    struct stat st;
+    off_t position;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0
+        || (uint64_t) st.st_size > SIZE_MAX)
+        return false;
+
+    position = lseek(fd, 0, SEEK_CUR);
+    if (position < 0 || position >= st.st_size)
+        return false;
+
+    void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED)
+        return false;
+
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+    data = m;
+    data_len = st.st_size;
+    begin = position;
+    end = data_len;
+    base = 0;
+    mapped = true;
+
+    return true;
+}
+
+
+bool input_open(int fd) {
+    input_fd = fd;
+    begin = end = 0;
+    finished = false;
+
+    if (try_to_map(fd))
+        return true;
+
+    off_t position = lseek(fd, 0, SEEK_CUR);
+    base = position > 0 ? (uint64_t) position : 0;
+    data = malloc(INPUT_BUFFER_SIZE * sizeof(char));
+    mapped = false;
+
+    return data != NULL;
+}
+
+
+void input_close(void) {
+    if (mapped)
+        munmap(data, data_len);
+    else
+        free(data);
+
+    data = NULL;
+    mapped = false;
+    input_fd = -1;
+}
+
+
+/* Przesuwa nieprzeczytane dane na początek bufora i doczytuje kolejne,
+ * zwraca false na końcu wejścia */
+static bool refill(void) {
+    ssize_t n;
+
+    if (finished || mapped || data == NULL) {
+        finished = true;
+        return false;
+    }
+
+    if (begin > 0) {
+        memmove(data, data + begin, end - begin);
+        base += begin;
+        end -= begin;
+        begin = 0;
+    }
+
+    do {
+        n = read(input_fd, data + end, INPUT_BUFFER_SIZE - end);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        finished = true;
+        return false;
+    }
+
+    end += (size_t) n;
+
+    return true;
+}
+
+
+bool input_next_span(const char **span, size_t *len, bool *eol) {
+    if (begin == end && !refill())
+        return false;
+
+    const char *s = data + begin;
+    size_t available = end - begin;
+    const char *nl = memchr(s, '\n', available);
+
+    *span = s;
+    if (nl != NULL) {
+        *len = nl - s;
+        *eol = true;
+        begin += *len + 1;
+    } else {
+        *len = available;
+        *eol = false;
+        begin = end;
+    }
+
+    return true;
+}
+
+
+size_t input_peek(const char **p, size_t n) {
+    while (end - begin < n && refill()) {
+    }
+
+    *p = data + begin;
+
+    return end - begin;
+}
+
+
+void input_skip(size_t n) {
+    begin += n;
+}
+
+
+bool input_buffered(void) {
+    return begin < end;
+}
+
+
+int input_getc(void) {
+    if (begin == end && !refill())
+        return EOF;
+
+    return (unsigned char) data[begin++];
+}
+
+
+uint64_t input_offset(void) {
+    return base + begin;
+}
+
+
+bool input_seek(uint64_t offset) {
+    if (mapped) {
+        if (offset > data_len)
+            return false;
+
+        begin = offset;
+        return true;
+    }
+
+    if (data == NULL)
+        return false;
+
+    if (offset <= (uint64_t) INT64_MAX
+        && lseek(input_fd, (off_t) offset, SEEK_SET) >= 0) {
+        base = offset;
+        begin = end = 0;
+        finished = false;
+        return true;
+    }
+
+    /* Wejścia bez przewijania (np. potoki) można jedynie przeczytać */
+    if (offset < base + begin)
+        return false;
+
+    while (offset > base + end) {
+        begin = end;
+        if (!refill())
+            return false;
+    }
+
+    begin = (size_t) (offset - base);
+
+    return true;
+}
@@ -0,0 +1,105 @@
+/** @file
+ * Interfejs buforowanego czytania standardowego wejścia gry gamma
+ *
+ * Wejście czytane jest dużymi blokami funkcją read(2), a jeżeli deskryptor
+ * wskazuje na zwykły plik, to jest on w całości mapowany do pamięci.
+ * Moduł udostępnia wejście fragmentami kończącymi się na znaku nowej linii
+ * lub na końcu bufora.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_INPUT_BUFFER_H
+#define GAMMA_INPUT_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Rozmiar bufora, do którego czytane jest wejście niebędące zwykłym plikiem.
+ */
+#define INPUT_BUFFER_SIZE (1 << 20)
+
+
+/** @brief Przygotowuje czytanie z deskryptora.
+ * Jeżeli @p fd wskazuje na zwykły plik, to mapuje go do pamięci,
+ * w przeciwnym wypadku alokuje bufor o rozmiarze @ref INPUT_BUFFER_SIZE.
+ * @param[in] fd – deskryptor, z którego będzie czytane wejście.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+bool input_open(int fd);
+
+
+/** @brief Zwalnia zasoby zajęte przez @ref input_open.
+ */
+void input_close(void);
+
+
+/** @brief Podaje kolejny fragment wejścia.
+ * Fragment kończy się przed najbliższym znakiem nowej linii (który jest
+ * pomijany) lub na końcu bufora. Wskaźnik @p span jest ważny do następnego
+ * wywołania dowolnej funkcji czytającej z tego modułu.
+ * @param[out] span – początek fragmentu,
+ * @param[out] len  – długość fragmentu,
+ * @param[out] eol  – @p true jeżeli fragment zakończył się znakiem nowej linii.
+ * @return Wartość @p false jeżeli wejście się skończyło, @p true w przeciwnym
+ * wypadku.
+ */
+bool input_next_span(const char **span, size_t *len, bool *eol);
+
+
+/** @brief Udostępnia początek nieprzeczytanego wejścia bez jego zużywania.
+ * Doczytuje wejście, dopóki nie będzie dostępnych co najmniej @p n bajtów
+ * lub wejście się nie skończy. Wskaźnik @p p jest ważny do następnego
+ * wywołania dowolnej funkcji czytającej z tego modułu.
+ * @param[out] p – początek nieprzeczytanego wejścia,
+ * @param[in] n  – liczba potrzebnych bajtów, co najwyżej
+ *                 @ref INPUT_BUFFER_SIZE.
+ * @return Liczba dostępnych bajtów, mniejsza od @p n tylko na końcu wejścia.
+ */
+size_t input_peek(const char **p, size_t n);
+
+
+/** @brief Pomija bajty udostępnione przez @ref input_peek.
+ * @param[in] n – liczba pomijanych bajtów, nie większa od liczby dostępnych.
+ */
+void input_skip(size_t n);
+
+
+/** @brief Sprawdza, czy w buforze zostały nieprzeczytane dane.
+ * @return Wartość @p true jeżeli kolejne czytanie nie będzie wymagało
+ * wywołania read(2), @p false w przeciwnym wypadku.
+ */
+bool input_buffered(void);
+
+
+/** @brief Wczytuje pojedynczy znak z wejścia.
+ * @return Wczytany znak jako @p unsigned @p char przekonwertowany na @p int
+ * lub @p EOF, jeżeli wejście się skończyło.
+ */
+int input_getc(void);
+
+
+/** @brief Podaje pozycję pierwszego nieprzeczytanego bajtu wejścia.
+ * Dla zwykłego pliku jest to pozycja w pliku, dla innych wejść liczba
+ * bajtów przeczytanych od wywołania @ref input_open.
+ * @return Pozycja w strumieniu wejścia.
+ */
+uint64_t input_offset(void);
+
+
+/** @brief Przechodzi do podanej pozycji wejścia.
+ * Jeżeli wejścia nie da się przewinąć, to pomija bajty do tej pozycji,
+ * więc możliwe jest jedynie przejście do przodu.
+ * @param[in] offset – pozycja w sensie @ref input_offset.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli wejście jest
+ * krótsze lub nie da się cofnąć do @p offset.
+ */
+bool input_seek(uint64_t offset);
+
+
+#endif /* GAMMA_INPUT_BUFFER_H */
@@ -1,10 +1,15 @@
-#include <stdio.h>
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
 #include <termios.h>
 #include <sys/ioctl.h>
-#include <math.h>
 #include "interactive_mode.h"
+#include "bot.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
 #include <unistd.h>
 
 /* Globalne parametry dotczące rozgywki */
@@ -15,40 +20,193 @@ static uint32_t players_count; /* liczba graczy */
 static uint32_t x, y; /* współrzędne w grze */
 static struct termios default_state, game_state; /* stany terminala */
 static const uint32_t banner_height = 5; /* wysokość baneru "GAMMA" */
+static const uint32_t banner_width = 42; /* szerokość baneru "GAMMA" */
+static const uint32_t max_message_height = 4; /* wysokość komunikatu */
+static uint32_t field_width; /* szerokość pola na ekranie */
+static uint64_t shown_version; /* wersja gry widoczna na ekranie */
+static uint32_t current_player; /* gracz wykonujący ruch, 0 poza turą */
+
+/* Widoczny fragment planszy */
+
+static uint32_t view_x, view_y; /* lewe dolne pole fragmentu */
+static uint32_t view_w, view_h; /* wymiary fragmentu */
+static uint32_t *window = NULL; /* właściciele pól fragmentu */
+
+/* Obsługa zmiany rozmiaru terminala */
+
+static volatile sig_atomic_t resized = 0; /* czy otrzymano SIGWINCH */
+static sigset_t default_mask; /* maska sygnałów sprzed rozgrywki */
+static sigset_t wait_mask; /* maska sygnałów na czas czekania na klawisz */
+static struct sigaction default_winch; /* obsługa SIGWINCH sprzed rozgrywki */
+static bool signals_set = false; /* czy zmieniono obsługę sygnałów */
+
+/* Bufor, w którym budowana jest klatka; wypisywany jednym write(2) */
+static output_t frame;
 
 
 /* Procedury obsługujące tryb interaktywny */
 
-static bool is_enough_space() {
-    uint32_t length = floor(log10(players_count)) + 2;
-    uint32_t max_message_height = 4;
-    uint32_t banner_width = 42;
-    struct winsize w;
+/* Liczy cyfry liczby dodatniej */
+static uint32_t count_digits(uint32_t n) {
+    uint32_t counter = 0;
 
-    if (ioctl(0, TIOCGWINSZ, &w) != 0)
-        return false;
+    do {
+        n /= 10;
+        counter++;
+    } while (n > 0);
+
+    return counter;
+}
+
+
+/* Wypisuje zbudowaną klatkę */
+static inline void show_frame() {
+    output_flush(&frame);
+}
+
+
+/* Dopisuje do klatki przesunięcie kursora na pozycję (row, column) */
+static void go_to(uint32_t row, uint32_t column) {
+    output_str(&frame, "\033[");
+    output_uint(&frame, row);
+    output_char(&frame, ';');
+    output_uint(&frame, column);
+    output_char(&frame, 'H');
+}
+
+
+/* Zapamiętuje zmianę rozmiaru okna */
+static void handle_resize_signal(int sig) {
+    (void) sig;
+    resized = 1;
+}
+
+
+/* Sprawdza, czy w oknie mieszczą się baner, komunikat i choć jedno pole */
+static bool is_enough_space(const struct winsize *w) {
+    return w->ws_col >= field_width + 2 && w->ws_col >= banner_width
+           && w->ws_row >= banner_height + max_message_height + 4;
+}
+
+
+/* Przesuwa widoczny fragment tak, aby zawierał kursor.
+ * Zwraca true, jeżeli fragment się przesunął */
+static bool follow_cursor() {
+    uint32_t old_x = view_x, old_y = view_y;
+
+    if (x < view_x)
+        view_x = x;
+    else if (x >= view_x + view_w)
+        view_x = x - view_w + 1;
+
+    if (y < view_y)
+        view_y = y;
+    else if (y >= view_y + view_h)
+        view_y = y - view_h + 1;
+
+    if (view_x > width - view_w)
+        view_x = width - view_w;
+    if (view_y > height - view_h)
+        view_y = height - view_h;
+
+    return view_x != old_x || view_y != old_y;
+}
+
+
+/* Dopasowuje widoczny fragment i bufor klatki do rozmiaru okna */
+static bool fit_view(const struct winsize *w) {
+    uint32_t columns = (w->ws_col - 2u) / field_width;
+    uint32_t rows = w->ws_row - banner_height - max_message_height - 3;
+    /* Pole to co najwyżej kilkanaście bajtów wraz z sekwencjami sterującymi */
+    uint64_t size = 16 * (uint64_t) w->ws_row * w->ws_col + 1024;
+    uint32_t *bigger;
+    output_t larger;
+
+    view_w = columns < width ? columns : width;
+    view_h = rows < height ? rows : height;
+    follow_cursor();
 
-    if (w.ws_col < length * width + 1 || w.ws_col < banner_width
-        || w.ws_row < banner_height + height + max_message_height + 3) {
-        printf("Error. Size of declared board exceeds size of your window\n");
-        printf("Program wil now exit with return code 1.\n");
+    bigger = realloc(window, (size_t) view_w * view_h * sizeof(uint32_t));
+    if (bigger == NULL)
         return false;
-    } else {
-        return true;
+    window = bigger;
+
+    /* Przy braku pamięci klatka jest po prostu wypisywana w częściach */
+    if (size > frame.cap && size <= SIZE_MAX
+        && output_init(&larger, STDOUT_FILENO, (size_t) size)) {
+        output_flush(&frame);
+        output_free(&frame);
+        frame = larger;
     }
+
+    return true;
+}
+
+
+/* Sygnał SIGWINCH jest odbierany jedynie podczas czekania na klawisz */
+static void catch_resize() {
+    struct sigaction sa;
+    sigset_t block;
+
+    sigemptyset(&block);
+    sigaddset(&block, SIGWINCH);
+    sigprocmask(SIG_BLOCK, &block, &default_mask);
+    wait_mask = default_mask;
+    sigdelset(&wait_mask, SIGWINCH);
+
+    sa.sa_handler = handle_resize_signal;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGWINCH, &sa, &default_winch);
+
+    resized = 0;
+    signals_set = true;
 }
 
+
 /* Inicjalizajca globalnych parametrów i przygotowanie termianala */
-static int prepare_for_game(uint32_t w, uint32_t h, uint32_t pc) {
+static int prepare_for_game(uint32_t w, uint32_t h, uint32_t pc,
+                            const uint32_t *bots, uint32_t bots_count) {
+    struct winsize ws;
+
     width = w;
     height = h;
     x = width / 2;
     y = height / 2 - ((height - 1) % 2);
     players_count = pc;
+    field_width = count_digits(players_count) + 1;
+    shown_version = 0;
+    current_player = 0;
+    view_x = view_y = 0;
+
+    if (!output_init(&frame, STDOUT_FILENO, OUTPUT_BUFFER_SIZE))
+        return -1;
 
-    if (!is_enough_space())
+    if (ioctl(0, TIOCGWINSZ, &ws) != 0)
         return -1;
 
+    if (!is_enough_space(&ws)) {
+        output_str(&frame,
+                   "Error. Your window is too small to show the board\n"
+                   "Program wil now exit with return code 1.\n");
+        show_frame();
+        return -1;
+    }
+
+    if (!bot_init(bots, bots_count, width, height, players_count)) {
+        output_str(&frame,
+                   "Error. Computer players must be numbered from 1 to the "
+                   "number of players\n"
+                   "Program wil now exit with return code 1.\n");
+        show_frame();
+        return -1;
+    }
+
+    if (!fit_view(&ws))
+        return -1;
+
+    catch_resize();
+
     if (tcgetattr(STDIN_FILENO, &default_state) != 0) {
         return -1;
     } else {
@@ -59,202 +217,240 @@ static int prepare_for_game(uint32_t w, uint32_t h, uint32_t pc) {
 }
 
 
+/* Przywraca obsługę sygnałów i zwalnia pamięć trybu interaktywnego */
+static void finish_game() {
+    if (signals_set) {
+        sigaction(SIGWINCH, &default_winch, NULL);
+        sigprocmask(SIG_SETMASK, &default_mask, NULL);
+        signals_set = false;
+    }
+
+    bot_free();
+    free(window);
+    window = NULL;
+    output_free(&frame);
+}
+
+
 static inline void print_banner() {
-    printf("\033[95m");
-    printf("   ______\n");
-    printf("  / ____/___ _____ ___  ____ ___  ____ _\n");
-    printf(" / / __/ __ `/ __ `__ \\/ __ `__ \\/ __ `/\n");
-    printf("/ /_/ / /_/ / / / / / / / / / / / /_/ / \n");
-    printf("\\____/\\__,_/_/ /_/ /_/_/ /_/ /_/\\__,_/\n");
-    printf("\033[0m");
+    output_str(&frame,
+               "\033[95m"
+               "   ______\n"
+               "  / ____/___ _____ ___  ____ ___  ____ _\n"
+               " / / __/ __ `/ __ `__ \\/ __ `__ \\/ __ `/\n"
+               "/ /_/ / /_/ / / / / / / / / / / / /_/ / \n"
+               "\\____/\\__,_/_/ /_/ /_/_/ /_/ /_/\\__,_/\n"
+               "\033[0m");
 }
 
 
-static inline void print_empty_field() {
-    uint32_t length = floor(log10(players_count)) + 2;
-    for (uint32_t i = 1; i < length; i++)
-        printf(" ");
+/* Dopisuje treść pola należącego do gracza player (0 dla wolnego),
+ * podświetloną jeżeli highlight */
+static void print_field(uint32_t player, bool highlight) {
+    uint32_t length = player == 0 ? 1 : count_digits(player);
 
-    printf(".");
-}
+    if (highlight)
+        output_str(&frame, "\033[44m");
 
+    for (uint32_t i = length; i < field_width; i++)
+        output_char(&frame, ' ');
 
-static inline void print_taken_field(uint32_t player) {
-    uint32_t field_length = floor(log10(players_count)) + 1;
-    uint32_t player_length = floor(log10(player)) + 1;
-    for (uint32_t i = 0; i <= field_length - player_length; i++)
-        printf(" ");
-    printf("%d", player);
-    printf("\033[%dD", field_length + 1);
+    if (player == 0)
+        output_char(&frame, '.');
+    else
+        output_uint(&frame, player);
+
+    if (highlight)
+        output_str(&frame, "\033[49m");
 }
 
 
 static inline void print_board_border(bool top) {
-    uint32_t length = floor(log10(players_count)) + 2;
+    output_str(&frame, top ? "╔" : "╚");
 
-    if (top)
-        printf("╔");
-    else
-        printf("╚");
+    for (uint32_t i = 0; i < field_width * view_w; i++)
+        output_str(&frame, "═");
 
-    for (uint32_t i = 0; i < length * width; i++) {
-        printf("═");
-    }
-
-    if (top)
-        printf("╗\n");
-    else
-        printf("╝\n");
+    output_str(&frame, top ? "╗\n" : "╝\n");
 }
 
 
-/* Wypisuje pustą planszę */
+/* Wypisuje ramkę widocznego fragmentu planszy */
 static void print_board() {
     print_board_border(true);
-    for (uint32_t i = 0; i < height; i++) {
-        printf("║");
-        for (uint32_t j = 0; j < width; j++) {
-            print_empty_field();
-        }
-        printf("║\n");
+    for (uint32_t i = 0; i < view_h; i++) {
+        output_str(&frame, "║");
+        go_to(banner_height + 2 + i, 2 + view_w * field_width);
+        output_str(&frame, "║\n");
     }
     print_board_border(false);
 }
 
 
-static inline void print_encouraging_message(gamma_t *g, uint32_t player) {
-    printf("PLAYER: %d\n", player);
-    printf("FIELDS TAKEN: %ld\n", gamma_busy_fields(g, player));
-    printf("FIELDS TO TAKE: %ld\n", gamma_free_fields(g, player));
-    if (gamma_golden_possible(g, player))
-        printf("\033[93mGOLDEN MOVE POSSIBLE\033[0m\n");
+/* Dopisuje pole (xi, yi), o ile jest widoczne */
+static void draw_field(gamma_t *g, uint32_t xi, uint32_t yi) {
+    if (xi < view_x || xi - view_x >= view_w
+        || yi < view_y || yi - view_y >= view_h)
+        return;
 
+    go_to(banner_height + 2 + (view_y + view_h - 1 - yi),
+          2 + (xi - view_x) * field_width);
+    print_field(gamma_whose_field(g, xi, yi), xi == x && yi == y);
 }
 
 
-/* Znajduje numer gracza, który zajmuje najwięcej pól.
- * Zwraca 0 jeżeli taki nie istnieje */
-static uint32_t find_winner(gamma_t *g) {
-    uint32_t leader_nr = 1;
-    uint32_t leader_score = gamma_busy_fields(g, 1);
-    uint32_t leaders_count = 1;
-
-    for (uint32_t i = 2; i <= players_count; i++) {
-        if (leader_score == gamma_busy_fields(g, i)) {
-            leaders_count++;
-        } else if (leader_score < gamma_busy_fields(g, i)) {
-            leader_nr = i;
-            leader_score = gamma_busy_fields(g, i);
-            leaders_count = 1;
+/* Dopisuje wszystkie widoczne pola planszy */
+static void draw_view(gamma_t *g) {
+    gamma_owners_window(g, view_x, view_y, view_w, view_h, window);
+
+    for (uint32_t j = view_h; j-- > 0;) {
+        go_to(banner_height + 2 + (view_h - 1 - j), 2);
+        for (uint32_t i = 0; i < view_w; i++) {
+            print_field(window[(size_t) j * view_w + i],
+                        view_x + i == x && view_y + j == y);
         }
     }
 
-    return leaders_count == 1 ? leader_nr : 0;
+    shown_version = gamma_version(g);
 }
 
 
-static void print_start_screen() {
-    printf("\033[1;1H\033[2J");
-    print_banner();
-    print_board();
-}
-
+/* Dopisuje widoczne pola zmienione od ostatnio wypisanej klatki */
+static void draw_changes(gamma_t *g) {
+    gamma_change_t *changes;
+    uint64_t count;
 
-static inline void print_score_board(gamma_t *g) {
-    printf("\033[94mSCOREBOARD\033[0m\n");
-    for (uint32_t i = 1; i <= players_count; i++) {
-        printf("Player %d: %ld\n", i, gamma_busy_fields(g, i));
+    if (!gamma_changes(g, shown_version, &changes, &count)) {
+        draw_view(g);
+        return;
     }
-}
 
+    for (uint64_t i = 0; i < count; i++)
+        draw_field(g, changes[i].x, changes[i].y);
+    free(changes);
 
-static void print_end_screen(gamma_t *g) {
-    uint32_t winner = find_winner(g);
+    shown_version = gamma_version(g);
+}
 
-    printf("\033[%d;1H\033[J", height + banner_height + 3);
 
-    if (winner != 0) {
-        printf("\033[32;5mCONGRATULATIONS PLAYER %d!\033[0m\n", winner);
-        printf("Your score: %ld\n\n", gamma_busy_fields(g, winner));
-    }
-
-    print_score_board(g);
+static inline void print_encouraging_message(gamma_t *g, uint32_t player) {
+    output_str(&frame, "PLAYER: ");
+    output_uint(&frame, player);
+    output_str(&frame, "\nFIELDS TAKEN: ");
+    output_uint(&frame, gamma_busy_fields(g, player));
+    output_str(&frame, "\nFIELDS TO TAKE: ");
+    output_uint(&frame, gamma_free_fields(g, player));
+    output_char(&frame, '\n');
+    if (gamma_golden_possible(g, player))
+        output_str(&frame, "\033[93mGOLDEN MOVE POSSIBLE\033[0m\n");
 }
 
 
 /* Czyści wszystko pod planszą */
 static void clear_message() {
-    printf("\033[%d;1H\033[J", height + banner_height + 3);
+    go_to(view_h + banner_height + 3, 1);
+    output_str(&frame, "\033[J");
 }
 
 
-static void highlighting(gamma_t *g, bool turn_on) {
-    uint32_t player = gamma_whose_field(g, x, y);
-    uint32_t field_length = floor(log10(players_count)) + 1;
+/* Dopisuje cały ekran wraz z komunikatem dla gracza wykonującego ruch */
+static void print_screen(gamma_t *g) {
+    output_str(&frame, "\033[1;1H\033[2J");
+    print_banner();
+    print_board();
+    draw_view(g);
 
-    if (turn_on)
-        printf("\033[44m");
+    if (current_player != 0) {
+        clear_message();
+        print_encouraging_message(g, current_player);
+    }
+}
 
-    if (player == 0) {
-        for (uint32_t i = 0; i < field_length; i++)
-            printf(" ");
 
-        printf(".");
-        printf("\033[%dD", field_length + 1);
-    } else {
-        print_taken_field(player);
-    }
+/* Dopasowuje ekran do nowego rozmiaru okna. Jeżeli nie mieści się na nim
+ * nawet jedno pole, ekran pozostaje bez zmian do następnej zmiany */
+static void handle_resize(gamma_t *g) {
+    struct winsize ws;
+
+    resized = 0;
 
-    if (turn_on)
-        printf("\033[49m");
+    if (ioctl(0, TIOCGWINSZ, &ws) != 0 || !is_enough_space(&ws))
+        return;
 
+    if (fit_view(&ws)) {
+        print_screen(g);
+        show_frame();
+    }
 }
 
 
-static inline void move_up(gamma_t *g) {
-    highlighting(g, false);
-    printf("\033[A");
-    y++;
-    highlighting(g, true);
-}
+/* Czyta znak z wejścia, w międzyczasie obsługując zmiany rozmiaru okna */
+static int read_key(gamma_t *g) {
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+
+    while (!input_buffered()) {
+        if (resized)
+            handle_resize(g);
 
+        if (ppoll(&pfd, 1, NULL, &wait_mask) > 0)
+            break;
+    }
 
-static inline void move_down(gamma_t *g) {
-    highlighting(g, false);
-    printf("\033[B");
-    y--;
-    highlighting(g, true);
+    return input_getc();
 }
 
 
-static inline void move_left(gamma_t *g, uint32_t length) {
-    highlighting(g, false);
-    printf("\033[%dD", length);
-    x--;
-    highlighting(g, true);
+static inline void print_score_board(gamma_t *g) {
+    output_str(&frame, "\033[94mSCOREBOARD\033[0m\n");
+    for (uint32_t i = 1; i <= players_count; i++) {
+        output_str(&frame, "Player ");
+        output_uint(&frame, i);
+        output_str(&frame, ": ");
+        output_uint(&frame, gamma_busy_fields(g, i));
+        output_char(&frame, '\n');
+    }
 }
 
 
-static inline void move_right(gamma_t *g, uint32_t length) {
-    highlighting(g, false);
-    printf("\033[%dC", length);
-    x++;
-    highlighting(g, true);
+static void print_end_screen(gamma_t *g) {
+    uint32_t winner = gamma_leader(g);
+
+    clear_message();
+
+    if (winner != 0) {
+        output_str(&frame, "\033[32;5mCONGRATULATIONS PLAYER ");
+        output_uint(&frame, winner);
+        output_str(&frame, "!\033[0m\nYour score: ");
+        output_uint(&frame, gamma_busy_fields(g, winner));
+        output_str(&frame, "\n\n");
+    }
+
+    print_score_board(g);
 }
 
 
 static void move_cursor(gamma_t *g, int c) {
-    uint32_t length = floor(log10(players_count)) + 2;
+    uint32_t old_x = x, old_y = y;
 
     if (c == 'A' && y < height - 1)
-        move_up(g);
+        y++;
     else if (c == 'B' && y > 0)
-        move_down(g);
+        y--;
     else if (c == 'C' && x < width - 1)
-        move_right(g, length);
+        x++;
     else if (c == 'D' && x > 0)
-        move_left(g, length);
+        x--;
+    else
+        return;
 
+    if (follow_cursor()) {
+        draw_view(g);
+    } else {
+        draw_field(g, old_x, old_y);
+        draw_field(g, x, y);
+    }
+
+    show_frame();
 }
 
 
@@ -266,14 +462,12 @@ static inline bool make_move(char c, uint32_t player, gamma_t *g) {
     else
         success = gamma_golden_move(g, player, x, y);
 
+    if (success)
+        draw_changes(g);
+    else
+        output_char(&frame, '\a');
 
-    if (success) {
-        printf("\033[44m");
-        print_taken_field(player);
-        printf("\033[49m");
-    } else {
-        printf("\a");
-    }
+    show_frame();
 
     return success;
 }
@@ -284,15 +478,13 @@ static bool player_input(gamma_t *g, uint32_t player, bool *move) {
     int c = '\0';
     bool char_interpreted = true;
 
-    printf("\033[u");
-
     while (!succesful_input) {
         if (char_interpreted)
-            c = getchar();
+            c = read_key(g);
 
         if (c == '\033') {
-            if ((c = getchar()) == '[') {
-                if ('A' <= (c = getchar()) && c <= 'D')
+            if ((c = read_key(g)) == '[') {
+                if ('A' <= (c = read_key(g)) && c <= 'D')
                     move_cursor(g, c);
                 else
                     char_interpreted = false;
@@ -303,62 +495,90 @@ static bool player_input(gamma_t *g, uint32_t player, bool *move) {
             succesful_input = true;
         } else if (c == 'G' || c == 'g' || c == ' ') {
             succesful_input = make_move(c, player, g);
-        } else if (c == 4) {
+        } else if (c == 4 || c == EOF) {
             return true;
         } else {
             char_interpreted = true;
         }
     }
 
-    printf("\033[s");
-
     if (!(*move)) {
-        *move = ((gamma_free_fields(g, player) > 0)
-                 || gamma_golden_possible(g, player));
+        *move = gamma_can_move(g, player);
     }
 
     return false;
 }
 
 
+/* Wykonuje ruch bota */
+static void play_bot(gamma_t *g, uint32_t player, bool *move) {
+    if (bot_move(g, player))
+        draw_changes(g);
+    show_frame();
+
+    if (!(*move))
+        *move = gamma_can_move(g, player);
+}
+
+
+/* Podczas tury człowieka najbliższy bot szuka swojego ruchu w tle */
+static void ponder_next_bot(gamma_t *g, uint32_t player) {
+    uint32_t bot = bot_next(player);
+
+    if (bot != 0)
+        bot_ponder(g, bot);
+}
+
+
 static void take_turns(gamma_t *g) {
     bool somebody_could_have_moved;
     bool shutdown = false;
-    uint32_t mid_column = 2 + (width / 2) * (floor(log10(players_count)) + 2);
-    uint32_t mid_row = banner_height + 2 + height / 2;
-
-    printf("\033[%d;%dH\033[s", mid_row, mid_column);
-    highlighting(g, true);
 
     do {
         somebody_could_have_moved = false;
         for (uint32_t player = 1; player <= players_count; player++) {
-            if ((gamma_free_fields(g, player) > 0)
-                || gamma_golden_possible(g, player)) {
+            if (gamma_can_move(g, player)) {
+                current_player = player;
                 clear_message();
                 print_encouraging_message(g, player);
-                shutdown = player_input(g, player, &somebody_could_have_moved);
+                show_frame();
+                if (bot_controls(player)) {
+                    play_bot(g, player, &somebody_could_have_moved);
+                } else {
+                    ponder_next_bot(g, player);
+                    shutdown = player_input(g, player,
+                                            &somebody_could_have_moved);
+                }
                 if (shutdown)
                     player = UINT32_MAX - 1;
             }
         }
     } while (somebody_could_have_moved && !shutdown);
 
+    current_player = 0;
 }
 
 
 int run_interactive_mode(gamma_t *g, uint32_t width0, uint32_t height0,
-                         uint32_t players_count0) {
-    if (prepare_for_game(width0, height0, players_count0) != 0)
+                         uint32_t players_count0, const uint32_t *bots,
+                         uint32_t bots_count) {
+    int result;
+
+    if (prepare_for_game(width0, height0, players_count0,
+                         bots, bots_count) != 0) {
+        finish_game();
         return -1;
+    }
 
-    print_start_screen();
+    print_screen(g);
 
-    printf("\033[?25l");
+    output_str(&frame, "\033[?25l");
     take_turns(g);
-    printf("\033[?25h");
+    output_str(&frame, "\033[?25h");
 
     print_end_screen(g);
+    result = tcsetattr(STDIN_FILENO, TCSANOW, &default_state);
+    finish_game();
 
-    return tcsetattr(STDIN_FILENO, TCSANOW, &default_state);
+    return result;
 }
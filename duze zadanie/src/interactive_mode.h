@@ -18,11 +18,14 @@
  * @param g               – wskaźnik do struktury przechowywującej stan gry,
  * @param width           – szerekość planszy w grze,
  * @param height          – wysokość planszy w grze,
- * @param players_count   – liczba graczy w grze.
+ * @param players_count   – liczba graczy w grze,
+ * @param bots            – numery graczy sterowanych przez komputer,
+ * @param bots_count      – liczba elementów tablicy @p bots.
  * @return @p -1 jeżeli wystąpił błąd, 0 w przeciwnym przypadku.
  */
 int run_interactive_mode(gamma_t *g, uint32_t width, uint32_t height,
-                         uint32_t players_count);
+                         uint32_t players_count, const uint32_t *bots,
+                         uint32_t bots_count);
 
 
 #endif /* GAMMA_INTERACTIVE_MODE_H */
@@ -0,0 +1,256 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "output_buffer.h"
+
+
+output_t std_out;
+output_t std_err;
+
+
+/* Pary cyfr liczb od 00 do 99 */
+static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+
+bool output_init(output_t *o, int fd, size_t cap) {
+    o->buf = malloc(cap * sizeof(char));
+    o->len = 0;
+    o->cap = cap;
+    o->fd = fd;
+    o->twin = NULL;
+    o->growing = false;
+    o->failed = false;
+
+    return o->buf != NULL;
+}
+
+
+bool output_init_growing(output_t *o, int fd, size_t cap) {
+    if (!output_init(o, fd, cap))
+        return false;
+
+    o->growing = true;
+
+    return true;
+}
+
+
+void output_free(output_t *o) {
+    output_flush(o);
+    free(o->buf);
+    o->buf = NULL;
+    o->cap = 0;
+    o->twin = NULL;
+}
+
+
+void output_link(output_t *a, output_t *b) {
+    struct stat sa, sb;
+
+    if (fstat(a->fd, &sa) != 0 || fstat(b->fd, &sb) != 0)
+        return;
+
+    if (sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino) {
+        a->twin = b;
+        b->twin = a;
+    }
+}
+
+
+bool output_open_std(void) {
+    if (!output_init(&std_out, STDOUT_FILENO, OUTPUT_BUFFER_SIZE))
+        return false;
+
+    if (!output_init(&std_err, STDERR_FILENO, OUTPUT_BUFFER_SIZE)) {
+        output_free(&std_out);
+        return false;
+    }
+
+    output_link(&std_out, &std_err);
+
+    return true;
+}
+
+
+void output_close_std(void) {
+    output_free(&std_out);
+    output_free(&std_err);
+}
+
+
+/* Zapisuje cały ciąg bajtów do deskryptora */
+static bool write_all(int fd, const char *s, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, s, len);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        s += n;
+        len -= (size_t) n;
+    }
+
+    return true;
+}
+
+
+bool output_drain(output_t *o) {
+    size_t done = 0;
+
+    while (done < o->len) {
+        ssize_t n = write(o->fd, o->buf + done, o->len - done);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0)
+            return false;
+
+        done += (size_t) n;
+    }
+
+    memmove(o->buf, o->buf + done, o->len - done);
+    o->len -= done;
+
+    return !o->failed;
+}
+
+
+/* Powiększa bufor rosnący, aby zmieściło się w nim len bajtów więcej;
+ * zwraca false, jeżeli zabrakło pamięci */
+static bool grow(output_t *o, size_t len) {
+    size_t cap = o->cap;
+    char *bigger;
+
+    while (cap - o->len < len)
+        cap *= 2;
+
+    bigger = realloc(o->buf, cap);
+    if (bigger == NULL) {
+        o->failed = true;
+        return false;
+    }
+
+    o->buf = bigger;
+    o->cap = cap;
+
+    return true;
+}
+
+
+/* Robi w buforze miejsce na len bajtów, wypisując go lub powiększając;
+ * zwraca false, jeżeli bufor rosnący nie zmieścił danych */
+static bool make_room(output_t *o, size_t len) {
+    if (o->len + len <= o->cap)
+        return true;
+
+    if (o->growing)
+        return grow(o, len);
+
+    output_flush(o);
+
+    return true;
+}
+
+
+bool output_flush(output_t *o) {
+    bool result = write_all(o->fd, o->buf, o->len);
+    o->len = 0;
+
+    return result;
+}
+
+
+/* Wypisuje bufor powiązany, aby zachować kolejność komunikatów */
+static inline void take_turn(output_t *o) {
+    if (o->twin != NULL && o->twin->len > 0)
+        output_flush(o->twin);
+}
+
+
+void output_write(output_t *o, const char *s, size_t len) {
+    take_turn(o);
+
+    if (o->growing) {
+        if (make_room(o, len)) {
+            memcpy(o->buf + o->len, s, len);
+            o->len += len;
+        }
+        return;
+    }
+
+    if (o->len + len > o->cap)
+        output_flush(o);
+
+    if (len > o->cap) {
+        write_all(o->fd, s, len);
+    } else {
+        memcpy(o->buf + o->len, s, len);
+        o->len += len;
+    }
+}
+
+
+void output_str(output_t *o, const char *s) {
+    output_write(o, s, strlen(s));
+}
+
+
+void output_char(output_t *o, char c) {
+    take_turn(o);
+
+    if (!make_room(o, 1))
+        return;
+
+    o->buf[o->len++] = c;
+}
+
+
+size_t format_uint(char *s, uint64_t n) {
+    char tmp[20];
+    size_t i = sizeof(tmp);
+
+    while (n >= 100) {
+        uint64_t pair = (n % 100) * 2;
+        n /= 100;
+        tmp[--i] = digit_pairs[pair + 1];
+        tmp[--i] = digit_pairs[pair];
+    }
+
+    if (n >= 10) {
+        tmp[--i] = digit_pairs[n * 2 + 1];
+        tmp[--i] = digit_pairs[n * 2];
+    } else {
+        tmp[--i] = (char) ('0' + n);
+    }
+
+    memcpy(s, tmp + i, sizeof(tmp) - i);
+
+    return sizeof(tmp) - i;
+}
+
+
+void output_uint(output_t *o, uint64_t n) {
+    take_turn(o);
+
+    if (!make_room(o, 20))
+        return;
+
+    o->len += format_uint(o->buf + o->len, n);
+}
@@ -0,0 +1,157 @@
+/** @file
+ * Interfejs buforowanego wypisywania wyników gry gamma
+ *
+ * Dane trafiają do bufora w pamięci, który jest wypisywany jednym
+ * wywołaniem write(2), gdy się zapełni, na końcu programu lub na żądanie.
+ * Dwa bufory piszące do tego samego pliku (np. stdout i stderr na jednym
+ * terminalu) mogą zostać powiązane, aby zachować kolejność komunikatów.
+ * Bufor rosnący (@ref output_init_growing) nigdy sam nie pisze, tylko się
+ * powiększa, a @ref output_drain wypisuje go bez czekania do deskryptora
+ * w trybie nieblokującym.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_OUTPUT_BUFFER_H
+#define GAMMA_OUTPUT_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Domyślny rozmiar bufora wyjścia.
+ */
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+
+/**
+ * Struktura buforująca dane wypisywane do deskryptora.
+ */
+typedef struct output {
+    char *buf; /**< bufor z danymi czekającymi na wypisanie */
+    size_t len; /**< liczba bajtów w buforze */
+    size_t cap; /**< rozmiar bufora */
+    int fd; /**< deskryptor, do którego trafiają dane */
+    struct output *twin; /**< bufor tego samego pliku lub NULL */
+    bool growing; /**< czy bufor rośnie zamiast być wypisywany */
+    bool failed; /**< czy bufor rosnący zgubił dane z braku pamięci */
+} output_t;
+
+
+/**
+ * Bufor standardowego wyjścia.
+ */
+extern output_t std_out;
+
+
+/**
+ * Bufor standardowego wyjścia błędów.
+ */
+extern output_t std_err;
+
+
+/** @brief Inicjalizuje bufor wyjścia.
+ * @param[out] o  – inicjalizowany bufor,
+ * @param[in] fd  – deskryptor, do którego będą wypisywane dane,
+ * @param[in] cap – rozmiar bufora, liczba nie mniejsza od 20.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+bool output_init(output_t *o, int fd, size_t cap);
+
+
+/** @brief Inicjalizuje bufor rosnący.
+ * Dane są wypisywane jedynie przez @ref output_drain.
+ * @param[out] o  – inicjalizowany bufor,
+ * @param[in] fd  – deskryptor w trybie nieblokującym,
+ * @param[in] cap – początkowy rozmiar bufora, liczba nie mniejsza od 20.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+bool output_init_growing(output_t *o, int fd, size_t cap);
+
+
+/** @brief Wypisuje tyle danych z bufora, ile się da bez czekania.
+ * Niewypisane dane pozostają w buforze.
+ * @param[in,out] o – wypisywany bufor.
+ * @return Wartość @p false jeżeli wystąpił błąd zapisu lub bufor rosnący
+ * zgubił dane, @p true w przeciwnym wypadku.
+ */
+bool output_drain(output_t *o);
+
+
+/** @brief Wypisuje zawartość bufora i zwalnia jego pamięć.
+ * @param[in,out] o – zwalniany bufor.
+ */
+void output_free(output_t *o);
+
+
+/** @brief Wiąże dwa bufory, jeżeli piszą do tego samego pliku.
+ * Przed dopisaniem danych do jednego z powiązanych buforów wypisywana
+ * jest zawartość drugiego, dzięki czemu zachowana zostaje kolejność.
+ * @param[in,out] a – pierwszy bufor,
+ * @param[in,out] b – drugi bufor.
+ */
+void output_link(output_t *a, output_t *b);
+
+
+/** @brief Przygotowuje bufory @ref std_out i @ref std_err.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+bool output_open_std(void);
+
+
+/** @brief Wypisuje i zwalnia bufory @ref std_out i @ref std_err.
+ */
+void output_close_std(void);
+
+
+/** @brief Wypisuje zawartość bufora.
+ * @param[in,out] o – wypisywany bufor.
+ * @return Wartość @p true jeżeli wszystkie dane zostały zapisane,
+ * @p false jeżeli wystąpił błąd zapisu.
+ */
+bool output_flush(output_t *o);
+
+
+/** @brief Dopisuje ciąg bajtów do bufora.
+ * Ciąg dłuższy od bufora jest wypisywany bezpośrednio.
+ * @param[in,out] o – bufor,
+ * @param[in] s     – dopisywane dane,
+ * @param[in] len   – liczba dopisywanych bajtów.
+ */
+void output_write(output_t *o, const char *s, size_t len);
+
+
+/** @brief Dopisuje napis do bufora.
+ * @param[in,out] o – bufor,
+ * @param[in] s     – dopisywany napis zakończony znakiem @p '\\0'.
+ */
+void output_str(output_t *o, const char *s);
+
+
+/** @brief Dopisuje znak do bufora.
+ * @param[in,out] o – bufor,
+ * @param[in] c     – dopisywany znak.
+ */
+void output_char(output_t *o, char c);
+
+
+/** @brief Dopisuje liczbę w zapisie dziesiętnym do bufora.
+ * @param[in,out] o – bufor,
+ * @param[in] n     – dopisywana liczba.
+ */
+void output_uint(output_t *o, uint64_t n);
+
+
+/** @brief Zapisuje liczbę w zapisie dziesiętnym.
+ * @param[out] s  – miejsce na co najmniej 20 znaków,
+ * @param[in] n   – zapisywana liczba.
+ * @return Liczba zapisanych znaków.
+ */
+size_t format_uint(char *s, uint64_t n);
+
+
+#endif /* GAMMA_OUTPUT_BUFFER_H */
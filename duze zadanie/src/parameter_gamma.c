@@ -5,7 +5,8 @@ bool correct_parameter(int c) {
     return (c == 'B' || c == 'I' ||
             c == 'm' || c == 'g' ||
             c == 'b' || c == 'f' ||
-            c == 'q' || c == 'p');
+            c == 'q' || c == 'p' ||
+            c == 'd');
 }
 
 parameter char_to_param(int c) {
@@ -24,9 +25,21 @@ parameter char_to_param(int c) {
             return f;
         else if (c == 'q')
             return q;
-        else
+        else if (c == 'p')
             return p;
+        else
+            return d;
     } else {
         return E;
     }
+}
+
+
+char param_to_char(parameter par) {
+    static const char chars[] = {
+        [B] = 'B', [I] = 'I', [E] = '\0', [m] = 'm', [g] = 'g',
+        [b] = 'b', [f] = 'f', [q] = 'q', [p] = 'p', [d] = 'd'
+    };
+
+    return chars[par];
 }
\ No newline at end of file
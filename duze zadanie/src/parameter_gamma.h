@@ -22,7 +22,8 @@ typedef enum parameter {
     b, /**< Wywołanie gamma_busy_fields     */
     f, /**< Wywołanie gamma_free_fields     */
     q, /**< Wywołanie gamma_golden_possible */
-    p  /**< Wywołanie gamma_board           */
+    p, /**< Wywołanie gamma_board           */
+    d  /**< Wywołanie gamma_diff            */
 } parameter;
 
 
@@ -43,4 +44,12 @@ bool correct_parameter(int c);
  */
 parameter char_to_param(int c);
 
+
+/** @brief Konwertuje parametr do znaku.
+ *
+ * @param[in] par – parametr do konwersji.
+ * @return Znak odpowiadający parametrowi @p par lub @p '\0' dla @p E.
+ */
+char param_to_char(parameter par);
+
 #endif /* GAMMA_PARAMETER_GAMMA_H */
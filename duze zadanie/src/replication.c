@@ -0,0 +1,695 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "replication.h"
+
+
+/* Początek strumienia replikacji */
+#define REPLICATION_MAGIC "GMRP"
+
+/* Długość nagłówka: znacznik, numer zmiany i długość stanu gry */
+#define REPLICATION_HEADER_SIZE 20
+
+/* Początkowa pojemność kolejki zmian lidera */
+#define LEADER_QUEUE_INITIAL 1024
+
+
+/* Jedna zmiana gry */
+typedef struct record {
+    uint64_t sequence; /* numer zmiany */
+    uint32_t player; /* gracz wykonujący ruch */
+    uint32_t x; /* odcięta pola */
+    uint32_t y; /* rzędna pola */
+    char kind; /* 'm' dla ruchu, 'g' dla złotego ruchu */
+} record_t;
+
+
+/* Stan lidera */
+struct leader {
+    gamma_t *game; /* replikowana gra */
+    char *path; /* ścieżka gniazda */
+    int listen_fd; /* gniazdo nasłuchujące */
+    int wake[2]; /* potok budzący bezczynny wątek */
+    pthread_t thread; /* wątek rozsyłający zmiany */
+
+    /* Pola zmieniane przez obserwatora gry, chronione przez lock */
+    pthread_mutex_t lock;
+    record_t *queue; /* zmiany czekające na rozesłanie */
+    size_t queued; /* liczba zmian w kolejce */
+    size_t capacity; /* pojemność kolejki */
+    uint64_t sequence; /* numer ostatniej zmiany gry */
+    bool golden; /* czy ostatnio zabrano pionek złotym ruchem */
+    uint32_t golden_x; /* odcięta pola zabranego pionka */
+    uint32_t golden_y; /* rzędna pola zabranego pionka */
+    bool idle; /* czy wątek czeka na potoku */
+    bool stopping; /* czy należy zakończyć pracę */
+    bool broken; /* czy zabrakło pamięci na kolejkę */
+
+    /* Pola używane jedynie przez wątek rozsyłający */
+    gamma_t *mirror; /* kopia gry po rozesłanych zmianach */
+    uint64_t sent; /* numer ostatniej rozesłanej zmiany */
+    int *followers; /* gniazda replik */
+    size_t followers_count; /* liczba replik */
+    size_t followers_capacity; /* pojemność tablicy replik */
+    unsigned char *encoded; /* rekordy rozsyłanych zmian */
+    size_t encoded_capacity; /* pojemność bufora rekordów */
+};
+
+
+/* Stan repliki */
+struct follower {
+    gamma_t *game; /* gra repliki */
+    int fd; /* gniazdo połączenia z liderem */
+    pthread_t thread; /* wątek wykonujący zmiany */
+    pthread_mutex_t lock; /* chroni grę i pola poniżej */
+    pthread_cond_t applied; /* sygnalizowany po wykonaniu zmian */
+    uint64_t sequence; /* numer ostatniej wykonanej zmiany */
+    bool closed; /* czy lider się rozłączył */
+};
+
+
+/* Wysyła cały bufor; zwraca false, gdy połączenie zostało zerwane */
+static bool send_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        p += n;
+        len -= (size_t) n;
+    }
+
+    return true;
+}
+
+
+/* Odbiera dokładnie len bajtów; zwraca false przy końcu danych lub błędzie */
+static bool recv_all(int fd, void *buf, size_t len) {
+    char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        p += n;
+        len -= (size_t) n;
+    }
+
+    return true;
+}
+
+
+/* Zapisuje rekord zmiany r pod adresem out */
+static void encode_record(const record_t *r, unsigned char *out) {
+    memcpy(out, &r->sequence, 8);
+    out[8] = (unsigned char) r->kind;
+    memcpy(out + 9, &r->player, 4);
+    memcpy(out + 13, &r->x, 4);
+    memcpy(out + 17, &r->y, 4);
+}
+
+
+/* Odczytuje rekord zmiany zapisany przez encode_record */
+static void decode_record(const unsigned char *in, record_t *r) {
+    memcpy(&r->sequence, in, 8);
+    r->kind = (char) in[8];
+    memcpy(&r->player, in + 9, 4);
+    memcpy(&r->x, in + 13, 4);
+    memcpy(&r->y, in + 17, 4);
+}
+
+
+/* Wykonuje zmianę na grze g; zwraca false, gdy jest niepoprawna */
+static bool apply_record(gamma_t *g, const record_t *r) {
+    if (r->kind == 'm')
+        return gamma_move(g, r->player, r->x, r->y);
+    else if (r->kind == 'g')
+        return gamma_golden_move(g, r->player, r->x, r->y);
+    else
+        return false;
+}
+
+
+/* Tworzy nasłuchujące gniazdo pod ścieżką path, -1 jeżeli się nie udało */
+static int open_socket(const char *path) {
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* Usuwamy jedynie gniazdo pozostałe po poprzednim uruchomieniu */
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0
+        || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/* Zapamiętuje pole, z którego złoty ruch zabrał pionek */
+static void on_removed(void *ctx, uint32_t player, uint32_t x, uint32_t y) {
+    leader_t *leader = ctx;
+    (void) player;
+
+    pthread_mutex_lock(&leader->lock);
+    leader->golden = true;
+    leader->golden_x = x;
+    leader->golden_y = y;
+    pthread_mutex_unlock(&leader->lock);
+}
+
+
+/* Dopisuje ruch do kolejki i budzi bezczynny wątek rozsyłający */
+static void on_placed(void *ctx, uint32_t player, uint32_t x, uint32_t y) {
+    leader_t *leader = ctx;
+    record_t r = {0, player, x, y, 'm'};
+
+    pthread_mutex_lock(&leader->lock);
+
+    /* Złoty ruch stawia pionek na polu, z którego właśnie go zabrał */
+    if (leader->golden && leader->golden_x == x && leader->golden_y == y)
+        r.kind = 'g';
+    leader->golden = false;
+    r.sequence = ++leader->sequence;
+
+    if (leader->queued == leader->capacity && !leader->broken) {
+        size_t capacity = leader->capacity == 0 ? LEADER_QUEUE_INITIAL
+                                                : 2 * leader->capacity;
+        record_t *bigger = realloc(leader->queue,
+                                   capacity * sizeof(record_t));
+
+        if (bigger == NULL) {
+            leader->broken = true;
+        } else {
+            leader->queue = bigger;
+            leader->capacity = capacity;
+        }
+    }
+
+    if (!leader->broken)
+        leader->queue[leader->queued++] = r;
+
+    if (leader->idle) {
+        leader->idle = false;
+        if (write(leader->wake[1], "", 1) < 0)
+            leader->broken = true;
+    }
+
+    pthread_mutex_unlock(&leader->lock);
+}
+
+
+/* Wysyła nowej replice stan kopii gry; zwraca false przy błędzie */
+static bool send_snapshot(leader_t *leader, int fd) {
+    unsigned char header[REPLICATION_HEADER_SIZE];
+    char *snapshot = NULL;
+    size_t size = 0;
+    uint64_t size64;
+    FILE *f = open_memstream(&snapshot, &size);
+    bool correct;
+
+    if (f == NULL)
+        return false;
+
+    correct = gamma_save(leader->mirror, f);
+    if (fclose(f) != 0)
+        correct = false;
+
+    size64 = size;
+    memcpy(header, REPLICATION_MAGIC, 4);
+    memcpy(header + 4, &leader->sent, 8);
+    memcpy(header + 12, &size64, 8);
+
+    correct = correct && send_all(fd, header, sizeof(header))
+              && send_all(fd, snapshot, size);
+    free(snapshot);
+
+    return correct;
+}
+
+
+/* Przyjmuje oczekujące repliki i wysyła im stan gry */
+static void accept_followers(leader_t *leader) {
+    struct timeval timeout = {
+        REPLICATION_SEND_TIMEOUT_MS / 1000,
+        REPLICATION_SEND_TIMEOUT_MS % 1000 * 1000
+    };
+
+    for (;;) {
+        int fd = accept4(leader->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;
+        }
+
+        if (leader->followers_count == leader->followers_capacity) {
+            size_t capacity = 2 * leader->followers_capacity + 1;
+            int *bigger = realloc(leader->followers, capacity * sizeof(int));
+
+            if (bigger == NULL) {
+                close(fd);
+                continue;
+            }
+            leader->followers = bigger;
+            leader->followers_capacity = capacity;
+        }
+
+        /* Zbyt wolna replika nie może wstrzymać pozostałych */
+        if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                       sizeof(timeout)) != 0
+            || !send_snapshot(leader, fd))
+            close(fd);
+        else
+            leader->followers[leader->followers_count++] = fd;
+    }
+}
+
+
+/* Wykonuje zmiany na kopii gry i rozsyła je replikom; zwraca false, gdy
+ * kopia rozeszła się z grą */
+static bool send_records(leader_t *leader, const record_t *batch,
+                         size_t count) {
+    size_t len = count * REPLICATION_RECORD_SIZE;
+
+    if (len > leader->encoded_capacity) {
+        unsigned char *bigger = realloc(leader->encoded, len);
+
+        if (bigger == NULL)
+            return false;
+        leader->encoded = bigger;
+        leader->encoded_capacity = len;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!apply_record(leader->mirror, &batch[i]))
+            return false;
+        encode_record(&batch[i], leader->encoded
+                                 + i * REPLICATION_RECORD_SIZE);
+    }
+    leader->sent = batch[count - 1].sequence;
+
+    for (size_t i = 0; i < leader->followers_count; i++) {
+        if (!send_all(leader->followers[i], leader->encoded, len)) {
+            close(leader->followers[i]);
+            leader->followers[i--] =
+                leader->followers[--leader->followers_count];
+        }
+    }
+
+    return true;
+}
+
+
+/* Czeka na nową replikę lub zmianę gry */
+static void wait_for_work(leader_t *leader) {
+    struct pollfd fds[2] = {
+        {leader->listen_fd, POLLIN, 0},
+        {leader->wake[0], POLLIN, 0}
+    };
+    char buf[64];
+
+    if (poll(fds, 2, -1) > 0 && (fds[1].revents & POLLIN)) {
+        while (read(leader->wake[0], buf, sizeof(buf)) > 0)
+            continue;
+    }
+}
+
+
+/* Wątek rozsyłający zmiany */
+static void *leader_thread(void *arg) {
+    leader_t *leader = arg;
+    record_t *batch = NULL;
+    size_t batch_capacity = 0;
+
+    for (;;) {
+        record_t *taken;
+        size_t count, capacity;
+        bool stopping, broken;
+
+        /* Zabieramy całą kolejkę, aby obserwator nie czekał na wysyłanie */
+        pthread_mutex_lock(&leader->lock);
+        taken = leader->queue;
+        capacity = leader->capacity;
+        count = leader->queued;
+        leader->queue = batch;
+        leader->capacity = batch_capacity;
+        leader->queued = 0;
+        batch = taken;
+        batch_capacity = capacity;
+        stopping = leader->stopping;
+        broken = leader->broken;
+        leader->idle = count == 0 && !stopping && !broken;
+        pthread_mutex_unlock(&leader->lock);
+
+        if (broken)
+            break;
+
+        accept_followers(leader);
+
+        if (count > 0) {
+            if (!send_records(leader, batch, count))
+                break;
+        } else if (stopping) {
+            break;
+        } else {
+            wait_for_work(leader);
+        }
+    }
+
+    /* Repliki zobaczą koniec strumienia, a nowe nie zostaną przyjęte */
+    shutdown(leader->listen_fd, SHUT_RDWR);
+    for (size_t i = 0; i < leader->followers_count; i++)
+        close(leader->followers[i]);
+    leader->followers_count = 0;
+    free(batch);
+
+    return NULL;
+}
+
+
+/* Zwalnia zasoby lidera, które udało się utworzyć */
+static void free_leader(leader_t *leader) {
+    if (leader->listen_fd >= 0) {
+        close(leader->listen_fd);
+        unlink(leader->path);
+    }
+    if (leader->wake[0] >= 0) {
+        close(leader->wake[0]);
+        close(leader->wake[1]);
+    }
+
+    pthread_mutex_destroy(&leader->lock);
+    gamma_delete(leader->mirror);
+    free(leader->path);
+    free(leader->queue);
+    free(leader->followers);
+    free(leader->encoded);
+    free(leader);
+}
+
+
+leader_t *leader_start(gamma_t *g, const char *path) {
+    static const gamma_observer_t observer = {
+        on_placed, on_removed, NULL, NULL
+    };
+    leader_t *leader;
+
+    if (g == NULL || path == NULL)
+        return NULL;
+
+    leader = calloc(1, sizeof(leader_t));
+    if (leader == NULL)
+        return NULL;
+
+    if (pthread_mutex_init(&leader->lock, NULL) != 0) {
+        free(leader);
+        return NULL;
+    }
+
+    leader->game = g;
+    leader->listen_fd = -1;
+    leader->wake[0] = leader->wake[1] = -1;
+    leader->mirror = gamma_copy(g);
+    leader->path = strdup(path);
+
+    if (leader->mirror == NULL || leader->path == NULL
+        || (leader->listen_fd = open_socket(path)) < 0
+        || pipe2(leader->wake, O_CLOEXEC | O_NONBLOCK) != 0
+        || pthread_create(&leader->thread, NULL, leader_thread, leader) != 0) {
+        free_leader(leader);
+        return NULL;
+    }
+
+    gamma_set_observer(g, &observer, leader);
+
+    return leader;
+}
+
+
+uint64_t leader_sequence(leader_t *leader) {
+    uint64_t sequence;
+
+    pthread_mutex_lock(&leader->lock);
+    sequence = leader->sequence;
+    pthread_mutex_unlock(&leader->lock);
+
+    return sequence;
+}
+
+
+void leader_stop(leader_t *leader) {
+    if (leader == NULL)
+        return;
+
+    pthread_mutex_lock(&leader->lock);
+    leader->stopping = true;
+    if (leader->idle && write(leader->wake[1], "", 1) < 0)
+        leader->broken = true;
+    pthread_mutex_unlock(&leader->lock);
+
+    pthread_join(leader->thread, NULL);
+    gamma_set_observer(leader->game, NULL, NULL);
+    free_leader(leader);
+}
+
+
+/* Wykonuje pełne rekordy z bufora; zwraca liczbę zużytych bajtów,
+ * a przy niepoprawnej zmianie ustawia *correct na false */
+static size_t apply_records(follower_t *follower, const unsigned char *buf,
+                            size_t len, bool *correct) {
+    size_t used = 0;
+    record_t r;
+
+    pthread_mutex_lock(&follower->lock);
+
+    while (len - used >= REPLICATION_RECORD_SIZE) {
+        decode_record(buf + used, &r);
+        if (r.sequence != follower->sequence + 1
+            || !apply_record(follower->game, &r)) {
+            *correct = false;
+            break;
+        }
+
+        follower->sequence = r.sequence;
+        used += REPLICATION_RECORD_SIZE;
+    }
+
+    pthread_cond_broadcast(&follower->applied);
+    pthread_mutex_unlock(&follower->lock);
+
+    return used;
+}
+
+
+/* Wątek wykonujący zmiany otrzymane od lidera */
+static void *follower_thread(void *arg) {
+    follower_t *follower = arg;
+    unsigned char *buf = malloc(REPLICATION_READ_SIZE);
+    size_t have = 0;
+    bool correct = buf != NULL;
+
+    while (correct) {
+        ssize_t n = recv(follower->fd, buf + have,
+                         REPLICATION_READ_SIZE - have, 0);
+        size_t used;
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+
+        have += (size_t) n;
+        used = apply_records(follower, buf, have, &correct);
+        memmove(buf, buf + used, have - used);
+        have -= used;
+    }
+
+    pthread_mutex_lock(&follower->lock);
+    follower->closed = true;
+    pthread_cond_broadcast(&follower->applied);
+    pthread_mutex_unlock(&follower->lock);
+
+    free(buf);
+
+    return NULL;
+}
+
+
+/* Wczytuje nagłówek i stan gry lidera; NULL jeżeli się nie udało */
+static gamma_t *receive_snapshot(int fd, uint64_t *sequence) {
+    unsigned char header[REPLICATION_HEADER_SIZE];
+    uint64_t size;
+    char *snapshot;
+    gamma_t *game = NULL;
+    FILE *f;
+
+    if (!recv_all(fd, header, sizeof(header))
+        || memcmp(header, REPLICATION_MAGIC, 4) != 0)
+        return NULL;
+
+    memcpy(sequence, header + 4, 8);
+    memcpy(&size, header + 12, 8);
+
+    snapshot = size > 0 && size <= SIZE_MAX ? malloc(size) : NULL;
+    if (snapshot == NULL)
+        return NULL;
+
+    if (recv_all(fd, snapshot, size)) {
+        f = fmemopen(snapshot, size, "rb");
+        if (f != NULL) {
+            game = gamma_load(f);
+            fclose(f);
+        }
+    }
+
+    free(snapshot);
+
+    return game;
+}
+
+
+follower_t *follower_start(const char *path) {
+    struct sockaddr_un addr;
+    follower_t *follower;
+
+    if (path == NULL || strlen(path) >= sizeof(addr.sun_path))
+        return NULL;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    follower = calloc(1, sizeof(follower_t));
+    if (follower == NULL)
+        return NULL;
+
+    follower->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (follower->fd < 0) {
+        free(follower);
+        return NULL;
+    }
+
+    if (connect(follower->fd, (struct sockaddr *) &addr, sizeof(addr)) != 0
+        || (follower->game = receive_snapshot(follower->fd,
+                                              &follower->sequence)) == NULL) {
+        close(follower->fd);
+        free(follower);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&follower->lock, NULL) != 0) {
+        gamma_delete(follower->game);
+        close(follower->fd);
+        free(follower);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&follower->applied, NULL) != 0) {
+        pthread_mutex_destroy(&follower->lock);
+        gamma_delete(follower->game);
+        close(follower->fd);
+        free(follower);
+        return NULL;
+    }
+
+    if (pthread_create(&follower->thread, NULL, follower_thread,
+                       follower) != 0) {
+        pthread_cond_destroy(&follower->applied);
+        pthread_mutex_destroy(&follower->lock);
+        gamma_delete(follower->game);
+        close(follower->fd);
+        free(follower);
+        return NULL;
+    }
+
+    return follower;
+}
+
+
+gamma_t *follower_game(follower_t *follower) {
+    pthread_mutex_lock(&follower->lock);
+
+    return follower->game;
+}
+
+
+void follower_release(follower_t *follower) {
+    pthread_mutex_unlock(&follower->lock);
+}
+
+
+uint64_t follower_sequence(follower_t *follower) {
+    uint64_t sequence;
+
+    pthread_mutex_lock(&follower->lock);
+    sequence = follower->sequence;
+    pthread_mutex_unlock(&follower->lock);
+
+    return sequence;
+}
+
+
+bool follower_wait(follower_t *follower, uint64_t sequence) {
+    bool applied;
+
+    pthread_mutex_lock(&follower->lock);
+    while (follower->sequence < sequence && !follower->closed)
+        pthread_cond_wait(&follower->applied, &follower->lock);
+    applied = follower->sequence >= sequence;
+    pthread_mutex_unlock(&follower->lock);
+
+    return applied;
+}
+
+
+void follower_stop(follower_t *follower) {
+    if (follower == NULL)
+        return;
+
+    /* Budzi wątek czekający na dane od lidera */
+    shutdown(follower->fd, SHUT_RDWR);
+    pthread_join(follower->thread, NULL);
+
+    close(follower->fd);
+    pthread_cond_destroy(&follower->applied);
+    pthread_mutex_destroy(&follower->lock);
+    gamma_delete(follower->game);
+    free(follower);
+}
@@ -0,0 +1,139 @@
+/** @file
+ * Interfejs replikacji gry gamma do procesów zapasowych
+ *
+ * Lider przesyła każdy wykonany ruch i złoty ruch przez gniazdo uniksowe
+ * do dowolnej liczby replik. Nowa replika dostaje najpierw stan gry
+ * (@ref gamma_save) z numerem ostatniej zawartej w nim zmiany, a potem
+ * kolejne zmiany w postaci rekordów stałej długości:
+ *
+ *     numer (8 bajtów) rodzaj (1 bajt: 'm' lub 'g') gracz x y (po 4 bajty)
+ *
+ * Numery zmian zaczynają się od 1 i rosną o 1. Liczby są zapisane
+ * w kolejności bajtów bieżącej maszyny, tak jak w @ref gamma_save.
+ *
+ * Lider wykrywa ruchy przez obserwatora gry (@ref gamma_set_observer)
+ * i jedynie dopisuje je do kolejki. Osobny wątek wykonuje je na własnej
+ * kopii gry, z której bierze stan dla nowych replik, i rozsyła rekordy.
+ * Replika, która nie odbiera danych przez @ref REPLICATION_SEND_TIMEOUT_MS
+ * milisekund, jest rozłączana.
+ *
+ * Replika wykonuje otrzymane zmiany na własnej grze w osobnym wątku.
+ * Po rozłączeniu lidera zachowuje ostatni otrzymany stan.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_REPLICATION_H
+#define GAMMA_REPLICATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamma.h"
+
+
+/**
+ * Długość rekordu jednej zmiany w bajtach.
+ */
+#define REPLICATION_RECORD_SIZE 21
+
+
+/**
+ * Rozmiar bufora, do którego replika czyta rekordy.
+ */
+#define REPLICATION_READ_SIZE (1 << 16)
+
+
+/**
+ * Czas, po którym lider rozłącza replikę nieodbierającą danych.
+ */
+#define REPLICATION_SEND_TIMEOUT_MS 1000
+
+
+/**
+ * Lider replikacji.
+ */
+typedef struct leader leader_t;
+
+
+/**
+ * Replika gry.
+ */
+typedef struct follower follower_t;
+
+
+/** @brief Zaczyna replikację gry.
+ * Tworzy gniazdo uniksowe @p path, ustawia obserwatora gry @p g i uruchamia
+ * wątek rozsyłający zmiany. Do czasu @ref leader_stop gra nie może mieć
+ * innego obserwatora.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] path    – ścieżka gniazda uniksowego.
+ * @return Wskaźnik na lidera lub NULL, jeżeli nie udało się utworzyć
+ * gniazda, wątku lub zaalokować pamięci.
+ */
+leader_t *leader_start(gamma_t *g, const char *path);
+
+
+/** @brief Podaje numer ostatniej zmiany gry lidera.
+ * @param[in] leader  – wskaźnik na lidera.
+ * @return Liczba zmian wykonanych od @ref leader_start.
+ */
+uint64_t leader_sequence(leader_t *leader);
+
+
+/** @brief Kończy replikację.
+ * Rozsyła zmiany oczekujące w kolejce, rozłącza repliki, usuwa obserwatora
+ * gry i plik gniazda oraz zwalnia pamięć lidera.
+ * @param[in] leader  – wskaźnik na lidera lub NULL.
+ */
+void leader_stop(leader_t *leader);
+
+
+/** @brief Łączy się z liderem.
+ * Wczytuje stan gry lidera i uruchamia wątek wykonujący kolejne zmiany.
+ * @param[in] path    – ścieżka gniazda uniksowego lidera.
+ * @return Wskaźnik na replikę lub NULL, jeżeli nie udało się połączyć,
+ * stan gry był niepoprawny lub zabrakło pamięci.
+ */
+follower_t *follower_start(const char *path);
+
+
+/** @brief Daje dostęp do gry repliki.
+ * Wstrzymuje wykonywanie zmian do wywołania @ref follower_release.
+ * Gry nie wolno zmieniać.
+ * @param[in] follower – wskaźnik na replikę.
+ * @return Wskaźnik na grę repliki.
+ */
+gamma_t *follower_game(follower_t *follower);
+
+
+/** @brief Kończy dostęp do gry repliki z @ref follower_game.
+ * @param[in] follower – wskaźnik na replikę.
+ */
+void follower_release(follower_t *follower);
+
+
+/** @brief Podaje numer ostatniej zmiany wykonanej przez replikę.
+ * @param[in] follower – wskaźnik na replikę.
+ * @return Numer ostatniej wykonanej zmiany.
+ */
+uint64_t follower_sequence(follower_t *follower);
+
+
+/** @brief Czeka, aż replika wykona zmianę o danym numerze.
+ * @param[in] follower – wskaźnik na replikę,
+ * @param[in] sequence – numer zmiany.
+ * @return Wartość @p true, jeżeli zmiana została wykonana, @p false, jeżeli
+ * lider się rozłączył lub przysłał niepoprawną zmianę wcześniej.
+ */
+bool follower_wait(follower_t *follower, uint64_t sequence);
+
+
+/** @brief Rozłącza replikę i zwalnia jej pamięć razem z grą.
+ * @param[in] follower – wskaźnik na replikę lub NULL.
+ */
+void follower_stop(follower_t *follower);
+
+
+#endif /* GAMMA_REPLICATION_H */
@@ -0,0 +1,173 @@
+/** @file
+ * Test replikacji gry między liderem a replikami
+ *
+ * Lider rozgrywa losową grę z ruchami i złotymi ruchami. Jedna replika
+ * jest połączona od początku, druga dołącza w trakcie gry. Po każdej serii
+ * ruchów stan obu replik musi być równy stanowi gry lidera.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+// CMake w wersji release wyłącza asercje.
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "gamma.h"
+#include "replication.h"
+
+
+/**
+ * Szerokość planszy testowej.
+ */
+#define WIDTH 40
+
+
+/**
+ * Wysokość planszy testowej.
+ */
+#define HEIGHT 30
+
+
+/**
+ * Liczba graczy w grze testowej.
+ */
+#define PLAYERS 5
+
+
+/**
+ * Maksymalna liczba obszarów gracza w grze testowej.
+ */
+#define AREAS 60
+
+
+/**
+ * Liczba prób ruchu w jednej serii.
+ */
+#define BATCH 200
+
+
+/** @brief Losuje kolejną liczbę generatorem xorshift.
+ * @param[in, out] state – stan generatora, liczba niezerowa.
+ * @return Wylosowana liczba.
+ */
+static inline uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+
+/** @brief Porównuje grę repliki z grą lidera.
+ * @param[in] g        – wskaźnik na grę lidera,
+ * @param[in] follower – wskaźnik na replikę.
+ */
+static void check_follower(gamma_t *g, follower_t *follower) {
+    static uint32_t expected[WIDTH * HEIGHT], actual[WIDTH * HEIGHT];
+    gamma_t *copy = follower_game(follower);
+
+    assert(gamma_hash(copy) == gamma_hash(g));
+    assert(gamma_export_owners(g, expected, WIDTH));
+    assert(gamma_export_owners(copy, actual, WIDTH));
+    assert(memcmp(expected, actual, sizeof(expected)) == 0);
+
+    for (uint32_t player = 1; player <= PLAYERS; player++) {
+        assert(gamma_busy_fields(copy, player) == gamma_busy_fields(g, player));
+        assert(gamma_free_fields(copy, player) == gamma_free_fields(g, player));
+        assert(gamma_golden_used(copy, player) == gamma_golden_used(g, player));
+    }
+
+    follower_release(follower);
+}
+
+
+/** @brief Wykonuje serię losowych ruchów.
+ * Co dziesiąta próba jest złotym ruchem.
+ * @param[in,out] g      – wskaźnik na grę lidera,
+ * @param[in,out] random – stan generatora liczb losowych.
+ * @return Liczba wykonanych ruchów.
+ */
+static uint64_t play(gamma_t *g, uint64_t *random) {
+    uint64_t moves = 0;
+
+    for (int i = 0; i < BATCH; i++) {
+        uint32_t player = (uint32_t) (next_random(random) % PLAYERS) + 1;
+        uint32_t x = (uint32_t) (next_random(random) % WIDTH);
+        uint32_t y = (uint32_t) (next_random(random) % HEIGHT);
+
+        if (next_random(random) % 10 == 0 ? gamma_golden_move(g, player, x, y)
+                                          : gamma_move(g, player, x, y))
+            moves++;
+    }
+
+    return moves;
+}
+
+
+/** @brief Sprawdza replikację gry.
+ * @return Zero, gdy wszystkie testy przebiegły poprawnie,
+ * a w przeciwnym przypadku kod zakończenia programu jest kodem błędu.
+ */
+int main() {
+    char path[64];
+    uint64_t random = 0x9e3779b97f4a7c15ULL, moves = 0;
+    gamma_t *g = gamma_new(WIDTH, HEIGHT, PLAYERS, AREAS);
+    leader_t *leader;
+    follower_t *first, *second = NULL;
+
+    snprintf(path, sizeof(path), "/tmp/gamma_replication_%ld.sock",
+             (long) getpid());
+
+    assert(g != NULL);
+    leader = leader_start(g, path);
+    assert(leader != NULL);
+
+    first = follower_start(path);
+    assert(first != NULL);
+    check_follower(g, first);
+
+    for (int round = 0; round < 40; round++) {
+        moves += play(g, &random);
+        assert(leader_sequence(leader) == moves);
+
+        /* Druga replika dostaje stan gry w trakcie rozgrywki */
+        if (round == 13) {
+            second = follower_start(path);
+            assert(second != NULL);
+        }
+
+        assert(follower_wait(first, moves));
+        assert(follower_sequence(first) == moves);
+        check_follower(g, first);
+        if (second != NULL) {
+            assert(follower_wait(second, moves));
+            check_follower(g, second);
+        }
+    }
+
+    leader_stop(leader);
+    assert(access(path, F_OK) != 0);
+
+    /* Repliki zachowują ostatni stan po rozłączeniu lidera */
+    assert(!follower_wait(first, moves + 1));
+    assert(!follower_wait(second, moves + 1));
+    check_follower(g, first);
+    check_follower(g, second);
+
+    follower_stop(first);
+    follower_stop(second);
+    gamma_delete(g);
+
+    printf("%llu moves replicated\n", (unsigned long long) moves);
+
+    return 0;
+}
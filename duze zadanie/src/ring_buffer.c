@@ -0,0 +1,146 @@
+#define _GNU_SOURCE
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "ring_buffer.h"
+
+
+/**
+ * Liczba prób przed oddaniem procesora przez czekający wątek.
+ */
+#define SPIN_LIMIT 64
+
+
+/**
+ * Liczba oddań procesora, po której czekający wątek zasypia.
+ */
+#define YIELD_LIMIT 64
+
+
+bool ring_init(ring_t *r, size_t capacity, size_t elem_size) {
+    r->slots = malloc(capacity * elem_size);
+    if (r->slots == NULL)
+        return false;
+
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->pushed, 0);
+    atomic_init(&r->popped, 0);
+    atomic_init(&r->producer_sleeps, 0);
+    atomic_init(&r->consumer_sleeps, 0);
+    r->cached_head = 0;
+    r->cached_tail = 0;
+    r->mask = capacity - 1;
+    r->elem_size = elem_size;
+
+    return true;
+}
+
+
+void ring_free(ring_t *r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+
+/* Czeka chwilę, po kilku próbach oddaje procesor; zwraca true, gdy wątek
+ * czeka już na tyle długo, że powinien zasnąć */
+static inline bool backoff(unsigned *spins) {
+    if (++(*spins) % SPIN_LIMIT == 0)
+        sched_yield();
+
+    return *spins >= SPIN_LIMIT * YIELD_LIMIT;
+}
+
+
+/* Usypia wątek, dopóki licznik budzeń ma wartość seen */
+static inline void futex_wait(atomic_uint *word, unsigned seen) {
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+}
+
+
+/* Budzi wątek śpiący na liczniku budzeń, jeżeli śpi; wywoływana po
+ * przesunięciu indeksu, na który czeka druga strona */
+static inline void wake(atomic_uint *sleeps, atomic_uint *word) {
+    /* Bariera porządkuje przesunięcie indeksu przed odczytem sleeps,
+     * tak jak w sleep_on */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(sleeps, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(word, 1, memory_order_relaxed);
+        syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+
+/* Zapowiada sen na liczniku budzeń word; zwraca jego wartość, którą należy
+ * przekazać do futex_wait, jeżeli po zapowiedzi warunek wciąż nie zachodzi */
+static inline unsigned sleep_on(atomic_uint *sleeps, atomic_uint *word) {
+    unsigned seen = atomic_load_explicit(word, memory_order_acquire);
+
+    atomic_store_explicit(sleeps, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    return seen;
+}
+
+
+void ring_push(ring_t *r, const void *elem) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned spins = 0;
+
+    while (head - r->cached_tail > r->mask) {
+        r->cached_tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head - r->cached_tail > r->mask && backoff(&spins)) {
+            unsigned seen = sleep_on(&r->producer_sleeps, &r->popped);
+
+            r->cached_tail = atomic_load_explicit(&r->tail,
+                                                  memory_order_acquire);
+            if (head - r->cached_tail > r->mask)
+                futex_wait(&r->popped, seen);
+            atomic_store_explicit(&r->producer_sleeps, 0,
+                                  memory_order_relaxed);
+        }
+    }
+
+    memcpy(r->slots + (head & r->mask) * r->elem_size, elem, r->elem_size);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    wake(&r->consumer_sleeps, &r->pushed);
+}
+
+
+bool ring_try_pop(ring_t *r, void *elem) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    if (tail == r->cached_head) {
+        r->cached_head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tail == r->cached_head)
+            return false;
+    }
+
+    memcpy(elem, r->slots + (tail & r->mask) * r->elem_size, r->elem_size);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    wake(&r->producer_sleeps, &r->popped);
+
+    return true;
+}
+
+
+void ring_pop(ring_t *r, void *elem) {
+    unsigned spins = 0;
+
+    while (!ring_try_pop(r, elem)) {
+        if (backoff(&spins)) {
+            unsigned seen = sleep_on(&r->consumer_sleeps, &r->pushed);
+
+            if (atomic_load_explicit(&r->head, memory_order_acquire)
+                == atomic_load_explicit(&r->tail, memory_order_relaxed))
+                futex_wait(&r->pushed, seen);
+            atomic_store_explicit(&r->consumer_sleeps, 0,
+                                  memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/** @file
+ * Interfejs kolejki cyklicznej dla jednego producenta i jednego konsumenta
+ *
+ * Kolejka nie używa blokad: producent przesuwa jedynie indeks zapisu,
+ * a konsument indeks odczytu. Operacje blokujące najpierw czekają aktywnie,
+ * oddając procesor po kilku nieudanych próbach, a po dłuższym czekaniu
+ * usypiają na futeksie, który budzi druga strona kolejki.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_RING_BUFFER_H
+#define GAMMA_RING_BUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * Rozmiar linii pamięci podręcznej, oddziela indeksy obu wątków.
+ */
+#define CACHE_LINE 64
+
+
+/**
+ * Struktura kolejki cyklicznej elementów stałego rozmiaru.
+ */
+typedef struct ring {
+    _Alignas(CACHE_LINE) atomic_size_t head; /**< indeks zapisu producenta */
+    size_t cached_tail; /**< ostatni odczytany przez producenta @p tail */
+    atomic_uint pushed; /**< licznik budzeń śpiącego konsumenta */
+    atomic_uint producer_sleeps; /**< czy producent śpi na @p popped */
+    _Alignas(CACHE_LINE) atomic_size_t tail; /**< indeks odczytu konsumenta */
+    size_t cached_head; /**< ostatni odczytany przez konsumenta @p head */
+    atomic_uint popped; /**< licznik budzeń śpiącego producenta */
+    atomic_uint consumer_sleeps; /**< czy konsument śpi na @p pushed */
+    _Alignas(CACHE_LINE) char *slots; /**< tablica elementów */
+    size_t mask; /**< liczba elementów pomniejszona o 1 */
+    size_t elem_size; /**< rozmiar pojedynczego elementu */
+} ring_t;
+
+
+/** @brief Inicjalizuje kolejkę.
+ * @param[out] r        – inicjalizowana kolejka,
+ * @param[in] capacity  – liczba elementów, potęga dwójki,
+ * @param[in] elem_size – rozmiar elementu w bajtach.
+ * @return Wartość @p true jeżeli się udało, @p false jeżeli zabrakło pamięci.
+ */
+bool ring_init(ring_t *r, size_t capacity, size_t elem_size);
+
+
+/** @brief Zwalnia pamięć kolejki.
+ * @param[in,out] r – zwalniana kolejka.
+ */
+void ring_free(ring_t *r);
+
+
+/** @brief Wstawia element, czekając na wolne miejsce.
+ * Może być wywoływana tylko przez producenta.
+ * @param[in,out] r – kolejka,
+ * @param[in] elem  – wstawiany element.
+ */
+void ring_push(ring_t *r, const void *elem);
+
+
+/** @brief Próbuje wyjąć element.
+ * Może być wywoływana tylko przez konsumenta.
+ * @param[in,out] r – kolejka,
+ * @param[out] elem – miejsce na wyjęty element.
+ * @return Wartość @p true jeżeli element został wyjęty,
+ * @p false jeżeli kolejka była pusta.
+ */
+bool ring_try_pop(ring_t *r, void *elem);
+
+
+/** @brief Wyjmuje element, czekając na jego pojawienie się.
+ * Może być wywoływana tylko przez konsumenta.
+ * @param[in,out] r – kolejka,
+ * @param[out] elem – miejsce na wyjęty element.
+ */
+void ring_pop(ring_t *r, void *elem);
+
+
+#endif /* GAMMA_RING_BUFFER_H */
@@ -0,0 +1,424 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+#include "batch_mode.h"
+#include "batch_aux.h"
+#include "output_buffer.h"
+
+
+/* Stan jednego połączenia */
+typedef struct session {
+    int fd; /* gniazdo połączenia */
+    line_parser_t lp; /* stan analizy bieżącej linii */
+    uint32_t line; /* licznik linii połączenia */
+    gamma_t *game; /* rozgrywka, NULL przed poprawnym poleceniem B */
+    output_t out; /* wyniki i komunikaty o błędach czekające na wysłanie */
+    char *in; /* dane od klienta */
+    size_t in_start; /* początek nieprzeanalizowanych danych w in */
+    size_t in_len; /* koniec danych w in */
+    bool eof; /* czy klient zamknął stronę zapisu */
+    struct session *next_ready; /* następne połączenie w kolejce */
+    struct session *prev; /* poprzednie połączenie na liście otwartych */
+    struct session *next; /* następne połączenie na liście otwartych */
+} session_t;
+
+
+/* Stan serwera */
+
+static int epoll_fd = -1; /* deskryptor epoll */
+static volatile sig_atomic_t stopping = 0; /* czy otrzymano sygnał końca */
+
+/* Kolejka połączeń z danymi do obsłużenia przez wątki robocze */
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static session_t *queue_head = NULL;
+static session_t *queue_tail = NULL;
+static bool queue_closed = false;
+
+/* Lista otwartych połączeń */
+static pthread_mutex_t sessions_lock = PTHREAD_MUTEX_INITIALIZER;
+static session_t *sessions = NULL;
+
+
+/* Zapamiętuje otrzymanie sygnału kończącego pracę serwera */
+static void handle_signal(int sig) {
+    (void) sig;
+    stopping = 1;
+}
+
+
+/* Dodaje połączenie na koniec kolejki */
+static void queue_push(session_t *s) {
+    pthread_mutex_lock(&queue_lock);
+    s->next_ready = NULL;
+    if (queue_tail == NULL)
+        queue_head = s;
+    else
+        queue_tail->next_ready = s;
+    queue_tail = s;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+
+/* Zdejmuje połączenie z kolejki, NULL po zamknięciu kolejki */
+static session_t *queue_pop(void) {
+    session_t *s;
+
+    pthread_mutex_lock(&queue_lock);
+    while (queue_head == NULL && !queue_closed)
+        pthread_cond_wait(&queue_cond, &queue_lock);
+
+    s = queue_head;
+    if (s != NULL) {
+        queue_head = s->next_ready;
+        if (queue_head == NULL)
+            queue_tail = NULL;
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    return s;
+}
+
+
+/* Budzi wszystkie wątki robocze, aby zakończyły pracę */
+static void queue_close(void) {
+    pthread_mutex_lock(&queue_lock);
+    queue_closed = true;
+    pthread_cond_broadcast(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+
+/* Tworzy połączenie dla gniazda fd, NULL jeżeli zabrakło pamięci */
+static session_t *session_new(int fd) {
+    session_t *s = malloc(sizeof(session_t));
+
+    if (s == NULL)
+        return NULL;
+
+    s->in = malloc(SERVER_READ_SIZE);
+    if (s->in == NULL || !output_init_growing(&s->out, fd, OUTPUT_BUFFER_SIZE)) {
+        free(s->in);
+        free(s);
+        return NULL;
+    }
+
+    s->fd = fd;
+    s->in_start = 0;
+    s->in_len = 0;
+    s->eof = false;
+    s->line = 1;
+    s->game = NULL;
+    parser_init(&s->lp);
+
+    pthread_mutex_lock(&sessions_lock);
+    s->prev = NULL;
+    s->next = sessions;
+    if (sessions != NULL)
+        sessions->prev = s;
+    sessions = s;
+    pthread_mutex_unlock(&sessions_lock);
+
+    return s;
+}
+
+
+/* Wypisuje pozostałe wyniki, zamyka połączenie i zwalnia jego pamięć */
+static void session_close(session_t *s) {
+    pthread_mutex_lock(&sessions_lock);
+    if (s->prev != NULL)
+        s->prev->next = s->next;
+    else
+        sessions = s->next;
+    if (s->next != NULL)
+        s->next->prev = s->prev;
+    pthread_mutex_unlock(&sessions_lock);
+
+    output_free(&s->out);
+    free(s->in);
+    close(s->fd);
+    gamma_delete(s->game);
+    free(s);
+}
+
+
+/* Kończy linię połączenia; eol jest false na końcu danych od klienta */
+static void end_line(session_t *s, bool eol) {
+    parameter p;
+    batch_op_t op;
+    batch_result_t r;
+
+    if (s->game != NULL) {
+        end_op(&s->lp, eol, &s->line, &op);
+        execute_op(s->game, &op, &r);
+        format_result(&r, &s->out, &s->out);
+        return;
+    }
+
+    if (!end_first_line(&s->lp, eol, &s->line, &p, &s->out))
+        return;
+
+    /* Serwer nie ma trybu interaktywnego */
+    if (p == B)
+        s->game = gamma_new(s->lp.instructions[0], s->lp.instructions[1],
+                            s->lp.instructions[2], s->lp.instructions[3]);
+
+    if (s->game == NULL) {
+        write_err(&s->out, s->line - 1);
+        parser_init(&s->lp);
+    } else {
+        output_str(&s->out, "OK ");
+        output_uint(&s->out, s->line - 1);
+        output_char(&s->out, '\n');
+    }
+}
+
+
+/* Czy wyniki połączenia czekają na odbiór przez klienta tak długo,
+ * że nie należy wykonywać kolejnych poleceń */
+static inline bool congested(session_t *s) {
+    return s->out.len >= SERVER_OUTPUT_LIMIT;
+}
+
+
+/* Analizuje dane otrzymane od klienta, przerywając po linii, po której
+ * połączenie jest zatkane */
+static void feed(session_t *s) {
+    while (s->in_start < s->in_len && !congested(s)) {
+        const char *data = s->in + s->in_start;
+        size_t len = s->in_len - s->in_start;
+        const char *nl = memchr(data, '\n', len);
+        size_t span = nl != NULL ? (size_t) (nl - data) : len;
+
+        parse_span(&s->lp, data, span);
+        if (nl == NULL) {
+            s->in_start = s->in_len;
+            return;
+        }
+
+        end_line(s, true);
+        s->in_start += span + 1;
+    }
+}
+
+
+/* Obsługuje dane czekające w połączeniu i wysyła tyle wyników, ile klient
+ * przyjmie bez czekania; zwraca false, gdy należy je zamknąć */
+static bool serve(session_t *s) {
+    for (int i = 0; i < SERVER_READS_PER_TURN; i++) {
+        ssize_t n;
+
+        if (!output_drain(&s->out))
+            return false;
+        if (congested(s))
+            break;
+
+        if (s->in_start < s->in_len) {
+            feed(s);
+            continue;
+        }
+        if (s->eof)
+            break;
+
+        n = recv(s->fd, s->in, SERVER_READ_SIZE, 0);
+        if (n > 0) {
+            s->in_start = 0;
+            s->in_len = (size_t) n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (n == 0) {
+            end_line(s, false);
+            s->eof = true;
+        } else {
+            return false;
+        }
+    }
+
+    return output_drain(&s->out);
+}
+
+
+/* Czeka na zgłoszenia o danych w połączeniu lub o miejscu na wyniki */
+static bool watch(session_t *s, int op) {
+    struct epoll_event ev;
+
+    ev.events = EPOLLONESHOT;
+    if (!s->eof && !congested(s))
+        ev.events |= EPOLLIN;
+    if (s->out.len > 0)
+        ev.events |= EPOLLOUT;
+    ev.data.ptr = s;
+
+    return epoll_ctl(epoll_fd, op, s->fd, &ev) == 0;
+}
+
+
+/* Wątek roboczy */
+static void *worker_thread(void *arg) {
+    session_t *s;
+    (void) arg;
+
+    while ((s = queue_pop()) != NULL) {
+        /* EPOLLONESHOT gwarantuje, że połączenie obsługuje jeden wątek */
+        if (!serve(s))
+            session_close(s);
+        else if (s->eof && s->in_start == s->in_len && s->out.len == 0)
+            session_close(s);
+        else if (s->in_start < s->in_len && !congested(s))
+            queue_push(s);
+        else if (!watch(s, EPOLL_CTL_MOD))
+            session_close(s);
+    }
+
+    return NULL;
+}
+
+
+/* Przyjmuje wszystkie oczekujące połączenia */
+static void accept_all(int listen_fd) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;
+        }
+
+        session_t *s = session_new(fd);
+        if (s == NULL) {
+            close(fd);
+        } else if (!watch(s, EPOLL_CTL_ADD)) {
+            session_close(s);
+        }
+    }
+}
+
+
+/* Tworzy nasłuchujące gniazdo pod ścieżką path, -1 jeżeli się nie udało */
+static int open_socket(const char *path) {
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* Usuwamy jedynie gniazdo pozostałe po poprzednim uruchomieniu */
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0
+        || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/* Obsługuje zdarzenia do otrzymania sygnału końca */
+static void event_loop(int listen_fd, const sigset_t *wait_mask) {
+    struct epoll_event events[64];
+
+    while (!stopping) {
+        int n = epoll_pwait(epoll_fd, events, 64, -1, wait_mask);
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL)
+                accept_all(listen_fd);
+            else
+                queue_push(events[i].data.ptr);
+        }
+    }
+}
+
+
+/* Ustawia obsługę sygnałów; sygnały końca są blokowane poza epoll_pwait */
+static void setup_signals(sigset_t *old_mask) {
+    struct sigaction sa;
+    sigset_t block;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    sa.sa_handler = handle_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, old_mask);
+}
+
+
+int run_server(const char *path, uint32_t workers) {
+    struct epoll_event ev;
+    sigset_t wait_mask;
+    pthread_t *threads;
+    uint32_t started = 0;
+    int listen_fd;
+
+    setup_signals(&wait_mask);
+
+    listen_fd = open_socket(path);
+    if (listen_fd < 0)
+        return 1;
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    threads = malloc(workers * sizeof(pthread_t));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+
+    if (epoll_fd >= 0 && threads != NULL
+        && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) == 0) {
+        while (started < workers
+               && pthread_create(&threads[started], NULL,
+                                 worker_thread, NULL) == 0)
+            started++;
+    }
+
+    if (started > 0)
+        event_loop(listen_fd, &wait_mask);
+
+    queue_close();
+    for (uint32_t i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    while (sessions != NULL)
+        session_close(sessions);
+
+    free(threads);
+    if (epoll_fd >= 0)
+        close(epoll_fd);
+    close(listen_fd);
+    unlink(path);
+
+    return started > 0 ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+/** @file
+ * Interfejs serwera gry gamma działającego na gnieździe uniksowym
+ *
+ * Serwer przyjmuje wiele połączeń jednocześnie. Każde połączenie prowadzi
+ * własną rozgrywkę w trybie wsadowym: pierwsza poprawna linia musi być
+ * poleceniem @p B, a kolejne są wykonywane tak jak w @ref run_batch_mode.
+ * Wyniki i komunikaty o błędach trafiają z powrotem do tego samego
+ * połączenia. Po zamknięciu przez klienta strony zapisu serwer wypisuje
+ * pozostałe wyniki i zamyka połączenie.
+ *
+ * Gniazda obsługuje jedna pętla epoll(7), która przekazuje połączenia
+ * z danymi do puli wątków roboczych. Gniazda połączeń są nieblokujące:
+ * wyniki, których klient jeszcze nie odebrał, czekają w pamięci połączenia,
+ * a gdy jest ich więcej niż @ref SERVER_OUTPUT_LIMIT bajtów, serwer
+ * wstrzymuje wykonywanie poleceń tego klienta do czasu ich odebrania.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_SERVER_H
+#define GAMMA_SERVER_H
+
+#include <stdint.h>
+
+
+/**
+ * Rozmiar bufora, do którego czytane są dane z jednego połączenia.
+ */
+#define SERVER_READ_SIZE (1 << 16)
+
+
+/**
+ * Maksymalna liczba odczytów z połączenia w jednej turze wątku roboczego.
+ * Ogranicza czas, przez jaki jeden klient zajmuje wątek.
+ */
+#define SERVER_READS_PER_TURN 16
+
+
+/**
+ * Liczba bajtów wyników czekających na odebranie przez klienta, po której
+ * serwer przestaje wykonywać jego polecenia.
+ */
+#define SERVER_OUTPUT_LIMIT (1 << 20)
+
+
+/** @brief Uruchamia serwer gry gamma.
+ * Działa do otrzymania sygnału @p SIGINT lub @p SIGTERM, po czym zamyka
+ * wszystkie połączenia i usuwa plik gniazda.
+ * @param[in] path    – ścieżka gniazda uniksowego,
+ * @param[in] workers – liczba wątków roboczych, liczba dodatnia.
+ * @return Zero jeżeli serwer zakończył działanie pomyślnie, jeden jeżeli nie
+ * udało się go uruchomić.
+ */
+int run_server(const char *path, uint32_t workers);
+
+
+#endif /* GAMMA_SERVER_H */
@@ -0,0 +1,746 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "solver.h"
+
+
+/* Wartość większa od każdego wyniku */
+#define VALUE_INF 127
+
+/* Rodzaje wpisów tablicy transpozycji */
+#define TT_EXACT 0
+#define TT_LOWER 1
+#define TT_UPPER 2
+
+/* Bit odróżniający zapisany wpis od pustego */
+#define TT_VALID (1u << 16)
+
+/* Wyniki zdejmowania zadań z kolejki */
+#define NO_TASK UINT32_MAX
+#define STEAL_ABORT (UINT32_MAX - 1)
+
+/* Brak rodzica w drzewie zadań */
+#define NO_PARENT UINT32_MAX
+
+/* Maksymalna liczba ruchów w pozycji: zwykłe i złote */
+#define MAX_MOVES (2 * SOLVER_MAX_FIELDS)
+
+
+/* Pozycja w trakcie przeszukiwania */
+typedef struct state {
+    uint64_t owned[2]; /* pola graczy */
+    uint32_t areas[2]; /* liczby obszarów graczy */
+    bool used[2]; /* czy gracze wykonali złoty ruch */
+    uint32_t side; /* gracz wykonujący ruch, 0 lub 1 */
+    uint64_t key; /* skrót Zobrista pozycji */
+} state_t;
+
+
+/* Ruch */
+typedef struct move {
+    uint32_t field; /* numer pola */
+    bool golden; /* czy to złoty ruch */
+} move_t;
+
+
+/* Wpis tablicy transpozycji; check to klucz xor data, więc wpis
+ * rozerwany przez równoległy zapis nie przejdzie sprawdzenia */
+typedef struct tt_entry {
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} tt_entry_t;
+
+
+/* Kolejka zadań Chase'a-Lev: właściciel zdejmuje z dołu, pozostałe
+ * wątki kradną z góry */
+typedef struct deque {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    _Atomic uint32_t *tasks;
+    int64_t cap;
+} deque_t;
+
+
+/* Węzeł drzewa pierwszych posunięć */
+typedef struct split_node {
+    state_t st; /* pozycja w węźle */
+    move_t move; /* ruch prowadzący do węzła */
+    bool pass; /* czy węzeł powstał przez utratę kolejki */
+    bool solved; /* czy wartość jest znana bez przeszukiwania */
+    uint32_t first_child; /* indeks pierwszego dziecka */
+    uint32_t children; /* liczba dzieci */
+    int32_t value; /* wynik gracza wykonującego ruch w węźle */
+} split_node_t;
+
+
+/* Wątek przeszukujący */
+typedef struct worker {
+    uint32_t id; /* numer wątku i jego kolejki */
+    uint64_t nodes; /* liczba odwiedzonych pozycji */
+    pthread_t thread;
+} worker_t;
+
+
+/* Geometria planszy */
+
+static uint32_t width, fields, max_areas;
+static uint64_t full; /* maska wszystkich pól */
+static uint64_t not_left; /* pola spoza pierwszej kolumny */
+static uint64_t not_right; /* pola spoza ostatniej kolumny */
+
+/* Klucze Zobrista */
+
+static uint64_t field_keys[2][SOLVER_MAX_FIELDS];
+static uint64_t golden_keys[2];
+static uint64_t side_key;
+
+/* Stan rozwiązywania */
+
+static tt_entry_t *tt = NULL;
+static split_node_t *split = NULL;
+static uint32_t split_count, split_cap;
+static deque_t *deques = NULL;
+static uint32_t workers_count;
+
+
+/* Procedury pomocnicze */
+
+static inline uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+
+static inline uint32_t popcount(uint64_t m) {
+    return (uint32_t) __builtin_popcountll(m);
+}
+
+
+static inline uint32_t lowest(uint64_t m) {
+    return (uint32_t) __builtin_ctzll(m);
+}
+
+
+/* Pola sąsiadujące z polami maski m */
+static inline uint64_t neighbours(uint64_t m) {
+    uint64_t up = width < 64 ? m << width : 0;
+    uint64_t down = width < 64 ? m >> width : 0;
+
+    return (((m & not_right) << 1) | ((m & not_left) >> 1) | up | down)
+           & full;
+}
+
+
+/* Liczy spójne składowe maski m; przerywa, gdy jest ich więcej niż limit */
+static uint32_t components(uint64_t m, uint32_t limit) {
+    uint32_t count = 0;
+
+    while (m != 0 && count <= limit) {
+        uint64_t area = m & (~m + 1), prev;
+
+        do {
+            prev = area;
+            area = (area | neighbours(area)) & m;
+        } while (area != prev);
+
+        m &= ~area;
+        count++;
+    }
+
+    return count;
+}
+
+
+/* Ustala geometrię planszy i klucze Zobrista */
+static void setup(const solver_position_t *pos) {
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+    width = pos->width;
+    fields = pos->width * pos->height;
+    max_areas = pos->areas < fields ? pos->areas : fields;
+    full = fields == 64 ? UINT64_MAX : (1ULL << fields) - 1;
+    not_left = not_right = full;
+
+    for (uint32_t y = 0; y < pos->height; y++) {
+        not_left &= ~(1ULL << (y * width));
+        not_right &= ~(1ULL << (y * width + width - 1));
+    }
+
+    for (int s = 0; s < 2; s++) {
+        for (uint32_t f = 0; f < SOLVER_MAX_FIELDS; f++)
+            field_keys[s][f] = mix(seed += 0x9e3779b97f4a7c15ULL);
+        golden_keys[s] = mix(seed += 0x9e3779b97f4a7c15ULL);
+    }
+    side_key = mix(seed + 0x9e3779b97f4a7c15ULL);
+}
+
+
+/* Tworzy stan przeszukiwania z pozycji */
+static void initial_state(const solver_position_t *pos, state_t *st) {
+    st->key = 0;
+    st->side = pos->to_move - 1;
+    if (st->side == 1)
+        st->key ^= side_key;
+
+    for (int s = 0; s < 2; s++) {
+        st->owned[s] = pos->owned[s];
+        st->areas[s] = components(pos->owned[s], SOLVER_MAX_FIELDS);
+        st->used[s] = pos->golden_used[s];
+        if (st->used[s])
+            st->key ^= golden_keys[s];
+        for (uint64_t m = st->owned[s]; m != 0; m &= m - 1)
+            st->key ^= field_keys[s][lowest(m)];
+    }
+}
+
+
+/* Zapisuje ruchy gracza wykonującego ruch; najpierw te przy jego polach.
+ * Jeżeli moves to NULL, sprawdza jedynie, czy jakiś ruch istnieje.
+ * Zwraca liczbę ruchów */
+static uint32_t generate(const state_t *st, move_t *moves) {
+    uint32_t s = st->side, o = 1 - s, n = 0;
+    uint64_t mine = st->owned[s], theirs = st->owned[o];
+    uint64_t near = neighbours(mine);
+    uint64_t free = full & ~(mine | theirs);
+    bool new_area = st->areas[s] < max_areas;
+    uint64_t targets = new_area ? free : free & near;
+
+    if (moves == NULL && targets != 0)
+        return 1;
+
+    for (uint64_t m = targets & near; m != 0; m &= m - 1)
+        moves[n++] = (move_t) {lowest(m), false};
+    for (uint64_t m = targets & ~near; m != 0; m &= m - 1)
+        moves[n++] = (move_t) {lowest(m), false};
+
+    if (st->used[s])
+        return n;
+
+    /* Zabranie pola dzieli obszar na co najwyżej cztery części */
+    for (uint64_t m = new_area ? theirs : theirs & near; m != 0; m &= m - 1) {
+        uint32_t f = lowest(m);
+
+        if (st->areas[o] + 3 <= max_areas
+            || components(theirs & ~(1ULL << f), max_areas) <= max_areas) {
+            if (moves == NULL)
+                return 1;
+            moves[n++] = (move_t) {f, true};
+        }
+    }
+
+    return n;
+}
+
+
+/* Wykonuje ruch i przekazuje kolejkę przeciwnikowi */
+static void apply(state_t *st, move_t mv) {
+    uint32_t s = st->side, o = 1 - s;
+    uint64_t bit = 1ULL << mv.field;
+    bool joins = (neighbours(st->owned[s]) & bit) != 0;
+
+    if (mv.golden) {
+        st->owned[o] &= ~bit;
+        st->areas[o] = components(st->owned[o], SOLVER_MAX_FIELDS);
+        st->key ^= field_keys[o][mv.field] ^ golden_keys[s];
+        st->used[s] = true;
+    }
+
+    st->owned[s] |= bit;
+    st->key ^= field_keys[s][mv.field];
+    if (joins)
+        st->areas[s] = components(st->owned[s], SOLVER_MAX_FIELDS);
+    else
+        st->areas[s]++;
+
+    st->side = o;
+    st->key ^= side_key;
+}
+
+
+/* Przekazuje kolejkę bez ruchu */
+static inline void pass(state_t *st) {
+    st->side = 1 - st->side;
+    st->key ^= side_key;
+}
+
+
+/* Wynik końcowy z punktu widzenia gracza wykonującego ruch */
+static inline int32_t final_value(const state_t *st) {
+    return (int32_t) popcount(st->owned[st->side])
+           - (int32_t) popcount(st->owned[1 - st->side]);
+}
+
+
+/* Tablica transpozycji */
+
+static inline tt_entry_t *tt_entry(uint64_t key) {
+    return &tt[key >> (64 - SOLVER_TT_BITS)];
+}
+
+
+static bool tt_probe(uint64_t key, int32_t *value, uint32_t *flag) {
+    tt_entry_t *e = tt_entry(key);
+    uint64_t data = atomic_load_explicit(&e->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&e->check, memory_order_relaxed);
+
+    if ((check ^ data) != key || !(data & TT_VALID))
+        return false;
+
+    *value = (int32_t) (data & 0xff) - VALUE_INF;
+    *flag = (uint32_t) (data >> 8) & 0xff;
+
+    return true;
+}
+
+
+static void tt_store(uint64_t key, int32_t value, uint32_t flag) {
+    tt_entry_t *e = tt_entry(key);
+    uint64_t data = (uint64_t) (value + VALUE_INF) | (uint64_t) flag << 8
+                    | TT_VALID;
+
+    atomic_store_explicit(&e->data, data, memory_order_relaxed);
+    atomic_store_explicit(&e->check, key ^ data, memory_order_relaxed);
+}
+
+
+/* Alfa-beta: wynik gracza wykonującego ruch w st, z cofaniem ruchów */
+static int32_t search(worker_t *w, state_t *st, int32_t alpha, int32_t beta) {
+    move_t moves[MAX_MOVES];
+    int32_t alpha0 = alpha, best = -VALUE_INF, value;
+    uint32_t flag, n;
+
+    w->nodes++;
+
+    if (tt_probe(st->key, &value, &flag)) {
+        if (flag == TT_EXACT)
+            return value;
+        else if (flag == TT_LOWER && value > alpha)
+            alpha = value;
+        else if (flag == TT_UPPER && value < beta)
+            beta = value;
+
+        if (alpha >= beta)
+            return value;
+    }
+
+    n = generate(st, moves);
+
+    if (n == 0) {
+        pass(st);
+        if (generate(st, NULL) == 0)
+            best = -final_value(st);
+        else
+            best = -search(w, st, -beta, -alpha);
+        pass(st);
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        state_t undo = *st;
+
+        apply(st, moves[i]);
+        value = -search(w, st, -beta, -alpha);
+        *st = undo;
+
+        if (value > best) {
+            best = value;
+            if (best > alpha)
+                alpha = best;
+            if (alpha >= beta)
+                break;
+        }
+    }
+
+    if (best <= alpha0)
+        flag = TT_UPPER;
+    else if (best >= beta)
+        flag = TT_LOWER;
+    else
+        flag = TT_EXACT;
+    tt_store(st->key, best, flag);
+
+    return best;
+}
+
+
+/* Kolejka zadań */
+
+static bool deque_init(deque_t *d, int64_t cap) {
+    d->tasks = malloc((size_t) cap * sizeof(_Atomic uint32_t));
+    d->cap = cap;
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+
+    return d->tasks != NULL;
+}
+
+
+/* Dodaje zadanie na dół kolejki; wywołuje jedynie właściciel */
+static void deque_push(deque_t *d, uint32_t task) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+
+    atomic_store_explicit(&d->tasks[b % d->cap], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+
+/* Zdejmuje zadanie z dołu kolejki; wywołuje jedynie właściciel */
+static uint32_t deque_pop(deque_t *d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    int64_t t;
+    uint32_t task = NO_TASK;
+
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t <= b) {
+        task = atomic_load_explicit(&d->tasks[b % d->cap],
+                                    memory_order_relaxed);
+        if (t == b) {
+            /* Ostatnie zadanie: wyścig z kradnącymi */
+            if (!atomic_compare_exchange_strong_explicit(
+                    &d->top, &t, t + 1, memory_order_seq_cst,
+                    memory_order_relaxed))
+                task = NO_TASK;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+
+/* Kradnie zadanie z góry kolejki */
+static uint32_t deque_steal(deque_t *d) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    int64_t b;
+    uint32_t task;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b)
+        return NO_TASK;
+
+    task = atomic_load_explicit(&d->tasks[t % d->cap], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return STEAL_ABORT;
+
+    return task;
+}
+
+
+/* Bierze kolejne zadanie: najpierw z własnej kolejki, potem z cudzych.
+ * Zadania nie przybywają, więc puste kolejki oznaczają koniec pracy */
+static uint32_t next_task(worker_t *w) {
+    uint32_t task = deque_pop(&deques[w->id]);
+    bool retry = true;
+
+    while (task == NO_TASK && retry) {
+        retry = false;
+        for (uint32_t i = 1; i < workers_count && task == NO_TASK; i++) {
+            task = deque_steal(&deques[(w->id + i) % workers_count]);
+            if (task == STEAL_ABORT) {
+                task = NO_TASK;
+                retry = true;
+            }
+        }
+    }
+
+    return task;
+}
+
+
+static void *worker_thread(void *arg) {
+    worker_t *w = arg;
+    uint32_t task;
+
+    while ((task = next_task(w)) != NO_TASK) {
+        state_t st = split[task].st;
+        split[task].value = search(w, &st, -VALUE_INF, VALUE_INF);
+    }
+
+    return NULL;
+}
+
+
+/* Drzewo pierwszych posunięć */
+
+static bool add_split_node(const state_t *st, move_t mv, bool passed) {
+    if (split_count == split_cap) {
+        split_node_t *bigger = realloc(split, 2 * split_cap
+                                              * sizeof(split_node_t));
+        if (bigger == NULL)
+            return false;
+        split = bigger;
+        split_cap *= 2;
+    }
+
+    split[split_count] = (split_node_t) {*st, mv, passed, false, 0, 0, 0};
+    split_count++;
+
+    return true;
+}
+
+
+/* Dodaje dzieci węzła; węzeł bez ruchów obu graczy od razu rozwiązuje */
+static bool expand(uint32_t i) {
+    move_t moves[MAX_MOVES];
+    state_t st = split[i].st;
+    uint32_t n = generate(&st, moves);
+
+    split[i].first_child = split_count;
+
+    if (n == 0) {
+        pass(&st);
+        if (generate(&st, NULL) == 0) {
+            split[i].solved = true;
+            split[i].value = final_value(&split[i].st);
+            return true;
+        }
+        split[i].children = 1;
+        return add_split_node(&st, (move_t) {0, false}, true);
+    }
+
+    split[i].children = n;
+    for (uint32_t k = 0; k < n; k++) {
+        state_t child = st;
+        apply(&child, moves[k]);
+        if (!add_split_node(&child, moves[k], false))
+            return false;
+    }
+
+    return true;
+}
+
+
+/* Rozwija drzewo, dopóki zadań jest za mało */
+static bool build_split_tree(const state_t *root) {
+    uint32_t begin = 0, end;
+
+    split_cap = 64;
+    split_count = 0;
+    split = malloc(split_cap * sizeof(split_node_t));
+    if (split == NULL || !add_split_node(root, (move_t) {0, false}, false))
+        return false;
+
+    for (uint32_t depth = 0; depth < SOLVER_SPLIT_DEPTH
+         && split_count - begin < SOLVER_TASKS_PER_THREAD * workers_count;
+         depth++) {
+        end = split_count;
+        for (uint32_t i = begin; i < end; i++) {
+            if (!expand(i))
+                return false;
+        }
+        begin = end;
+    }
+
+    return true;
+}
+
+
+/* Rozdziela liście drzewa między kolejki i przeszukuje je równolegle */
+static bool solve_leaves(worker_t *workers) {
+    uint32_t started = 0;
+    uint32_t next = 0;
+    int64_t cap = split_count / workers_count + 1;
+
+    deques = calloc(workers_count, sizeof(deque_t));
+    if (deques == NULL)
+        return false;
+
+    for (uint32_t i = 0; i < workers_count; i++) {
+        if (!deque_init(&deques[i], cap))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < split_count; i++) {
+        if (split[i].children == 0 && !split[i].solved) {
+            deque_push(&deques[next], i);
+            next = (next + 1) % workers_count;
+        }
+    }
+
+    for (uint32_t i = 0; i < workers_count; i++) {
+        workers[i].id = i;
+        workers[i].nodes = 0;
+    }
+
+    for (uint32_t i = 1; i < workers_count; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_thread,
+                           &workers[i]) != 0)
+            break;
+        started++;
+    }
+
+    /* Wątek wywołujący pracuje jako pierwszy z wątków */
+    worker_thread(&workers[0]);
+
+    for (uint32_t i = 1; i <= started; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    return true;
+}
+
+
+/* Wylicza wartości węzłów wewnętrznych z wartości liści */
+static void combine(void) {
+    for (uint32_t i = split_count; i-- > 0;) {
+        split_node_t *node = &split[i];
+
+        if (node->children == 0)
+            continue;
+
+        node->value = -VALUE_INF;
+        for (uint32_t k = 0; k < node->children; k++) {
+            int32_t value = -split[node->first_child + k].value;
+            if (value > node->value)
+                node->value = value;
+        }
+    }
+}
+
+
+/* Rozgrywa jedną z optymalnych partii i zapisuje liczby pól graczy */
+static void play_out(worker_t *w, state_t st, int32_t value,
+                     solver_result_t *result) {
+    move_t moves[MAX_MOVES];
+    uint32_t n;
+
+    for (;;) {
+        n = generate(&st, moves);
+        if (n == 0) {
+            pass(&st);
+            if (generate(&st, NULL) == 0)
+                break;
+            value = -value;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            state_t child = st;
+
+            apply(&child, moves[i]);
+            if (-search(w, &child, -VALUE_INF, VALUE_INF) == value) {
+                st = child;
+                value = -value;
+                break;
+            }
+        }
+    }
+
+    result->score[0] = popcount(st.owned[0]);
+    result->score[1] = popcount(st.owned[1]);
+}
+
+
+/* Zwalnia pamięć rozwiązywania */
+static void cleanup(void) {
+    if (deques != NULL) {
+        for (uint32_t i = 0; i < workers_count; i++)
+            free(deques[i].tasks);
+    }
+
+    free(deques);
+    free(split);
+    free(tt);
+    deques = NULL;
+    split = NULL;
+    tt = NULL;
+}
+
+
+bool solver_position(gamma_t *g, uint32_t width0, uint32_t height0,
+                     uint32_t areas, uint32_t to_move, solver_position_t *pos) {
+    if (g == NULL || width0 == 0 || height0 == 0 || areas == 0
+        || (uint64_t) width0 * height0 > SOLVER_MAX_FIELDS
+        || (to_move != 1 && to_move != 2))
+        return false;
+
+    pos->width = width0;
+    pos->height = height0;
+    pos->areas = areas;
+    pos->to_move = to_move;
+    pos->owned[0] = pos->owned[1] = 0;
+
+    for (uint32_t y = 0; y < height0; y++) {
+        for (uint32_t x = 0; x < width0; x++) {
+            uint32_t owner = gamma_whose_field(g, x, y);
+
+            if (owner > 2)
+                return false;
+            if (owner != 0)
+                pos->owned[owner - 1] |= 1ULL << (y * width0 + x);
+        }
+    }
+
+    pos->golden_used[0] = gamma_golden_used(g, 1);
+    pos->golden_used[1] = gamma_golden_used(g, 2);
+
+    return true;
+}
+
+
+bool solver_solve(const solver_position_t *pos, uint32_t threads,
+                  solver_result_t *result) {
+    worker_t *workers;
+    state_t root;
+    bool ok;
+
+    if (pos == NULL || result == NULL || threads == 0 || pos->width == 0
+        || pos->height == 0 || pos->areas == 0
+        || (uint64_t) pos->width * pos->height > SOLVER_MAX_FIELDS
+        || (pos->to_move != 1 && pos->to_move != 2)
+        || (pos->owned[0] & pos->owned[1]) != 0)
+        return false;
+
+    setup(pos);
+    if (((pos->owned[0] | pos->owned[1]) & ~full) != 0)
+        return false;
+
+    initial_state(pos, &root);
+    workers_count = threads;
+    workers = malloc(threads * sizeof(worker_t));
+    tt = calloc((size_t) 1 << SOLVER_TT_BITS, sizeof(tt_entry_t));
+
+    ok = workers != NULL && tt != NULL && build_split_tree(&root)
+         && solve_leaves(workers);
+
+    if (ok) {
+        combine();
+
+        result->value = split[0].value;
+        result->has_move = split[0].children > 0 && !split[1].pass;
+        result->x = result->y = 0;
+        result->golden = false;
+
+        for (uint32_t k = 0; k < split[0].children && result->has_move; k++) {
+            const split_node_t *child = &split[split[0].first_child + k];
+
+            if (-child->value == result->value) {
+                result->x = child->move.field % pos->width;
+                result->y = child->move.field / pos->width;
+                result->golden = child->move.golden;
+                break;
+            }
+        }
+
+        play_out(&workers[0], root, result->value, result);
+
+        result->nodes = 0;
+        for (uint32_t i = 0; i < threads; i++)
+            result->nodes += workers[i].nodes;
+    }
+
+    free(workers);
+    cleanup();
+
+    return ok;
+}
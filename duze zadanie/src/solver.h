@@ -0,0 +1,114 @@
+/** @file
+ * Interfejs dokładnego rozwiązywania końcówek gry gamma dla dwóch graczy
+ *
+ * Solver przegląda całe drzewo gry algorytmem alfa-beta i podaje wynik
+ * przy optymalnej grze obu stron. Pozycję przechowuje w maskach bitowych,
+ * więc plansza może mieć co najwyżej @ref SOLVER_MAX_FIELDS pól, ale czas
+ * rośnie wykładniczo z liczbą wolnych pól: w praktyce rozwiązywane są
+ * plansze do kilkunastu wolnych pól.
+ *
+ * Gracz, który nie ma żadnego ruchu, traci kolejkę. Gra kończy się, gdy
+ * żaden z graczy nie ma ruchu. Wynikiem jest różnica liczby pól gracza
+ * wykonującego ruch i jego przeciwnika.
+ *
+ * Ruchy są wykonywane i cofane w miejscu. Pozycje są zapamiętywane
+ * we wspólnej tablicy transpozycji indeksowanej skrótem Zobrista.
+ * Poddrzewa z kilku pierwszych posunięć są zadaniami rozdzielanymi między
+ * wątki. Każdy wątek ma własną kolejkę zadań, a po jej opróżnieniu kradnie
+ * zadania z kolejek innych wątków.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+#ifndef GAMMA_SOLVER_H
+#define GAMMA_SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamma.h"
+
+
+/**
+ * Maksymalna liczba pól planszy.
+ */
+#define SOLVER_MAX_FIELDS 64
+
+
+/**
+ * Logarytm dwójkowy liczby wpisów tablicy transpozycji.
+ */
+#define SOLVER_TT_BITS 20
+
+
+/**
+ * Docelowa liczba zadań na jeden wątek.
+ */
+#define SOLVER_TASKS_PER_THREAD 16
+
+
+/**
+ * Maksymalna liczba posunięć rozdzielanych na zadania.
+ */
+#define SOLVER_SPLIT_DEPTH 3
+
+
+/**
+ * Pozycja w grze dwóch graczy.
+ */
+typedef struct solver_position {
+    uint32_t width; /**< szerokość planszy */
+    uint32_t height; /**< wysokość planszy */
+    uint32_t areas; /**< maksymalna liczba obszarów gracza */
+    uint64_t owned[2]; /**< pola graczy 1 i 2, bit numer y * width + x */
+    bool golden_used[2]; /**< czy gracze 1 i 2 wykonali złoty ruch */
+    uint32_t to_move; /**< gracz wykonujący ruch, 1 lub 2 */
+} solver_position_t;
+
+
+/**
+ * Wynik rozwiązania pozycji.
+ */
+typedef struct solver_result {
+    int32_t value; /**< wynik gracza wykonującego ruch minus wynik
+                        przeciwnika przy optymalnej grze */
+    bool has_move; /**< czy gracz wykonujący ruch ma jakiś ruch */
+    uint32_t x; /**< odcięta pola pierwszego optymalnego ruchu */
+    uint32_t y; /**< rzędna pola pierwszego optymalnego ruchu */
+    bool golden; /**< czy pierwszy optymalny ruch jest złotym ruchem */
+    uint32_t score[2]; /**< pola graczy 1 i 2 na końcu optymalnej gry */
+    uint64_t nodes; /**< liczba odwiedzonych pozycji */
+} solver_result_t;
+
+
+/** @brief Odczytuje pozycję z gry.
+ * @param[in] g        – wskaźnik na strukturę przechowującą stan gry
+ *                       dwóch graczy,
+ * @param[in] width    – szerokość planszy,
+ * @param[in] height   – wysokość planszy,
+ * @param[in] areas    – maksymalna liczba obszarów gracza,
+ * @param[in] to_move  – gracz wykonujący ruch, 1 lub 2,
+ * @param[out] pos     – odczytana pozycja.
+ * @return Wartość @p true, jeżeli plansza ma co najwyżej
+ * @ref SOLVER_MAX_FIELDS pól i parametry są poprawne, @p false
+ * w przeciwnym przypadku.
+ */
+bool solver_position(gamma_t *g, uint32_t width, uint32_t height,
+                     uint32_t areas, uint32_t to_move, solver_position_t *pos);
+
+
+/** @brief Rozwiązuje pozycję.
+ * Wyznacza wynik przy optymalnej grze, pierwszy optymalny ruch i liczby
+ * pól graczy na końcu jednej z optymalnych rozgrywek.
+ * @param[in] pos      – rozwiązywana pozycja,
+ * @param[in] threads  – liczba wątków, liczba dodatnia,
+ * @param[out] result  – wynik.
+ * @return Wartość @p true, jeżeli pozycja jest poprawna i udało się
+ * zaalokować pamięć, @p false w przeciwnym przypadku.
+ */
+bool solver_solve(const solver_position_t *pos, uint32_t threads,
+                  solver_result_t *result);
+
+
+#endif /* GAMMA_SOLVER_H */
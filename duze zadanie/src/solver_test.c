@@ -0,0 +1,249 @@
+/** @file
+ * Porównanie solvera z pełnym przeszukiwaniem przez silnik gry
+ *
+ * Dla losowych pozycji na małych planszach wynik solvera musi być równy
+ * wynikowi przeszukiwania całego drzewa gry prostą implementacją zasad,
+ * niezależnie od liczby wątków.
+ *
+ * @author Bartłomiej Kozaryna <bk______@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 19.10.2026
+ */
+
+// CMake w wersji release wyłącza asercje.
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include "gamma.h"
+#include "solver.h"
+
+
+/**
+ * Pozycja w grze dwóch graczy przechowywana wprost.
+ */
+typedef struct reference {
+    uint32_t width; /**< szerokość planszy */
+    uint32_t height; /**< wysokość planszy */
+    uint32_t areas; /**< maksymalna liczba obszarów gracza */
+    uint32_t owner[SOLVER_MAX_FIELDS]; /**< właściciele pól, 0 gdy wolne */
+    bool golden_used[2]; /**< czy gracze wykonali złoty ruch */
+} reference_t;
+
+
+/** @brief Oznacza obszar gracza zawierający pole.
+ * @param[in] r        – wskaźnik na pozycję,
+ * @param[in] f        – numer pola,
+ * @param[in,out] seen – pola już odwiedzone.
+ */
+static void flood(const reference_t *r, uint32_t f, bool *seen) {
+    uint32_t x = f % r->width, y = f / r->width;
+
+    if (seen[f])
+        return;
+    seen[f] = true;
+
+    if (x > 0 && r->owner[f - 1] == r->owner[f])
+        flood(r, f - 1, seen);
+    if (x + 1 < r->width && r->owner[f + 1] == r->owner[f])
+        flood(r, f + 1, seen);
+    if (y > 0 && r->owner[f - r->width] == r->owner[f])
+        flood(r, f - r->width, seen);
+    if (y + 1 < r->height && r->owner[f + r->width] == r->owner[f])
+        flood(r, f + r->width, seen);
+}
+
+
+/** @brief Liczy obszary gracza.
+ * @param[in] r      – wskaźnik na pozycję,
+ * @param[in] player – numer gracza.
+ * @return Liczba obszarów gracza @p player.
+ */
+static uint32_t count_areas(const reference_t *r, uint32_t player) {
+    bool seen[SOLVER_MAX_FIELDS] = {false};
+    uint32_t areas = 0;
+
+    for (uint32_t f = 0; f < r->width * r->height; f++) {
+        if (r->owner[f] == player && !seen[f]) {
+            flood(r, f, seen);
+            areas++;
+        }
+    }
+
+    return areas;
+}
+
+
+/** @brief Wykonuje ruch zgodnie z zasadami gry.
+ * @param[in,out] r  – wskaźnik na pozycję,
+ * @param[in] player – gracz wykonujący ruch, 1 lub 2,
+ * @param[in] f      – numer pola,
+ * @param[in] golden – czy to złoty ruch.
+ * @return Wartość @p true, jeżeli ruch był poprawny, @p false w przeciwnym
+ * przypadku, wtedy pozycja się nie zmienia.
+ */
+static bool reference_move(reference_t *r, uint32_t player, uint32_t f,
+                           bool golden) {
+    uint32_t other = 3 - player;
+
+    if (golden ? r->owner[f] != other || r->golden_used[player - 1]
+               : r->owner[f] != 0)
+        return false;
+
+    r->owner[f] = player;
+    if (count_areas(r, player) > r->areas
+        || (golden && count_areas(r, other) > r->areas)) {
+        r->owner[f] = golden ? other : 0;
+        return false;
+    }
+
+    if (golden)
+        r->golden_used[player - 1] = true;
+
+    return true;
+}
+
+
+/** @brief Sprawdza, czy gracz ma jakiś ruch.
+ * @param[in] r      – wskaźnik na pozycję,
+ * @param[in] player – numer gracza, 1 lub 2.
+ * @return Wartość @p true, jeżeli gracz ma ruch, @p false w przeciwnym
+ * przypadku.
+ */
+static bool reference_can_move(const reference_t *r, uint32_t player) {
+    for (int golden = 0; golden < 2; golden++) {
+        for (uint32_t f = 0; f < r->width * r->height; f++) {
+            reference_t copy = *r;
+            if (reference_move(&copy, player, f, golden))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+
+/** @brief Przeszukuje całe drzewo gry.
+ * Pozycje są przechowywane niezależnie od silnika i solvera, a obszary
+ * liczone od nowa po każdym ruchu.
+ * @param[in] r      – wskaźnik na pozycję,
+ * @param[in] player – gracz wykonujący ruch, 1 lub 2.
+ * @return Różnica pól gracza @p player i przeciwnika przy optymalnej grze.
+ */
+static int32_t brute_force(const reference_t *r, uint32_t player) {
+    uint32_t other = 3 - player;
+    int32_t best = -1000, score = 0;
+    bool moved = false;
+
+    for (int golden = 0; golden < 2; golden++) {
+        for (uint32_t f = 0; f < r->width * r->height; f++) {
+            reference_t copy = *r;
+
+            if (reference_move(&copy, player, f, golden)) {
+                int32_t value = -brute_force(&copy, other);
+                if (value > best)
+                    best = value;
+                moved = true;
+            }
+        }
+    }
+
+    if (moved)
+        return best;
+    else if (reference_can_move(r, other))
+        return -brute_force(r, other);
+
+    for (uint32_t f = 0; f < r->width * r->height; f++) {
+        if (r->owner[f] == player)
+            score++;
+        else if (r->owner[f] == other)
+            score--;
+    }
+
+    return score;
+}
+
+
+/** @brief Odczytuje pozycję z gry.
+ * @param[in] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] w   – szerokość planszy,
+ * @param[in] h   – wysokość planszy,
+ * @param[in] a   – maksymalna liczba obszarów gracza,
+ * @param[out] r  – odczytana pozycja.
+ */
+static void reference_of(gamma_t *g, uint32_t w, uint32_t h, uint32_t a,
+                         reference_t *r) {
+    r->width = w;
+    r->height = h;
+    r->areas = a;
+    for (uint32_t f = 0; f < w * h; f++)
+        r->owner[f] = gamma_whose_field(g, f % w, f / w);
+    r->golden_used[0] = gamma_golden_used(g, 1);
+    r->golden_used[1] = gamma_golden_used(g, 2);
+}
+
+
+/** @brief Porównuje solver z pełnym przeszukiwaniem.
+ * @return Zero, gdy wszystkie testy przebiegły poprawnie,
+ * a w przeciwnym przypadku kod zakończenia programu jest kodem błędu.
+ */
+int main() {
+    static const uint32_t sizes[][3] = {
+        {2, 2, 1}, {2, 2, 2}, {3, 2, 1}, {3, 2, 2}, {5, 1, 2},
+        {3, 3, 1}, {3, 3, 2}, {4, 2, 2}, {4, 3, 2},
+    };
+    uint64_t random = 0x9e3779b97f4a7c15ULL;
+    uint32_t positions = 0;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t w = sizes[s][0], h = sizes[s][1], a = sizes[s][2];
+
+        for (int t = 0; t < 6; t++) {
+            gamma_t *g = gamma_new(w, h, 2, a);
+            uint32_t player = 1;
+            /* Większe plansze zaczynamy od kilku ruchów */
+            uint32_t moves = w * h > 8 ? w * h - 7 : (uint32_t) t % 3;
+            solver_position_t pos;
+            solver_result_t one, many;
+            reference_t r;
+            int32_t expected;
+
+            for (uint32_t m = 0; m < moves; m++, player = 3 - player) {
+                random ^= random << 13;
+                random ^= random >> 7;
+                random ^= random << 17;
+                for (uint32_t i = 0; i < w * h; i++) {
+                    uint32_t f = (uint32_t) ((random + i) % (w * h));
+                    if (gamma_move(g, player, f % w, f / w))
+                        break;
+                }
+            }
+
+            reference_of(g, w, h, a, &r);
+            expected = brute_force(&r, player);
+
+            assert(solver_position(g, w, h, a, player, &pos));
+            assert(solver_solve(&pos, 1, &one));
+            assert(solver_solve(&pos, 4, &many));
+            assert(one.value == expected);
+            assert(many.value == expected);
+            assert((int32_t) one.score[player - 1]
+                   - (int32_t) one.score[2 - player] == expected);
+            assert(one.has_move == gamma_can_move(g, player));
+            if (one.has_move) {
+                assert(reference_move(&r, player, one.y * w + one.x,
+                                      one.golden));
+                assert(-brute_force(&r, 3 - player) == expected);
+            }
+
+            gamma_delete(g);
+            positions++;
+        }
+    }
+
+    printf("%u positions solved\n", positions);
+
+    return 0;
+}